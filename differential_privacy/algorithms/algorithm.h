@@ -21,7 +21,10 @@
 #include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "google/protobuf/arena.h"
+#include "differential_privacy/algorithms/column-batch.h"
 #include "differential_privacy/algorithms/confidence-interval.pb.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
 #include "differential_privacy/algorithms/util.h"
@@ -29,6 +32,7 @@
 #include "differential_privacy/proto/summary.pb.h"
 #include "differential_privacy/proto/util.h"
 #include "absl/memory/memory.h"
+#include "absl/types/span.h"
 #include "differential_privacy/base/canonical_errors.h"
 #include "differential_privacy/base/status.h"
 #include "differential_privacy/base/statusor.h"
@@ -38,6 +42,72 @@ namespace differential_privacy {
 constexpr double kDefaultDelta = 0.0;
 constexpr double kDefaultConfidenceLevel = .95;
 
+// Returns a new message allocated on arena, or local if arena is null. Used for
+// temporary messages that are built while writing into a message that may be
+// allocated on an arena.
+template <typename Message>
+Message* ArenaOrLocal(google::protobuf::Arena* arena, Message* local) {
+  if (arena == nullptr) {
+    return local;
+  }
+  return google::protobuf::Arena::CreateMessage<Message>(arena);
+}
+
+// Diagnostics that algorithms add to the error report of their Output. The
+// diagnostics to compute are set with AlgorithmBuilder::SetResultOptions as a
+// bitwise or of these values. All are computed by default.
+enum ResultOptions {
+  kNoResultOptions = 0,
+  // The bounding report of algorithms with automatically determined bounds.
+  kBoundingReport = 1 << 0,
+  // The confidence interval of the noise added to the result.
+  kNoiseConfidenceInterval = 1 << 1,
+  kAllResultOptions = kBoundingReport | kNoiseConfidenceInterval,
+};
+
+template <typename T, class Algorithm, class Builder>
+class AlgorithmBuilder;
+
+// Result of an algorithm with a single numeric output, as returned by the
+// PartialValue methods of such algorithms without constructing an Output. The
+// noise confidence interval is only set if the algorithm provides one for the
+// error report of its Output.
+template <typename V>
+struct NoisyValue {
+  V value = 0;
+  bool has_noise_confidence_interval = false;
+  double noise_lower_bound = 0;
+  double noise_upper_bound = 0;
+  double confidence_level = 0;
+};
+
+// Sets the noise confidence interval of value if interval is ok.
+template <typename V>
+void SetNoiseConfidenceInterval(
+    const base::StatusOr<ConfidenceInterval>& interval, NoisyValue<V>* value) {
+  if (!interval.ok()) {
+    return;
+  }
+  value->has_noise_confidence_interval = true;
+  value->noise_lower_bound = interval.ValueOrDie().lower_bound();
+  value->noise_upper_bound = interval.ValueOrDie().upper_bound();
+  value->confidence_level = interval.ValueOrDie().confidence_level();
+}
+
+// Adds value to output as an element, and its noise confidence interval, if
+// any, to the error report of output.
+template <typename V>
+void AddToOutput(Output* output, const NoisyValue<V>& value) {
+  AddToOutput<V>(output, value.value);
+  if (value.has_noise_confidence_interval) {
+    ConfidenceInterval* interval =
+        output->mutable_error_report()->mutable_noise_confidence_interval();
+    interval->set_lower_bound(value.noise_lower_bound);
+    interval->set_upper_bound(value.noise_upper_bound);
+    interval->set_confidence_level(value.confidence_level);
+  }
+}
+
 // Abstract superclass for differentially private algorithms.
 //
 // Includes a notion of privacy budget in addition to epsilon to allow for
@@ -48,6 +118,13 @@ constexpr double kDefaultConfidenceLevel = .95;
 //   allow 90% to be used at some later point.
 //
 // Generic call to Result consumes 100% of the privacy budget by default.
+//
+// Result, PartialResult and Serialize have overloads that allocate the
+// returned message on a caller-provided google::protobuf::Arena, which owns
+// it. When aggregating many groups, all results and summaries of a batch can
+// then be released at once by resetting the arena. Algorithms implement
+// GenerateResultTo and SerializeTo, which write into a message that may live on
+// an arena; the heap and arena overloads both go through them.
 template <typename T>
 class Algorithm {
  public:
@@ -73,6 +150,33 @@ class Algorithm {
     }
   }
 
+  // Adds an input multiplicity times, e.g. a value of pre-aggregated data and
+  // the number of times it occurred. This is equivalent to calling AddEntry
+  // multiplicity times, so each occurrence counts as a contribution. Nothing is
+  // added if multiplicity is not positive. Algorithms override this to add all
+  // occurrences at once.
+  virtual void AddEntryWithMultiplicity(const T& t, int64_t multiplicity) {
+    for (int64_t i = 0; i < multiplicity; ++i) {
+      AddEntry(t);
+    }
+  }
+
+  // Adds each input of values with the multiplicity at the same index of
+  // multiplicities, which must be of the same size.
+  void AddEntriesWithMultiplicities(absl::Span<const T> values,
+                                    absl::Span<const int64_t> multiplicities) {
+    DCHECK_EQ(values.size(), multiplicities.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      AddEntryWithMultiplicity(values[i], multiplicities[i]);
+    }
+  }
+
+  // Adds the valid entries of a columnar batch. Algorithms override this to
+  // add the entries without a virtual call per entry.
+  virtual void AddColumnBatch(const ColumnBatch<T>& batch) {
+    ForEachValid(batch, [this](const T& t) { AddEntry(t); });
+  }
+
   // Runs the algorithm on the input using the epsilon parameter
   // provided in the constructor and returns output.
   template <typename Iterator>
@@ -92,6 +196,30 @@ class Algorithm {
     return PartialResult(RemainingPrivacyBudget());
   }
 
+  // Arena overloads of the above. The returned Output is owned by the arena.
+  template <typename Iterator>
+  base::StatusOr<Output*> Result(Iterator begin, Iterator end,
+                                 google::protobuf::Arena* arena) {
+    Reset();
+    AddEntries(begin, end);
+    return PartialResult(arena);
+  }
+
+  base::StatusOr<Output*> PartialResult(double privacy_budget,
+                                        google::protobuf::Arena* arena) {
+    Output* output = google::protobuf::Arena::CreateMessage<Output>(arena);
+    base::Status status =
+        GenerateResultTo(ConsumePrivacyBudget(privacy_budget), output);
+    if (!status.ok()) {
+      return status;
+    }
+    return output;
+  }
+
+  base::StatusOr<Output*> PartialResult(google::protobuf::Arena* arena) {
+    return PartialResult(RemainingPrivacyBudget(), arena);
+  }
+
   double RemainingPrivacyBudget() { return privacy_budget_; }
 
   // Strictly reduces privacy budget, so is safe to make public.
@@ -119,7 +247,18 @@ class Algorithm {
   // Serializes summary data of current entries into Summary proto. This allows
   // results from distributed aggregation to be recorded and later merged.
   // Returns empty summary for algorithms for which serialize is unimplemented.
-  virtual Summary Serialize() = 0;
+  Summary Serialize() {
+    Summary summary;
+    SerializeTo(&summary);
+    return summary;
+  }
+
+  // Serializes into a Summary allocated on arena, which owns it.
+  Summary* Serialize(google::protobuf::Arena* arena) {
+    Summary* summary = google::protobuf::Arena::CreateMessage<Summary>(arena);
+    SerializeTo(summary);
+    return summary;
+  }
 
   // Merges serialized summary data into this algorithm. The summary proto must
   // represent data from the same algorithm type with identical parameters. The
@@ -127,6 +266,19 @@ class Algorithm {
   // algorithm used. The summary proto cannot be empty.
   virtual base::Status Merge(const Summary& summary) = 0;
 
+  // Merges all summaries, with the same result as calling Merge on each of
+  // them in order, up to floating point rounding. Algorithms that support it
+  // unpack and add the summaries on up to num_threads threads and combine the
+  // per-thread partials in a tree; these merge nothing if any summary is
+  // invalid. Since the tree adds floating point partials in a different order,
+  // results of double algorithms may differ in the last bits from merging one
+  // by one. Other algorithms call Merge on each summary and stop at the first
+  // error. By default, summaries are merged on the calling thread.
+  base::Status MergeAll(absl::Span<const Summary> summaries,
+                        int num_threads = 1) {
+    return MergeSummaries(summaries, num_threads);
+  }
+
   // Returns the memory currently used by the algorithm in bytes.
   virtual int64_t MemoryUsed() = 0;
 
@@ -152,21 +304,64 @@ class Algorithm {
 
   virtual double GetEpsilon() const { return epsilon_; }
 
+  // Returns the ResultOptions that the algorithm was built with.
+  int result_options() const { return result_options_; }
+
  protected:
+  // Returns whether results should include the diagnostic option.
+  bool ResultIncludes(ResultOptions option) const {
+    return (result_options_ & option) != 0;
+  }
+
   // Return the result of the algorithm when run on all the input that has been
   // provided via AddEntr[y|ies] since the last call to Reset.
   // Apportioning of privacy budget is handled by calls from PartialResult
   // above.
-  virtual base::StatusOr<Output> GenerateResult(double privacy_budget) = 0;
+  base::StatusOr<Output> GenerateResult(double privacy_budget) {
+    Output output;
+    base::Status status = GenerateResultTo(privacy_budget, &output);
+    if (!status.ok()) {
+      return status;
+    }
+    return output;
+  }
+
+  // Writes the result of the algorithm into output, which may be allocated on
+  // an arena. Nested messages should be allocated on the arena of output. Both
+  // PartialResult overloads call this, so it is the only method to override to
+  // change the result.
+  virtual base::Status GenerateResultTo(double privacy_budget,
+                                        Output* output) = 0;
+
+  // Writes the summary of current entries into summary, which may be
+  // allocated on an arena. Temporary and nested messages should be allocated on
+  // the arena of summary. Both Serialize overloads call this.
+  virtual void SerializeTo(Summary* summary) = 0;
+
+  // Merges summaries for MergeAll. By default, calls Merge on each summary.
+  virtual base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                                      int num_threads) {
+    for (const Summary& summary : summaries) {
+      base::Status status = Merge(summary);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return base::OkStatus();
+  }
 
   // Allows child classes to reset their state as part of a global reset.
   virtual void ResetState() = 0;
 
  private:
+  template <typename U, class A, class B>
+  friend class AlgorithmBuilder;
+
   static constexpr double kFullPrivacyBudget = 1.0;
 
   const double epsilon_;
   double privacy_budget_;
+  int result_options_ = kAllResultOptions;
 };
 
 template <typename T, class Algorithm, class Builder>
@@ -180,7 +375,11 @@ class AlgorithmBuilder {
                    << " is being used. Consider setting your own epsilon based "
                       "on privacy considerations.";
     }
-    return BuildAlgorithm();
+    base::StatusOr<std::unique_ptr<Algorithm>> algorithm = BuildAlgorithm();
+    if (algorithm.ok()) {
+      algorithm.ValueOrDie()->result_options_ = result_options_;
+    }
+    return algorithm;
   }
 
   Builder& SetEpsilon(double epsilon) {
@@ -195,6 +394,14 @@ class AlgorithmBuilder {
     return *static_cast<Builder*>(this);
   }
 
+  // Sets the diagnostics that results include in their error report, as a
+  // bitwise or of ResultOptions. Diagnostics that are turned off are not
+  // computed, which saves work when they would be discarded.
+  Builder& SetResultOptions(int result_options) {
+    result_options_ = result_options;
+    return *static_cast<Builder*>(this);
+  }
+
  protected:
   virtual base::StatusOr<std::unique_ptr<Algorithm>> BuildAlgorithm() = 0;
 
@@ -204,6 +411,9 @@ class AlgorithmBuilder {
   double epsilon_ = DefaultEpsilon();
   bool using_default_epsilon_ = true;
 
+  // Bitwise or of the ResultOptions of built algorithms.
+  int result_options_ = kAllResultOptions;
+
   // The mechanism builder is used to interject custom mechanisms for testing.
   std::unique_ptr<LaplaceMechanism::Builder> laplace_mechanism_builder_ =
       absl::make_unique<LaplaceMechanism::Builder>(LaplaceMechanism::Builder());
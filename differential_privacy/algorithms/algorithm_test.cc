@@ -37,15 +37,16 @@ class TestAlgorithm : public Algorithm<T> {
  public:
   TestAlgorithm() : Algorithm<T>(1.0) {}
   void AddEntry(const T& t) override {}
-  Summary Serialize() override { return Summary(); }
+  void SerializeTo(Summary* summary) override {}
   base::Status Merge(const Summary& summary) override {
     return base::OkStatus();
   }
   int64_t MemoryUsed() override { return sizeof(TestAlgorithm<T>); }
 
  protected:
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
-    return Output();
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    return base::OkStatus();
   }
   void ResetState() override {}
 };
@@ -92,6 +93,18 @@ TEST(IncrementalAlgorithmTest, MergedPartialResultConsumesBudget) {
   EXPECT_THAT(alg_2.RemainingPrivacyBudget(), DoubleNear(0.0, kTestPrecision));
 }
 
+TEST(IncrementalAlgorithmTest, ArenaOverloads) {
+  TestAlgorithm<double> alg;
+  Algorithm<double>& base = alg;
+  google::protobuf::Arena arena;
+  Summary* summary = base.Serialize(&arena);
+  EXPECT_EQ(summary->GetArena(), &arena);
+  base::StatusOr<Output*> output = alg.PartialResult(0.5, &arena);
+  ASSERT_OK(output.status());
+  EXPECT_EQ(output.ValueOrDie()->GetArena(), &arena);
+  EXPECT_THAT(alg.RemainingPrivacyBudget(), DoubleNear(0.5, kTestPrecision));
+}
+
 TEST(IncrementalAlgorithmDeathTest, BudgetTooHigh) {
   TestAlgorithm<double> alg;
   alg.PartialResult(0.5).ValueOrDie();
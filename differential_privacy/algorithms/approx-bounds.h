@@ -17,11 +17,14 @@
 #ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_APPROX_BOUNDS_H_
 #define DIFFERENTIAL_PRIVACY_ALGORITHMS_APPROX_BOUNDS_H_
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/repeated_field.h"
 #include "differential_privacy/algorithms/algorithm.h"
+#include "differential_privacy/algorithms/summary-reduction.h"
 #include "differential_privacy/proto/util.h"
 #include "differential_privacy/base/status_macros.h"
 
@@ -187,7 +190,18 @@ class ApproxBounds : public Algorithm<T> {
   };
 
   void AddEntry(const T& input) override {
-    if (std::isnan(input)) {
+    AddEntryWithMultiplicity(input, 1);
+  }
+
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    ForEachValid(batch, [this](const T& input) {
+      ApproxBounds<T>::AddEntryWithMultiplicity(input, 1);
+    });
+  }
+
+  void AddEntryWithMultiplicity(const T& input,
+                                int64_t multiplicity) override {
+    if (std::isnan(input) || multiplicity <= 0) {
       return;
     }
 
@@ -195,19 +209,21 @@ class ApproxBounds : public Algorithm<T> {
     // that MostSignificantBit returns 0 for 0.
     int index = MostSignificantBit(input);
     if (input >= 0) {
-      ++pos_bins_[index];
+      pos_bins_[index] += multiplicity;
     } else {  // value < 0
-      ++neg_bins_[index];
+      neg_bins_[index] += multiplicity;
     }
   }
 
   // Returns an output containing approximate min as the first element and
   // approximate max as the second element. If not enough inputs exist to pass
-  // the threshold, populate the output with an error status.
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
+  // the threshold, populate the output with an error status. Public so that
+  // the bounded algorithms can find their bounds.
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
     DCHECK_GT(privacy_budget, 0.0)
         << "Privacy budget should be greater than zero.";
-    if (privacy_budget == 0.0) return Output();
+    if (privacy_budget == 0.0) return base::OkStatus();
 
     // If k was not user set, scale it by the privacy_budget to ensure the
     // correct probability of success.
@@ -220,19 +236,17 @@ class ApproxBounds : public Algorithm<T> {
     noisy_pos_bins_ = AddNoise(privacy_budget, pos_bins_);
     noisy_neg_bins_ = AddNoise(privacy_budget, neg_bins_);
 
-    Output output;
-
     // Find first bin above threshold for minimum.
     for (int i = neg_bins_.size() - 1; i >= 0; --i) {
       if (noisy_neg_bins_[i] >= threshold) {
-        AddToOutput<T>(&output, NegRightBinBoundary(i));
+        AddToOutput<T>(output, NegRightBinBoundary(i));
         break;
       }
     }
-    if (output.elements_size() == 0) {
+    if (output->elements_size() == 0) {
       for (int i = 0; i < pos_bins_.size(); ++i) {
         if (noisy_pos_bins_[i] >= threshold) {
-          AddToOutput<T>(&output, PosLeftBinBoundary(i));
+          AddToOutput<T>(output, PosLeftBinBoundary(i));
           break;
         }
       }
@@ -241,28 +255,28 @@ class ApproxBounds : public Algorithm<T> {
     // Find first bin above threshold for maximum.
     for (int i = pos_bins_.size() - 1; i >= 0; --i) {
       if (noisy_pos_bins_[i] >= threshold) {
-        AddToOutput<T>(&output, PosRightBinBoundary(i));
+        AddToOutput<T>(output, PosRightBinBoundary(i));
         break;
       }
     }
-    if (output.elements_size() < 2) {
+    if (output->elements_size() < 2) {
       for (int i = 0; i < neg_bins_.size(); ++i) {
         if (noisy_neg_bins_[i] >= threshold) {
-          AddToOutput<T>(&output, NegLeftBinBoundary(i));
+          AddToOutput<T>(output, NegLeftBinBoundary(i));
           break;
         }
       }
     }
 
     // Record error status if approx min or max was not found.
-    if (output.elements_size() < 2) {
+    if (output->elements_size() < 2) {
       return base::InvalidArgumentError(
           "Bin count threshold was too large to find approximate "
           "bounds. Either run over a larger dataset or decrease "
           "success_probability and try again.");
     }
 
-    return output;
+    return base::OkStatus();
   }
 
   void ResetState() override {
@@ -273,13 +287,35 @@ class ApproxBounds : public Algorithm<T> {
   // TODO: Generate confidence interval.
 
   // Serialize the positive and negative bin counts.
-  Summary Serialize() override {
-    ApproxBoundsSummary am_summary;
-    *am_summary.mutable_pos_bin_count() = {pos_bins_.begin(), pos_bins_.end()};
-    *am_summary.mutable_neg_bin_count() = {neg_bins_.begin(), neg_bins_.end()};
-    Summary summary;
-    summary.mutable_data()->PackFrom(am_summary);
-    return summary;
+  void SerializeTo(Summary* summary) override {
+    ApproxBoundsSummary local;
+    ApproxBoundsSummary* am_summary = ArenaOrLocal(summary->GetArena(), &local);
+    SerializeToProto(am_summary);
+    summary->mutable_data()->PackFrom(*am_summary);
+  }
+
+  // Writes the bin counts into am_summary. Used by algorithms that embed the
+  // ApproxBounds summary into their own. Uses the sparse form when fewer than
+  // half of the bins are nonempty, which is typical: inputs of a shard usually
+  // span a few orders of magnitude out of thousands of bins.
+  void SerializeToProto(ApproxBoundsSummary* am_summary) {
+    int64_t num_nonempty =
+        pos_bins_.size() - std::count(pos_bins_.begin(), pos_bins_.end(), 0) +
+        neg_bins_.size() - std::count(neg_bins_.begin(), neg_bins_.end(), 0);
+    if (2 * num_nonempty < pos_bins_.size() + neg_bins_.size()) {
+      am_summary->set_num_bins(pos_bins_.size());
+      SerializeSparseBins(pos_bins_,
+                          am_summary->mutable_pos_bin_index_delta(),
+                          am_summary->mutable_pos_nonempty_bin_count());
+      SerializeSparseBins(neg_bins_,
+                          am_summary->mutable_neg_bin_index_delta(),
+                          am_summary->mutable_neg_nonempty_bin_count());
+      return;
+    }
+    am_summary->mutable_pos_bin_count()->Add(pos_bins_.begin(),
+                                             pos_bins_.end());
+    am_summary->mutable_neg_bin_count()->Add(neg_bins_.begin(),
+                                             neg_bins_.end());
   }
 
   // Retrieve positive and negative bin counts from summary and add them.
@@ -293,22 +329,69 @@ class ApproxBounds : public Algorithm<T> {
       return base::InvalidArgumentError(
           "Approximate bounds summary unable to be unpacked.");
     }
+    return MergeFromProto(am_summary);
+  }
+
+  // Adds the bin counts of am_summary, as written by SerializeToProto.
+  base::Status MergeFromProto(const ApproxBoundsSummary& am_summary) {
+    return AddBinsFromProto(am_summary, &pos_bins_, &neg_bins_);
+  }
 
-    if (pos_bins_.size() != am_summary.pos_bin_count_size() ||
-        neg_bins_.size() != am_summary.neg_bin_count_size()) {
+  // Adds the bin counts of am_summary to pos_bins and neg_bins, which have one
+  // entry per bin. Nothing is added if am_summary has a different number of
+  // bins or is malformed. Used to merge many summaries at once into bins that
+  // are later added with AddBins.
+  static base::Status AddBinsFromProto(const ApproxBoundsSummary& am_summary,
+                                       std::vector<int64_t>* pos_bins,
+                                       std::vector<int64_t>* neg_bins) {
+    if (am_summary.has_num_bins()) {
+      if (am_summary.num_bins() != pos_bins->size()) {
+        return base::InvalidArgumentError(
+            "Merged approximate max summary must have the same number of "
+            "bins as this histogram.");
+      }
+      RETURN_IF_ERROR(ValidateSparseBins(am_summary.pos_bin_index_delta(),
+                                         am_summary.pos_nonempty_bin_count(),
+                                         pos_bins->size()));
+      RETURN_IF_ERROR(ValidateSparseBins(am_summary.neg_bin_index_delta(),
+                                         am_summary.neg_nonempty_bin_count(),
+                                         neg_bins->size()));
+      MergeSparseBins(am_summary.pos_bin_index_delta(),
+                      am_summary.pos_nonempty_bin_count(), pos_bins);
+      MergeSparseBins(am_summary.neg_bin_index_delta(),
+                      am_summary.neg_nonempty_bin_count(), neg_bins);
+      return base::OkStatus();
+    }
+    if (pos_bins->size() != am_summary.pos_bin_count_size() ||
+        neg_bins->size() != am_summary.neg_bin_count_size()) {
       return base::InvalidArgumentError(
           "Merged approximate max summary must have the same number of "
           "bin counts as this histogram.");
     }
 
     // Add bin count from summary to each bin.
-    for (int i = 0; i < pos_bins_.size(); ++i) {
-      pos_bins_[i] += am_summary.pos_bin_count(i);
-      neg_bins_[i] += am_summary.neg_bin_count(i);
+    for (int i = 0; i < pos_bins->size(); ++i) {
+      (*pos_bins)[i] += am_summary.pos_bin_count(i);
+      (*neg_bins)[i] += am_summary.neg_bin_count(i);
     }
     return base::OkStatus();
   }
 
+  // Adds bin counts accumulated by AddBinsFromProto.
+  void AddBins(const std::vector<int64_t>& pos_bins,
+               const std::vector<int64_t>& neg_bins) {
+    AddElementwise(pos_bins, &pos_bins_);
+    AddElementwise(neg_bins, &neg_bins_);
+  }
+
+  // Returns partials with zeroed bins of the size of this histogram.
+  BoundedPartials<T> EmptyPartials() const {
+    BoundedPartials<T> partials;
+    partials.pos_bin_count.assign(pos_bins_.size(), 0);
+    partials.neg_bin_count.assign(neg_bins_.size(), 0);
+    return partials;
+  }
+
   int64_t MemoryUsed() override {
     int64_t memory = sizeof(ApproxBounds<T>) +
                    sizeof(int64_t) * neg_bins_.capacity() +
@@ -368,9 +451,13 @@ class ApproxBounds : public Algorithm<T> {
   // that lie in bins that are included in the bounds. In our case it is bins
   // (0, 1], (1, 2], (2, 4]. So 1 + 1 + 2 = 4. This is the same result if our
   // value 7 was initially clamped between [0, 4].
+  //
+  // The partials of a value that occurs multiplicity times are added at once
+  // by multiplying them.
   template <typename T2>
   void AddToPartials(std::vector<T2>* partials, T value,
-                     std::function<T2(T, T)> make_partial) {
+                     std::function<T2(T, T)> make_partial,
+                     int64_t multiplicity = 1) {
     int msb = MostSignificantBit(value);
 
     // Each bin of the logarithmic histograms in ApproxBounds can be a candidate
@@ -388,7 +475,7 @@ class ApproxBounds : public Algorithm<T> {
       if (i < msb) {
         // For indices below the msb, add the maximum contribution to the
         // partial.
-        (*partials)[i] += partial;
+        (*partials)[i] += partial * multiplicity;
       } else {
         // For i = msb, add the remaining contribution, but not more than the
         // maximum contribution to the partial for this bin. This may occur if
@@ -400,9 +487,9 @@ class ApproxBounds : public Algorithm<T> {
           remainder = make_partial(value, NegLeftBinBoundary(i));
         }
         if (std::abs(partial) < std::abs(remainder)) {
-          (*partials)[msb] += partial;
+          (*partials)[msb] += partial * multiplicity;
         } else {
-          (*partials)[msb] += remainder;
+          (*partials)[msb] += remainder * multiplicity;
         }
       }
     }
@@ -411,8 +498,10 @@ class ApproxBounds : public Algorithm<T> {
   // Break value into its partial sums and store it into the sums vector. A
   // specific use case of AddToPartials used in some algorithms.
   template <typename T2>
-  void AddToPartialSums(std::vector<T2>* sums, T value) {
-    AddToPartials<T2>(sums, value, [](T val1, T val2) { return val1 - val2; });
+  void AddToPartialSums(std::vector<T2>* sums, T value,
+                        int64_t multiplicity = 1) {
+    AddToPartials<T2>(
+        sums, value, [](T val1, T val2) { return val1 - val2; }, multiplicity);
   }
 
   // Given two vectors of partial values, add the partials in the bins between
@@ -522,7 +611,78 @@ class ApproxBounds : public Algorithm<T> {
   // bin for positive bin.
   T PosRightBinBoundary(int bin_index) { return bin_boundaries_[bin_index]; }
 
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    base::StatusOr<BoundedPartials<T>> partials =
+        ReduceSummaries<ApproxBoundsSummary, BoundedPartials<T>>(
+            summaries, EmptyPartials(),
+            [](const ApproxBoundsSummary& am_summary,
+               BoundedPartials<T>* partials) {
+              return AddBinsFromProto(am_summary, &partials->pos_bin_count,
+                                      &partials->neg_bin_count);
+            },
+            [](const BoundedPartials<T>& from, BoundedPartials<T>* to) {
+              to->Add(from);
+            },
+            num_threads);
+    if (!partials.ok()) {
+      return partials.status();
+    }
+    AddBins(partials.ValueOrDie().pos_bin_count,
+            partials.ValueOrDie().neg_bin_count);
+    return base::OkStatus();
+  }
+
  private:
+  // Appends the index deltas and counts of the nonempty bins.
+  static void SerializeSparseBins(
+      const std::vector<int64_t>& bins,
+      google::protobuf::RepeatedField<uint64_t>* index_deltas,
+      google::protobuf::RepeatedField<int64_t>* counts) {
+    int64_t previous = 0;
+    for (int64_t i = 0; i < bins.size(); ++i) {
+      if (bins[i] != 0) {
+        index_deltas->Add(i - previous);
+        counts->Add(bins[i]);
+        previous = i;
+      }
+    }
+  }
+
+  // Returns an error unless the sparse bins have one count per index and all
+  // indices are below num_bins.
+  static base::Status ValidateSparseBins(
+      const google::protobuf::RepeatedField<uint64_t>& index_deltas,
+      const google::protobuf::RepeatedField<int64_t>& counts,
+      uint64_t num_bins) {
+    if (index_deltas.size() != counts.size()) {
+      return base::InvalidArgumentError(
+          "Sparse approximate bounds summary must have one count per bin "
+          "index.");
+    }
+    uint64_t index = 0;
+    for (uint64_t delta : index_deltas) {
+      if (delta >= num_bins - index) {
+        return base::InvalidArgumentError(
+            "Sparse approximate bounds summary bin index is out of range.");
+      }
+      index += delta;
+    }
+    return base::OkStatus();
+  }
+
+  // Adds sparse bin counts, validated by ValidateSparseBins, to bins.
+  static void MergeSparseBins(
+      const google::protobuf::RepeatedField<uint64_t>& index_deltas,
+      const google::protobuf::RepeatedField<int64_t>& counts,
+      std::vector<int64_t>* bins) {
+    uint64_t index = 0;
+    for (int i = 0; i < index_deltas.size(); ++i) {
+      index += index_deltas.Get(i);
+      (*bins)[index] += counts.Get(i);
+    }
+  }
+
   // Add noise to each member of bins and return noisy vector.
   const std::vector<T> AddNoise(double privacy_budget,
                                 const std::vector<int64_t>& bins) {
@@ -55,6 +55,54 @@ TEST(ApproxBoundsTest, BasicTest) {
   EXPECT_EQ(result.elements(1).value().int_value(), 8);
 }
 
+TYPED_TEST(ApproxBoundsTest, AddEntryWithMultiplicityMatchesAddEntry) {
+  typename ApproxBounds<TypeParam>::Builder builder;
+  builder.SetNumBins(4).SetThreshold(3).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<ApproxBounds<TypeParam>> weighted =
+      builder.Build().ValueOrDie();
+  std::unique_ptr<ApproxBounds<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  weighted->AddEntryWithMultiplicity(-5, 3);
+  weighted->AddEntryWithMultiplicity(6, 4);
+  weighted->AddEntryWithMultiplicity(1, 0);
+  for (int i = 0; i < 3; ++i) {
+    expected->AddEntry(-5);
+  }
+  for (int i = 0; i < 4; ++i) {
+    expected->AddEntry(6);
+  }
+  EXPECT_THAT(weighted->Serialize(), EqualsProto(expected->Serialize()));
+  EXPECT_THAT(weighted->PartialResult().ValueOrDie(),
+              EqualsProto(expected->PartialResult().ValueOrDie()));
+}
+
+TYPED_TEST(ApproxBoundsTest, AddColumnBatchMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 7, 2, -5, 0, 8};
+  // Rows 1, 4 and 8 are null.
+  std::vector<uint8_t> validity = {0xed, 0x00};
+  std::vector<int64_t> selection = {6, 4, 6};
+  typename ApproxBounds<TypeParam>::Builder builder;
+  builder.SetNumBins(4).SetThreshold(1).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<ApproxBounds<TypeParam>> batched =
+      builder.Build().ValueOrDie();
+  std::unique_ptr<ApproxBounds<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  ColumnBatch<TypeParam> batch;
+  batch.values = values;
+  batch.validity = validity.data();
+  batched->AddColumnBatch(batch);
+  batch.selection = absl::MakeConstSpan(selection);
+  batched->AddColumnBatch(batch);
+  for (int i : {0, 2, 3, 5, 6, 7, 6, 6}) {
+    expected->AddEntry(values[i]);
+  }
+  EXPECT_THAT(batched->Serialize(), EqualsProto(expected->Serialize()));
+  EXPECT_THAT(batched->PartialResult().ValueOrDie(),
+              EqualsProto(expected->PartialResult().ValueOrDie()));
+}
+
 TYPED_TEST(ApproxBoundsTest, EmptyHistogramTest) {
   std::unique_ptr<ApproxBounds<TypeParam>> bounds =
       typename ApproxBounds<TypeParam>::Builder()
@@ -222,6 +270,72 @@ TYPED_TEST(ApproxBoundsTest, SerializeAndMergeTest) {
             result2.elements(1).value().float_value());
 }
 
+TYPED_TEST(ApproxBoundsTest, SparseSerializeAndMergeTest) {
+  typename ApproxBounds<TypeParam>::Builder builder;
+  builder.SetThreshold(1).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<ApproxBounds<TypeParam>> bounds =
+      builder.Build().ValueOrDie();
+  std::vector<TypeParam> a = {-3, 4, 4, 100};
+  bounds->AddEntries(a.begin(), a.end());
+  Summary summary = bounds->Serialize();
+
+  // Only the three nonempty bins are written.
+  ApproxBoundsSummary am_summary;
+  ASSERT_TRUE(summary.data().UnpackTo(&am_summary));
+  EXPECT_EQ(am_summary.pos_bin_count_size(), 0);
+  EXPECT_EQ(am_summary.num_bins(), bounds->NumPositiveBins());
+  EXPECT_EQ(am_summary.pos_nonempty_bin_count_size(), 2);
+  EXPECT_EQ(am_summary.neg_nonempty_bin_count_size(), 1);
+
+  std::unique_ptr<ApproxBounds<TypeParam>> bounds2 =
+      builder.Build().ValueOrDie();
+  EXPECT_OK(bounds2->Merge(summary));
+  EXPECT_THAT(bounds2->Serialize(), EqualsProto(summary));
+  auto result = bounds->PartialResult().ValueOrDie();
+  auto result2 = bounds2->PartialResult().ValueOrDie();
+  EXPECT_THAT(result2, EqualsProto(result));
+}
+
+TEST(ApproxBoundsTest, InvalidSparseSummary) {
+  std::unique_ptr<ApproxBounds<int64_t>> bounds =
+      ApproxBounds<int64_t>::Builder()
+          .SetNumBins(4)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  ApproxBoundsSummary valid;
+  valid.set_num_bins(4);
+  valid.add_pos_bin_index_delta(1);
+  valid.add_pos_nonempty_bin_count(2);
+  valid.add_pos_bin_index_delta(2);
+  valid.add_pos_nonempty_bin_count(1);
+  Summary summary;
+  summary.mutable_data()->PackFrom(valid);
+  EXPECT_OK(bounds->Merge(summary));
+
+  ApproxBoundsSummary wrong_size = valid;
+  wrong_size.set_num_bins(5);
+  summary.mutable_data()->PackFrom(wrong_size);
+  EXPECT_FALSE(bounds->Merge(summary).ok());
+
+  ApproxBoundsSummary out_of_range = valid;
+  out_of_range.add_pos_bin_index_delta(1);
+  out_of_range.add_pos_nonempty_bin_count(1);
+  summary.mutable_data()->PackFrom(out_of_range);
+  EXPECT_FALSE(bounds->Merge(summary).ok());
+
+  ApproxBoundsSummary missing_count = valid;
+  missing_count.add_neg_bin_index_delta(0);
+  summary.mutable_data()->PackFrom(missing_count);
+  EXPECT_FALSE(bounds->Merge(summary).ok());
+
+  // Failed merges leave the bins unchanged.
+  ApproxBoundsSummary am_summary;
+  ASSERT_TRUE(bounds->Serialize().data().UnpackTo(&am_summary));
+  EXPECT_THAT(am_summary, EqualsProto(valid));
+}
+
 TEST(ApproxBoundsTest, DropNanEntries) {
   std::vector<double> a = {1, 1, 1, NAN};
   std::unique_ptr<ApproxBounds<double>> bounds =
@@ -17,6 +17,9 @@
 #ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_BINARY_SEARCH_H_
 #define DIFFERENTIAL_PRIVACY_ALGORITHMS_BINARY_SEARCH_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "differential_privacy/base/percentile.h"
 #include "google/protobuf/any.pb.h"
 #include "differential_privacy/algorithms/algorithm.h"
@@ -59,7 +62,7 @@
 
 namespace differential_privacy {
 
-// Bayesian search creates a map entry for each iteration. Bound this to prevent
+// Bayesian search creates a bucket for each iteration. Bound this to prevent
 // out of memory exception.
 const size_t kMaxBayesianIterations = 10000;
 
@@ -83,6 +86,9 @@ const double kProbabilityTooCertain = .49;
 // Distance from a singularity for which to use the value at the singularity.
 const double kSingularityTolerance = std::pow(10, -6);
 
+// Number of valid values of a column batch passed to the rank source at once.
+const int64_t kColumnBatchChunkSize = 256;
+
 template <typename T>
 class BinarySearch : public Algorithm<T> {
  public:
@@ -92,21 +98,51 @@ class BinarySearch : public Algorithm<T> {
     }
   }
 
+  // Passes the valid values to the rank source in chunks, with one virtual call
+  // per chunk. Without a validity bitmap or selection, the values are passed
+  // as is.
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    if (!batch.validity && !batch.selection.has_value()) {
+      quantiles_->AddAll(batch.values);
+      return;
+    }
+    T chunk[kColumnBatchChunkSize];
+    int64_t chunk_size = 0;
+    ForEachValid(batch, [this, &chunk, &chunk_size](const T& t) {
+      chunk[chunk_size++] = t;
+      if (chunk_size == kColumnBatchChunkSize) {
+        quantiles_->AddAll(absl::MakeConstSpan(chunk, chunk_size));
+        chunk_size = 0;
+      }
+    });
+    if (chunk_size > 0) {
+      quantiles_->AddAll(absl::MakeConstSpan(chunk, chunk_size));
+    }
+  }
+
   void ResetState() override { quantiles_->Reset(); }
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
     DCHECK_GT(privacy_budget, 0.0)
         << "Privacy budget should be greater than zero.";
-    if (privacy_budget == 0.0) return Output();
-    return BayesianSearch(privacy_budget);
+    if (privacy_budget == 0.0) return base::OkStatus();
+    // Return 95% confidence interval of the error if requested.
+    ConfidenceInterval* error = nullptr;
+    if (Algorithm<T>::ResultIncludes(kNoiseConfidenceInterval)) {
+      error =
+          output->mutable_error_report()->mutable_noise_confidence_interval();
+    }
+    AddToOutput<T>(output, BayesianSearch(privacy_budget, quantile_, error));
+    return base::OkStatus();
   }
 
-  Summary Serialize() override {
-    BinarySearchSummary bs_summary;
-    quantiles_->SerializeToProto(bs_summary.mutable_input());
-    Summary summary;
-    summary.mutable_data()->PackFrom(bs_summary);
-    return summary;
+  void SerializeTo(Summary* summary) override {
+    BinarySearchSummary local;
+    BinarySearchSummary* bs_summary =
+        ArenaOrLocal(summary->GetArena(), &local);
+    quantiles_->SerializeToProto(bs_summary);
+    summary->mutable_data()->PackFrom(*bs_summary);
   }
 
   base::Status Merge(const Summary& summary) override {
@@ -119,9 +155,7 @@ class BinarySearch : public Algorithm<T> {
       return base::InvalidArgumentError(
           "Binary search summary unable to be unpacked.");
     }
-    quantiles_->MergeFromProto(bs_summary.input());
-
-    return base::OkStatus();
+    return quantiles_->MergeFromProto(bs_summary);
   }
 
   int64_t MemoryUsed() override {
@@ -148,23 +182,28 @@ class BinarySearch : public Algorithm<T> {
         mechanism_(std::move(mechanism)),
         quantiles_(std::move(input_sketch)) {}
 
- private:
-  base::StatusOr<Output> BayesianSearch(double privacy_budget) {
+  // Searches for the given quantile of the inputs using privacy_budget, and
+  // returns the result. If error is not null, it receives the 95% confidence
+  // interval of the error. Searches for several quantiles of the same inputs
+  // share the sorted input set.
+  double BayesianSearch(double privacy_budget, double quantile,
+                        ConfidenceInterval* error) {
     // Start the local_budget at a fraction of the total budget.
     double local_budget = privacy_budget * kDefaultLocalBudgetFraction;
     double remaining_budget = privacy_budget;
     double max_local_budget = privacy_budget * kMaxLocalBudgetFraction;
 
-    // Stores probability that the target value is the subrange. Since the map
-    // is sorted, it contains a sequence of key-value pairs (k_i, v_i) for
-    // i = 1, 2, ..., n, where n is the dictionary size. Then for
+    // Stores probability that the target value is the subrange. The buckets
+    // are sorted by lower bound, (k_i, v_i) for i = 1, 2, ..., n. For
     // i = 1, ..., n-1, the subrange [k_i. k_(i+1)) has probability v_i of
     // containing the target value. [k_n, upper_] has probability v_n of
-    // containing the target value.
-    std::map<double, double> weight;
+    // containing the target value. Each iteration inserts one bucket, so
+    // buckets are kept in a contiguous vector rather than a node-based map.
+    std::vector<Bucket> weight;
+    weight.reserve(2 + static_cast<size_t>(1 / kDefaultLocalBudgetFraction));
     double m = lower_ / 2.0 + upper_ / 2.0;
-    weight[lower_] = .5;
-    weight[m] = .5;
+    weight.push_back({static_cast<double>(lower_), .5});
+    weight.push_back({m, .5});
 
     // Keep doing search iterations while we have enough budget left.
     int iterations = 0;
@@ -182,40 +221,32 @@ class BinarySearch : public Algorithm<T> {
 
       // For extreme percentiles, we want to push the result toward the range of
       // the input data.
-      if (quantile_ == 0) {
+      if (quantile == 0) {
         noisy_less -= datapoints_;
-      } else if (quantile_ == 1) {
+      } else if (quantile == 1) {
         noisy_more -= datapoints_;
       }
 
       // Calculate update multipliers.
-      double update_left =
-          BayesianProbabilityLeft(local_budget, noisy_less, noisy_more);
+      double update_left = BayesianProbabilityLeft(local_budget, quantile,
+                                                   noisy_less, noisy_more);
 
       // Adjust the local budget based on certainty.
       remaining_budget -= local_budget;
       local_budget = std::min(UpdateLocalBudget(local_budget, update_left),
                               max_local_budget);
 
-      // Apply update multipliers.
-      UpdateWeight(&weight, m, update_left);
-
-      // Find the subrange to split the bucket and its weight in two.
+      // Apply update multipliers and find the subrange to split the bucket and
+      // its weight in two.
       double sum_w = 0.0;
-      std::map<double, double>::iterator it;
-      for (it = weight.begin(); it != weight.end(); it++) {
-        sum_w += it->second;
-        if (sum_w >= .5) {
-          break;
-        }
-      }
-      double lower_bound = it->first;
-      double w = it->second;
+      size_t i = UpdateWeight(&weight, m, update_left, &sum_w);
+      double lower_bound = weight[i].lower_bound;
+      double w = weight[i].weight;
       double upper_bound = 0;
-      if (++it == weight.end()) {
+      if (i + 1 == weight.size()) {
         upper_bound = static_cast<double>(upper_);
       } else {
-        upper_bound = it->first;
+        upper_bound = weight[i + 1].lower_bound;
       }
 
       // Split the bucket into two assuming uniform distribution of probability
@@ -223,8 +254,16 @@ class BinarySearch : public Algorithm<T> {
       // weight proportional to its length. The bucket starting at the new
       // split-point will get the remaining weight.
       m = (.5 - sum_w + w) / w * (upper_bound - lower_bound) + lower_bound;
-      weight[lower_bound] = w * (m - lower_bound) / (upper_bound - lower_bound);
-      weight[m] = w * (upper_bound - m) / (upper_bound - lower_bound);
+      double new_w = w * (upper_bound - m) / (upper_bound - lower_bound);
+      weight[i].weight = w * (m - lower_bound) / (upper_bound - lower_bound);
+      if (m == lower_bound) {
+        // The split point coincides with the bucket, as it would in a map.
+        weight[i].weight = new_w;
+      } else if (i + 1 < weight.size() && m == weight[i + 1].lower_bound) {
+        weight[i + 1].weight = new_w;
+      } else {
+        weight.insert(weight.begin() + i + 1, {m, new_w});
+      }
     }
 
     // Round the result instead of truncation.
@@ -232,24 +271,29 @@ class BinarySearch : public Algorithm<T> {
       m = std::round(m);
     }
 
-    // Return 95% confidence interval of the error.
-    Output output = MakeOutput<T>(m);
-    *(output.mutable_error_report()->mutable_noise_confidence_interval()) =
-        ErrorConfidenceInterval(kDefaultConfidenceLevel, weight, m);
-
-    return output;
+    if (error != nullptr) {
+      *error = ErrorConfidenceInterval(kDefaultConfidenceLevel, weight, m);
+    }
+    return m;
   }
 
+ private:
+  // A subrange of the search space starting at lower_bound, and the
+  // probability that it contains the target value.
+  struct Bucket {
+    double lower_bound;
+    double weight;
+  };
+
   // Given a noisy lower L and noisy greater count U for some value in a set,
   // and that the noise of these counts were generated by this mechanism with
-  // local privacy_budget, find the probability that the percentile p element of
+  // local privacy_budget, find the probability that the quantile p element of
   // the set is to the left of the investigated value. The tolerance is the
   // distance from removable singularities to use the value at singularity.
   // This function is the binary-search algorithm and derived here:
   // (broken link)
-  virtual double BayesianProbabilityLeft(double privacy_budget, double L,
-                                         double U) {
-    double p = quantile_;
+  virtual double BayesianProbabilityLeft(double privacy_budget, double p,
+                                         double L, double U) {
     double b = privacy_budget * Algorithm<T>::GetEpsilon();
 
     // Removable singularity at p=1/2.
@@ -290,34 +334,40 @@ class BinarySearch : public Algorithm<T> {
     return (-2 + num1 * std::pow(-1 + p, 2) + 4 * p - num2 * p * p) / denom;
   }
 
-  void UpdateWeight(std::map<double, double>* weight, double m,
-                    double update_left) {
+  // Applies the multipliers and normalizes the weights. Returns the index of
+  // the first bucket at which the cumulative normalized weight reaches 1/2,
+  // and stores that cumulative weight in sum_below.
+  size_t UpdateWeight(std::vector<Bucket>* weight, double m,
+                      double update_left, double* sum_below) {
     // Apply the multipliers. For buckets below, apply left update. For buckets
     // above, apply right update. m is always the lower bound of some bucket.
+    double update_right = 1 - update_left;
     double sum_w = 0;
-    for (std::map<double, double>::iterator it = weight->begin();
-         it != weight->end(); it++) {
-      // Get bounds and weight of the bucket.
-      double lower_bound = it->first;
-      double w = it->second;
-
-      // Apply multiplier for the bucket according to position wrt m.
-      double new_w = w;
-      double update_right = 1 - update_left;
-      if (lower_bound < m) {
-        new_w *= update_left;
+    for (Bucket& bucket : *weight) {
+      if (bucket.lower_bound < m) {
+        bucket.weight *= update_left;
       } else {  // lower_bound >= m
-        new_w *= update_right;
+        bucket.weight *= update_right;
       }
-      (*weight)[lower_bound] = new_w;
-      sum_w += new_w;
+      sum_w += bucket.weight;
     }
 
-    // Normalize so weights sum to 1.
-    for (auto const& bucket : *weight) {
-      double lower_bound = bucket.first;
-      (*weight)[lower_bound] /= sum_w;
+    // Normalize so weights sum to 1, and find the weighted median bucket.
+    size_t median = weight->size() - 1;
+    bool found = false;
+    double cumulative = 0;
+    for (size_t i = 0; i < weight->size(); ++i) {
+      (*weight)[i].weight /= sum_w;
+      if (!found) {
+        cumulative += (*weight)[i].weight;
+        if (cumulative >= .5) {
+          median = i;
+          found = true;
+        }
+      }
     }
+    *sum_below = cumulative;
+    return median;
   }
 
   base::StatusOr<double> Percentile(double m) {
@@ -358,25 +408,23 @@ class BinarySearch : public Algorithm<T> {
   }
 
   ConfidenceInterval ErrorConfidenceInterval(
-      double confidence_level, const std::map<double, double>& weight,
+      double confidence_level, const std::vector<Bucket>& weight,
       double result) {
     ConfidenceInterval interval;
     interval.set_confidence_level(confidence_level);
     double sum_w = 0.0;
     bool found_lower = false;
-    std::map<double, double>::const_iterator it;
-    for (it = weight.begin(); it != weight.end(); it++) {
-      sum_w += it->second;
+    for (size_t i = 0; i < weight.size(); ++i) {
+      sum_w += weight[i].weight;
       if (!found_lower && sum_w >= .5 - confidence_level / 2) {
-        interval.set_upper_bound(result - it->first);
+        interval.set_upper_bound(result - weight[i].lower_bound);
         found_lower = true;
       }
       if (sum_w > (.5 + confidence_level / 2)) {
-        std::map<double, double>::const_iterator it_next = std::next(it, 1);
-        if (it_next == weight.end()) {
+        if (i + 1 == weight.size()) {
           interval.set_lower_bound(result - upper_);
         } else {
-          interval.set_lower_bound(result - it_next->first);
+          interval.set_lower_bound(result - weight[i + 1].lower_bound);
         }
         break;
       }
@@ -57,11 +57,12 @@ class BoundedAlgorithm : public Algorithm<T> {
 
   // Trivial implementations of virtual functions.
   void AddEntry(const T& t) override {}
-  base::StatusOr<Output> GenerateResult(double /*privacy_budget*/) override {
-    return Output();
+  base::Status GenerateResultTo(double /*privacy_budget*/,
+                                Output* /*output*/) override {
+    return base::OkStatus();
   }
   void ResetState() override {}
-  Summary Serialize() override { return Summary(); }
+  void SerializeTo(Summary* /*summary*/) override {}
   base::Status Merge(const Summary& summary) override {
     return base::OkStatus();
   }
@@ -21,6 +21,7 @@
 #include "differential_privacy/algorithms/algorithm.h"
 #include "differential_privacy/algorithms/bounded-algorithm.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/algorithms/summary-reduction.h"
 #include "differential_privacy/proto/summary.pb.h"
 #include "absl/random/distributions.h"
 #include "differential_privacy/base/status_macros.h"
@@ -106,81 +107,77 @@ class BoundedMean : public Algorithm<T> {
     }
   };
 
-  void AddEntry(const T& t) override {
-    if (std::isnan(t)) {
+  void AddEntry(const T& t) override { AddEntryWithMultiplicity(t, 1); }
+
+  void AddEntryWithMultiplicity(const T& t, int64_t multiplicity) override {
+    if (std::isnan(t) || multiplicity <= 0) {
       return;
     }
-    ++raw_count_;
+    raw_count_ += multiplicity;
 
     if (!approx_bounds_) {
-      pos_sum_[0] += Clamp<T>(lower_, upper_, t);
+      pos_sum_[0] += Clamp<T>(lower_, upper_, t) * multiplicity;
     } else {
-      approx_bounds_->AddEntry(t);
+      approx_bounds_->AddEntryWithMultiplicity(t, multiplicity);
 
       // Find partial sums.
       if (t >= 0) {
-        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t);
+        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t,
+                                                     multiplicity);
       } else {
-        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t);
+        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t,
+                                                     multiplicity);
       }
     }
   }
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
-    DCHECK_GT(privacy_budget, 0.0)
-        << "Privacy budget should be greater than zero.";
-    if (privacy_budget == 0.0) return Output();
-    double sum = 0;
-    double remaining_budget = privacy_budget;
-    Output output;
-
-    // Find bounds and sum.
+  // With manual bounds, the batch is clamped and summed in one pass.
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
     if (approx_bounds_) {
-      // Use a fraction of the privacy budget to find the approximate bounds.
-      double bounds_budget = privacy_budget / 2;
-      remaining_budget -= bounds_budget;
-      ASSIGN_OR_RETURN(Output bounds,
-                       approx_bounds_->GenerateResult(bounds_budget));
-      lower_ = GetValue<T>(bounds.elements(0).value());
-      upper_ = GetValue<T>(bounds.elements(1).value());
-      RETURN_IF_ERROR(Builder::CheckBounds(lower_, upper_));
-      midpoint_ = lower_ + (upper_ - lower_) / 2;
-
-      // To find the sum, pass the identity function as the transform.
-      sum = approx_bounds_->template ComputeFromPartials<T>(
-          pos_sum_, neg_sum_, [](T x) { return x; }, lower_, upper_,
-          raw_count_);
-
-      // Populate the bounding report with ApproxBounds information.
-      *(output.mutable_error_report()->mutable_bounding_report()) =
-          approx_bounds_->GetBoundingReport(lower_, upper_);
-
-      // Clear the mechanism. The sensitivity might have changed.
-      sum_mechanism_.reset();
-    } else {
-      // Manual bounds were set and clamping was done upon adding entries.
-      sum = pos_sum_[0];
+      Algorithm<T>::AddColumnBatch(batch);
+      return;
     }
+    T sum = pos_sum_[0];
+    size_t count = 0;
+    ForEachValid(batch, [this, &sum, &count](const T& t) {
+      if (!std::isnan(t)) {
+        ++count;
+        sum += Clamp<T>(lower_, upper_, t);
+      }
+    });
+    pos_sum_[0] = sum;
+    raw_count_ += count;
+  }
 
-    // Construct mechanism if needed.
-    RETURN_IF_ERROR(BuildMechanism());
-
-    double count_budget = remaining_budget / 2;
-    remaining_budget -= count_budget;
-    double noised_count = count_mechanism_->AddNoise(raw_count_, count_budget);
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    DCHECK_GT(privacy_budget, 0.0)
+        << "Privacy budget should be greater than zero.";
+    if (privacy_budget == 0.0) return base::OkStatus();
+
+    BoundingReport* report =
+        approx_bounds_ && Algorithm<T>::ResultIncludes(kBoundingReport)
+            ? output->mutable_error_report()->mutable_bounding_report()
+            : nullptr;
+    ASSIGN_OR_RETURN(NoisyValue<double> mean,
+                     GenerateValue(privacy_budget, report, output->GetArena()));
+    AddToOutput(output, mean);
+    return base::OkStatus();
+  }
 
-    // If we don't have data.
-    if (noised_count <= 1) {
-      AddToOutput<double>(&output, midpoint_);
-      return output;
+  // Returns the noisy mean without constructing an Output. Consumes privacy
+  // budget like PartialResult. No bounding report is generated.
+  base::StatusOr<NoisyValue<double>> PartialValue(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
     }
+    return GenerateValue(budget, nullptr, nullptr);
+  }
 
-    // Normal case: we actually have data.
-    double normalized_sum = sum_mechanism_->AddNoise(
-        sum - raw_count_ * midpoint_, remaining_budget);
-    double average = normalized_sum / noised_count + midpoint_;
-    AddToOutput<double>(&output, Clamp<double>(lower_, upper_, average));
-    return output;
+  base::StatusOr<NoisyValue<double>> PartialValue() {
+    return PartialValue(Algorithm<T>::RemainingPrivacyBudget());
   }
 
   void ResetState() override {
@@ -193,26 +190,21 @@ class BoundedMean : public Algorithm<T> {
     }
   }
 
-  Summary Serialize() override {
+  void SerializeTo(Summary* summary) override {
     // Create BoundedMeanSummary.
-    BoundedMeanSummary bm_summary;
-    bm_summary.set_count(raw_count_);
-    for (T x : pos_sum_) {
-      SetValue(bm_summary.add_pos_sum(), x);
-    }
-    for (T x : neg_sum_) {
-      SetValue(bm_summary.add_neg_sum(), x);
-    }
+    BoundedMeanSummary local;
+    BoundedMeanSummary* bm_summary = ArenaOrLocal(summary->GetArena(), &local);
+    bm_summary->set_count(raw_count_);
+    AddPackedValues(pos_sum_, bm_summary->mutable_pos_sum_int(),
+                    bm_summary->mutable_pos_sum_double());
+    AddPackedValues(neg_sum_, bm_summary->mutable_neg_sum_int(),
+                    bm_summary->mutable_neg_sum_double());
     if (approx_bounds_) {
-      Summary approx_bounds_summary = approx_bounds_->Serialize();
-      approx_bounds_summary.data().UnpackTo(
-          bm_summary.mutable_bounds_summary());
+      approx_bounds_->SerializeToProto(bm_summary->mutable_bounds_summary());
     }
 
-    // Create Summary.
-    Summary summary;
-    summary.mutable_data()->PackFrom(bm_summary);
-    return summary;
+    // Fill Summary.
+    summary->mutable_data()->PackFrom(*bm_summary);
   }
 
   base::Status Merge(const Summary& summary) override {
@@ -227,25 +219,12 @@ class BoundedMean : public Algorithm<T> {
       return base::InvalidArgumentError(
           "Bounded mean summary unable to be unpacked.");
     }
-    raw_count_ += bm_summary.count();
-    if (pos_sum_.size() != bm_summary.pos_sum_size() ||
-        neg_sum_.size() != bm_summary.neg_sum_size()) {
-      return base::InvalidArgumentError(
-          "Merged BoundedMeans must have equal number of partial sums.");
-    }
-    for (int i = 0; i < pos_sum_.size(); ++i) {
-      pos_sum_[i] += GetValue<T>(bm_summary.pos_sum(i));
+    BoundedPartials<T> partials = EmptyPartials();
+    base::Status status = AccumulateSummary(bm_summary, &partials);
+    if (!status.ok()) {
+      return status;
     }
-    for (int i = 0; i < neg_sum_.size(); ++i) {
-      neg_sum_[i] += GetValue<T>(bm_summary.neg_sum(i));
-    }
-    if (approx_bounds_) {
-      Summary approx_bounds_summary;
-      approx_bounds_summary.mutable_data()->PackFrom(
-          bm_summary.bounds_summary());
-      RETURN_IF_ERROR(approx_bounds_->Merge(approx_bounds_summary));
-    }
-
+    AddPartials(partials);
     return base::OkStatus();
   }
 
@@ -264,6 +243,27 @@ class BoundedMean : public Algorithm<T> {
     return memory;
   }
 
+ protected:
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    base::StatusOr<BoundedPartials<T>> partials =
+        ReduceSummaries<BoundedMeanSummary, BoundedPartials<T>>(
+            summaries, EmptyPartials(),
+            [this](const BoundedMeanSummary& bm_summary,
+                   BoundedPartials<T>* partials) {
+              return AccumulateSummary(bm_summary, partials);
+            },
+            [](const BoundedPartials<T>& from, BoundedPartials<T>* to) {
+              to->Add(from);
+            },
+            num_threads);
+    if (!partials.ok()) {
+      return partials.status();
+    }
+    AddPartials(partials.ValueOrDie());
+    return base::OkStatus();
+  }
+
  private:
   BoundedMean(const double epsilon, T lower, T upper,
               std::unique_ptr<LaplaceMechanism::Builder> mechanism_builder,
@@ -290,6 +290,122 @@ class BoundedMean : public Algorithm<T> {
     }
   }
 
+  // Computes the noisy mean with privacy_budget, which must be positive.
+  // Writes the bounding report into report if bounds are automatically
+  // determined and report is not null. The approximate bounds are allocated on
+  // arena, or locally if arena is null.
+  base::StatusOr<NoisyValue<double>> GenerateValue(
+      double privacy_budget, BoundingReport* report,
+      google::protobuf::Arena* arena) {
+    double sum = 0;
+    double remaining_budget = privacy_budget;
+
+    // Find bounds and sum.
+    if (approx_bounds_) {
+      // Use a fraction of the privacy budget to find the approximate bounds.
+      double bounds_budget = privacy_budget / 2;
+      remaining_budget -= bounds_budget;
+      Output local_bounds;
+      Output* bounds = ArenaOrLocal(arena, &local_bounds);
+      RETURN_IF_ERROR(approx_bounds_->GenerateResultTo(bounds_budget, bounds));
+      lower_ = GetValue<T>(bounds->elements(0).value());
+      upper_ = GetValue<T>(bounds->elements(1).value());
+      RETURN_IF_ERROR(Builder::CheckBounds(lower_, upper_));
+      midpoint_ = lower_ + (upper_ - lower_) / 2;
+
+      // To find the sum, pass the identity function as the transform.
+      sum = approx_bounds_->template ComputeFromPartials<T>(
+          pos_sum_, neg_sum_, [](T x) { return x; }, lower_, upper_,
+          raw_count_);
+
+      // Populate the bounding report with ApproxBounds information.
+      if (report != nullptr) {
+        *report = approx_bounds_->GetBoundingReport(lower_, upper_);
+      }
+
+      // Clear the mechanism. The sensitivity might have changed.
+      sum_mechanism_.reset();
+    } else {
+      // Manual bounds were set and clamping was done upon adding entries.
+      sum = pos_sum_[0];
+    }
+
+    // Construct mechanism if needed.
+    RETURN_IF_ERROR(BuildMechanism());
+
+    double count_budget = remaining_budget / 2;
+    remaining_budget -= count_budget;
+    double noised_count = count_mechanism_->AddNoise(raw_count_, count_budget);
+
+    // If we don't have data.
+    NoisyValue<double> result;
+    if (noised_count <= 1) {
+      result.value = midpoint_;
+      return result;
+    }
+
+    // Normal case: we actually have data.
+    double normalized_sum = sum_mechanism_->AddNoise(
+        sum - raw_count_ * midpoint_, remaining_budget);
+    double average = normalized_sum / noised_count + midpoint_;
+    result.value = Clamp<double>(lower_, upper_, average);
+    return result;
+  }
+
+  // Returns a zero count and zeroed partial sums and bin counts of the sizes of
+  // this algorithm.
+  BoundedPartials<T> EmptyPartials() const {
+    BoundedPartials<T> partials;
+    if (approx_bounds_) {
+      partials = approx_bounds_->EmptyPartials();
+    }
+    partials.pos_sum.assign(pos_sum_.size(), 0);
+    partials.neg_sum.assign(neg_sum_.size(), 0);
+    return partials;
+  }
+
+  // Adds the count, partial sums and bin counts of bm_summary to partials, or
+  // returns an error and leaves partials unchanged if their sizes differ.
+  base::Status AccumulateSummary(const BoundedMeanSummary& bm_summary,
+                                 BoundedPartials<T>* partials) const {
+    ASSIGN_OR_RETURN(PackedValues<T> pos_sum,
+                     PackedValues<T>::Read(bm_summary.pos_sum_int(),
+                                           bm_summary.pos_sum_double(),
+                                           bm_summary.pos_sum()));
+    ASSIGN_OR_RETURN(PackedValues<T> neg_sum,
+                     PackedValues<T>::Read(bm_summary.neg_sum_int(),
+                                           bm_summary.neg_sum_double(),
+                                           bm_summary.neg_sum()));
+    if (partials->pos_sum.size() != pos_sum.size() ||
+        partials->neg_sum.size() != neg_sum.size()) {
+      return base::InvalidArgumentError(
+          "Merged BoundedMeans must have equal number of partial sums.");
+    }
+    if (approx_bounds_) {
+      RETURN_IF_ERROR(ApproxBounds<T>::AddBinsFromProto(
+          bm_summary.bounds_summary(), &partials->pos_bin_count,
+          &partials->neg_bin_count));
+    }
+    partials->count += bm_summary.count();
+    for (int i = 0; i < pos_sum.size(); ++i) {
+      partials->pos_sum[i] += pos_sum[i];
+    }
+    for (int i = 0; i < neg_sum.size(); ++i) {
+      partials->neg_sum[i] += neg_sum[i];
+    }
+    return base::OkStatus();
+  }
+
+  // Adds partials that were accumulated from summaries to the current state.
+  void AddPartials(const BoundedPartials<T>& partials) {
+    raw_count_ += partials.count;
+    AddElementwise(partials.pos_sum, &pos_sum_);
+    AddElementwise(partials.neg_sum, &neg_sum_);
+    if (approx_bounds_) {
+      approx_bounds_->AddBins(partials.pos_bin_count, partials.neg_bin_count);
+    }
+  }
+
   base::Status BuildMechanism() {
     if (!sum_mechanism_) {
       ASSIGN_OR_RETURN(
@@ -52,6 +52,56 @@ TYPED_TEST(BoundedMeanTest, BasicTest) {
   EXPECT_LE(GetValue<double>(result), 9);
 }
 
+TYPED_TEST(BoundedMeanTest, AddColumnBatchMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 7, 2, 5, 0, 8};
+  // Rows 1, 4 and 8 are null.
+  std::vector<uint8_t> validity = {0xed, 0x00};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedMean<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedMean<TypeParam>> batched =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedMean<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    ColumnBatch<TypeParam> batch;
+    batch.values = values;
+    batch.validity = validity.data();
+    batched->AddColumnBatch(batch);
+    for (int i : {0, 2, 3, 5, 6, 7}) {
+      expected->AddEntry(values[i]);
+    }
+    EXPECT_THAT(batched->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedMeanTest, AddEntryWithMultiplicityMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 0};
+  std::vector<int64_t> multiplicities = {3, 1, 2, 4, 0};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedMean<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedMean<TypeParam>> weighted =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedMean<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    weighted->AddEntriesWithMultiplicities(values, multiplicities);
+    for (int i = 0; i < values.size(); ++i) {
+      for (int j = 0; j < multiplicities[i]; ++j) {
+        expected->AddEntry(values[i]);
+      }
+    }
+    EXPECT_THAT(weighted->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
 TYPED_TEST(BoundedMeanTest, RepeatedResultTest) {
   std::vector<TypeParam> a = {2, 4, 6, 8};
 
@@ -142,6 +192,22 @@ TYPED_TEST(BoundedMeanTest, InfEpsilonTest) {
   EXPECT_DOUBLE_EQ(GetValue<double>(actual), expected);
 }
 
+TYPED_TEST(BoundedMeanTest, PartialValueMatchesPartialResult) {
+  std::vector<TypeParam> a = {2, 4, 6, 8};
+  typename BoundedMean<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetLower(1)
+      .SetUpper(9);
+  std::unique_ptr<BoundedMean<TypeParam>> mean = builder.Build().ValueOrDie();
+  mean->AddEntries(a.begin(), a.end());
+  std::unique_ptr<BoundedMean<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  Output output = expected->Result(a.begin(), a.end()).ValueOrDie();
+  EXPECT_EQ(mean->PartialValue().ValueOrDie().value,
+            GetValue<double>(output));
+  EXPECT_FALSE(mean->PartialValue().ok());
+}
+
 TYPED_TEST(BoundedMeanTest, PropagateApproxBoundsError) {
   std::unique_ptr<BoundedMean<TypeParam>> bm =
       typename BoundedMean<TypeParam>::Builder()
@@ -67,10 +67,12 @@ class BoundedStandardDeviation : public Algorithm<T> {
       // Construct bounded variance.
       std::unique_ptr<BoundedVariance<T>> variance;
       auto mech_builder = AlgorithmBuilder::laplace_mechanism_builder_->Clone();
-      ASSIGN_OR_RETURN(variance,
-                       variance_builder_.SetEpsilon(AlgorithmBuilder::epsilon_)
-                           .SetLaplaceMechanism(std::move(mech_builder))
-                           .Build());
+      ASSIGN_OR_RETURN(
+          variance,
+          variance_builder_.SetEpsilon(AlgorithmBuilder::epsilon_)
+              .SetLaplaceMechanism(std::move(mech_builder))
+              .SetResultOptions(AlgorithmBuilder::result_options_)
+              .Build());
 
       return absl::WrapUnique(new BoundedStandardDeviation(
           AlgorithmBuilder::epsilon_, std::move(variance)));
@@ -81,19 +83,49 @@ class BoundedStandardDeviation : public Algorithm<T> {
 
   void AddEntry(const T& t) override { variance_->AddEntry(t); }
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
-    ASSIGN_OR_RETURN(Output variance_output,
-                     variance_->GenerateResult(privacy_budget));
-    double stdev = std::sqrt(GetValue<double>(variance_output));
-    SetValue<double>(variance_output.mutable_elements(0)->mutable_value(),
-                     stdev);
-    return variance_output;
+  void AddEntryWithMultiplicity(const T& t, int64_t multiplicity) override {
+    variance_->AddEntryWithMultiplicity(t, multiplicity);
+  }
+
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    variance_->AddColumnBatch(batch);
+  }
+
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    base::Status status = variance_->GenerateResultTo(privacy_budget, output);
+    if (!status.ok()) {
+      return status;
+    }
+    double stdev = std::sqrt(GetValue<double>(*output));
+    SetValue<double>(output->mutable_elements(0)->mutable_value(), stdev);
+    return base::OkStatus();
+  }
+
+  // Returns the noisy standard deviation without constructing an Output.
+  // Consumes privacy budget like PartialResult.
+  base::StatusOr<NoisyValue<double>> PartialValue(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
+    }
+    ASSIGN_OR_RETURN(NoisyValue<double> stdev,
+                     variance_->GenerateValue(budget, nullptr, nullptr));
+    stdev.value = std::sqrt(stdev.value);
+    return stdev;
+  }
+
+  base::StatusOr<NoisyValue<double>> PartialValue() {
+    return PartialValue(Algorithm<T>::RemainingPrivacyBudget());
   }
 
   void ResetState() override { variance_->ResetState(); }
 
-  // Returns a BoundedVarianceSummary.
-  Summary Serialize() override { return variance_->Serialize(); }
+  // Writes a BoundedVarianceSummary.
+  void SerializeTo(Summary* summary) override {
+    variance_->SerializeTo(summary);
+  }
 
   // Merges from BoundedVarianceSummary.
   base::Status Merge(const Summary& summary) override {
@@ -108,6 +140,12 @@ class BoundedStandardDeviation : public Algorithm<T> {
     return memory;
   }
 
+ protected:
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    return variance_->MergeAll(summaries, num_threads);
+  }
+
  private:
   BoundedStandardDeviation(const double epsilon,
                            std::unique_ptr<BoundedVariance<T>> variance)
@@ -251,6 +251,33 @@ TYPED_TEST(BoundedStandardDeviationTest, AutomaticBounds) {
   EXPECT_THAT(bsd->PartialResult().ValueOrDie(), EqualsProto(expected_output));
 }
 
+TYPED_TEST(BoundedStandardDeviationTest, NoResultOptions) {
+  std::vector<TypeParam> a = {0, 0, 4, 4, -2, 7};
+  std::unique_ptr<ApproxBounds<TypeParam>> bounds =
+      typename ApproxBounds<TypeParam>::Builder()
+          .SetEpsilon(1)
+          .SetNumBins(4)
+          .SetBase(2)
+          .SetScale(1)
+          .SetThreshold(2)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  std::unique_ptr<BoundedStandardDeviation<TypeParam>> bsd =
+      typename BoundedStandardDeviation<TypeParam>::Builder()
+          .SetEpsilon(1)
+          .SetApproxBounds(std::move(bounds))
+          .SetResultOptions(kNoResultOptions)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  bsd->AddEntries(a.begin(), a.end());
+
+  Output expected_output;
+  AddToOutput<double>(&expected_output, 2);
+  EXPECT_THAT(bsd->PartialResult().ValueOrDie(), EqualsProto(expected_output));
+}
+
 // Test not providing ApproxBounds and instead using the default.
 TYPED_TEST(BoundedStandardDeviationTest, AutomaticBoundsDefault) {
   std::unique_ptr<BoundedStandardDeviation<TypeParam>> bsd =
@@ -269,6 +296,21 @@ TYPED_TEST(BoundedStandardDeviationTest, AutomaticBoundsDefault) {
       10, std::pow(10, -10));
 }
 
+TYPED_TEST(BoundedStandardDeviationTest, PartialValueMatchesPartialResult) {
+  std::vector<TypeParam> a = {1, 2, 3, 6};
+  typename BoundedStandardDeviation<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetLower(0)
+      .SetUpper(6);
+  std::unique_ptr<BoundedStandardDeviation<TypeParam>> bsd =
+      builder.Build().ValueOrDie();
+  bsd->AddEntries(a.begin(), a.end());
+  std::unique_ptr<BoundedStandardDeviation<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  Output output = expected->Result(a.begin(), a.end()).ValueOrDie();
+  EXPECT_EQ(bsd->PartialValue().ValueOrDie().value, GetValue<double>(output));
+}
+
 TYPED_TEST(BoundedStandardDeviationTest, PropagateApproxBoundsError) {
   std::unique_ptr<BoundedStandardDeviation<TypeParam>> bsd =
       typename BoundedStandardDeviation<TypeParam>::Builder()
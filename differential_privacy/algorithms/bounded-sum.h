@@ -23,6 +23,7 @@
 #include "differential_privacy/algorithms/algorithm.h"
 #include "differential_privacy/algorithms/bounded-algorithm.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/algorithms/summary-reduction.h"
 #include "differential_privacy/proto/summary.pb.h"
 #include "absl/memory/memory.h"
 #include "differential_privacy/base/status.h"
@@ -82,90 +83,89 @@ class BoundedSum : public Algorithm<T> {
     }
   };
 
-  void AddEntry(const T& t) override {
-    if (std::isnan(t)) {
+  void AddEntry(const T& t) override { AddEntryWithMultiplicity(t, 1); }
+
+  void AddEntryWithMultiplicity(const T& t, int64_t multiplicity) override {
+    if (std::isnan(t) || multiplicity <= 0) {
       return;
     }
 
     // If manual bounds are set, clamp immediately and store sum. Otherwise,
     // feed inputs into ApproxBounds and store temporary partial sums.
     if (!approx_bounds_) {
-      pos_sum_[0] += Clamp<T>(lower_, upper_, t);
+      pos_sum_[0] += Clamp<T>(lower_, upper_, t) * multiplicity;
     } else {
-      approx_bounds_->AddEntry(t);
+      approx_bounds_->AddEntryWithMultiplicity(t, multiplicity);
 
       // Find partial sums.
       if (t >= 0) {
-        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t);
+        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t,
+                                                     multiplicity);
       } else {
-        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t);
+        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t,
+                                                     multiplicity);
       }
     }
   }
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
-    DCHECK_GT(privacy_budget, 0.0)
-        << "Privacy budget should be greater than zero.";
-    if (privacy_budget == 0.0) return Output();
-
-    Output output;
-    double sum = 0;
-    double remaining_budget = privacy_budget;
-
+  // With manual bounds, the batch is clamped and summed in one pass.
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
     if (approx_bounds_) {
-      // Use a fraction of the privacy budget to find the approximate bounds.
-      // Analysis for choosing the fraction in
-      // (broken link)
-      double bounds_budget = privacy_budget / 2;
-      remaining_budget -= bounds_budget;
-      ASSIGN_OR_RETURN(Output bounds,
-                       approx_bounds_->GenerateResult(bounds_budget));
-      T lower = GetValue<T>(bounds.elements(0).value());
-      T upper = GetValue<T>(bounds.elements(1).value());
-      RETURN_IF_ERROR(Builder::CheckLowerBound(lower));
-
-      // Since sensitivity is determined only by the larger-magnitude bound,
-      // set the smaller-magnitude bound to be the negative of the larger. This
-      // minimizes clamping and so maximizes accuracy.
-      lower_ = std::min(lower, -1 * upper);
-      upper_ = std::max(upper, -1 * lower);
-
-      // To find the sum, pass the identity function as the transform. We pass
-      // count = 0 because the count should never be used.
-      sum = approx_bounds_->template ComputeFromPartials<T>(
-          pos_sum_, neg_sum_, [](T x) { return x; }, lower_, upper_, 0);
-
-      // Populate the bounding report with ApproxBounds information.
-      *(output.mutable_error_report()->mutable_bounding_report()) =
-          approx_bounds_->GetBoundingReport(lower_, upper_);
+      Algorithm<T>::AddColumnBatch(batch);
+      return;
+    }
+    T sum = pos_sum_[0];
+    ForEachValid(batch, [this, &sum](const T& t) {
+      if (!std::isnan(t)) {
+        sum += Clamp<T>(lower_, upper_, t);
+      }
+    });
+    pos_sum_[0] = sum;
+  }
 
-      // Clear the mechanism. The sensitivity might have changed.
-      mechanism_.reset();
-    } else {
-      // Manual bounds were set and clamping was done upon adding entries.
-      sum = pos_sum_[0];
+  // Removes an entry that was previously added, e.g. when it leaves a sliding
+  // window. Only supported with manual bounds, where the entry is clamped and
+  // subtracted from the sum.
+  base::Status RemoveEntry(const T& t) {
+    if (approx_bounds_) {
+      return base::FailedPreconditionError(
+          "Removing entries requires manually set bounds.");
     }
+    if (!std::isnan(t)) {
+      pos_sum_[0] -= Clamp<T>(lower_, upper_, t);
+    }
+    return base::OkStatus();
+  }
 
-    // Construct mechanism if needed. Mechanism is already constructed if
-    // NoiseConfidenceInterval() was called with manual bounds.
-    RETURN_IF_ERROR(BuildMechanism());
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    DCHECK_GT(privacy_budget, 0.0)
+        << "Privacy budget should be greater than zero.";
+    if (privacy_budget == 0.0) return base::OkStatus();
+
+    BoundingReport* report =
+        approx_bounds_ && Algorithm<T>::ResultIncludes(kBoundingReport)
+            ? output->mutable_error_report()->mutable_bounding_report()
+            : nullptr;
+    ASSIGN_OR_RETURN(NoisyValue<T> sum,
+                     GenerateValue(privacy_budget, report, output->GetArena()));
+    AddToOutput(output, sum);
+    return base::OkStatus();
+  }
 
-    // Add noise confidence interval to the error report.
-    base::StatusOr<ConfidenceInterval> interval =
-        NoiseConfidenceIntervalImpl(kDefaultConfidenceLevel, remaining_budget);
-    if (interval.ok()) {
-      *(output.mutable_error_report()->mutable_noise_confidence_interval()) =
-          interval.ValueOrDie();
+  // Returns the noisy sum without constructing an Output. Consumes privacy
+  // budget like PartialResult. No bounding report is generated.
+  base::StatusOr<NoisyValue<T>> PartialValue(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
     }
+    return GenerateValue(budget, nullptr, nullptr);
+  }
 
-    // Add noise to sum. Use the remaining privacy budget.
-    double noisy_sum = mechanism_->AddNoise(sum, remaining_budget);
-    if (std::is_integral<T>::value) {
-      AddToOutput<T>(&output, std::round(noisy_sum));
-    } else {
-      AddToOutput<T>(&output, noisy_sum);
-    }
-    return output;
+  base::StatusOr<NoisyValue<T>> PartialValue() {
+    return PartialValue(Algorithm<T>::RemainingPrivacyBudget());
   }
 
   // Only return noise confidence interval for manually set bounds, since it is
@@ -192,25 +192,20 @@ class BoundedSum : public Algorithm<T> {
   T lower() { return lower_; }
   T upper() { return upper_; }
 
-  Summary Serialize() override {
+  void SerializeTo(Summary* summary) override {
     // Create BoundedSumSummary.
-    BoundedSumSummary bs_summary;
-    for (T x : pos_sum_) {
-      SetValue(bs_summary.add_pos_sum(), x);
-    }
-    for (T x : neg_sum_) {
-      SetValue(bs_summary.add_neg_sum(), x);
-    }
+    BoundedSumSummary local;
+    BoundedSumSummary* bs_summary = ArenaOrLocal(summary->GetArena(), &local);
+    AddPackedValues(pos_sum_, bs_summary->mutable_pos_sum_int(),
+                    bs_summary->mutable_pos_sum_double());
+    AddPackedValues(neg_sum_, bs_summary->mutable_neg_sum_int(),
+                    bs_summary->mutable_neg_sum_double());
     if (approx_bounds_) {
-      Summary approx_bounds_summary = approx_bounds_->Serialize();
-      approx_bounds_summary.data().UnpackTo(
-          bs_summary.mutable_bounds_summary());
+      approx_bounds_->SerializeToProto(bs_summary->mutable_bounds_summary());
     }
 
-    // Create Summary.
-    Summary summary;
-    summary.mutable_data()->PackFrom(bs_summary);
-    return summary;
+    // Fill Summary.
+    summary->mutable_data()->PackFrom(*bs_summary);
   }
 
   base::Status Merge(const Summary& summary) override {
@@ -225,24 +220,12 @@ class BoundedSum : public Algorithm<T> {
       return base::InvalidArgumentError(
           "Bounded sum summary unable to be unpacked.");
     }
-    if (pos_sum_.size() != bs_summary.pos_sum_size() ||
-        neg_sum_.size() != bs_summary.neg_sum_size()) {
-      return base::InvalidArgumentError(
-          "Merged BoundedSum must have the same amount of partial sum "
-          "values as this BoundedSum.");
-    }
-    for (int i = 0; i < pos_sum_.size(); ++i) {
-      pos_sum_[i] += GetValue<T>(bs_summary.pos_sum(i));
-    }
-    for (int i = 0; i < neg_sum_.size(); ++i) {
-      neg_sum_[i] += GetValue<T>(bs_summary.neg_sum(i));
-    }
-    if (approx_bounds_) {
-      Summary approx_bounds_summary;
-      approx_bounds_summary.mutable_data()->PackFrom(
-          bs_summary.bounds_summary());
-      RETURN_IF_ERROR(approx_bounds_->Merge(approx_bounds_summary));
+    BoundedPartials<T> partials = EmptyPartials();
+    base::Status status = AccumulateSummary(bs_summary, &partials);
+    if (!status.ok()) {
+      return status;
     }
+    AddPartials(partials);
     return base::OkStatus();
   }
 
@@ -284,7 +267,147 @@ class BoundedSum : public Algorithm<T> {
     }
   }
 
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    base::StatusOr<BoundedPartials<T>> partials =
+        ReduceSummaries<BoundedSumSummary, BoundedPartials<T>>(
+            summaries, EmptyPartials(),
+            [this](const BoundedSumSummary& bs_summary,
+                   BoundedPartials<T>* partials) {
+              return AccumulateSummary(bs_summary, partials);
+            },
+            [](const BoundedPartials<T>& from, BoundedPartials<T>* to) {
+              to->Add(from);
+            },
+            num_threads);
+    if (!partials.ok()) {
+      return partials.status();
+    }
+    AddPartials(partials.ValueOrDie());
+    return base::OkStatus();
+  }
+
  private:
+  // Computes the noisy sum with privacy_budget, which must be positive. Writes
+  // the bounding report into report if bounds are automatically determined
+  // and report is not null. The approximate bounds are allocated on arena, or
+  // locally if arena is null.
+  base::StatusOr<NoisyValue<T>> GenerateValue(double privacy_budget,
+                                              BoundingReport* report,
+                                              google::protobuf::Arena* arena) {
+    double sum = 0;
+    double remaining_budget = privacy_budget;
+
+    if (approx_bounds_) {
+      // Use a fraction of the privacy budget to find the approximate bounds.
+      // Analysis for choosing the fraction in
+      // (broken link)
+      double bounds_budget = privacy_budget / 2;
+      remaining_budget -= bounds_budget;
+      Output local_bounds;
+      Output* bounds = ArenaOrLocal(arena, &local_bounds);
+      RETURN_IF_ERROR(approx_bounds_->GenerateResultTo(bounds_budget, bounds));
+      T lower = GetValue<T>(bounds->elements(0).value());
+      T upper = GetValue<T>(bounds->elements(1).value());
+      RETURN_IF_ERROR(Builder::CheckLowerBound(lower));
+
+      // Since sensitivity is determined only by the larger-magnitude bound,
+      // set the smaller-magnitude bound to be the negative of the larger. This
+      // minimizes clamping and so maximizes accuracy.
+      lower_ = std::min(lower, -1 * upper);
+      upper_ = std::max(upper, -1 * lower);
+
+      // To find the sum, pass the identity function as the transform. We pass
+      // count = 0 because the count should never be used.
+      sum = approx_bounds_->template ComputeFromPartials<T>(
+          pos_sum_, neg_sum_, [](T x) { return x; }, lower_, upper_, 0);
+
+      // Populate the bounding report with ApproxBounds information.
+      if (report != nullptr) {
+        *report = approx_bounds_->GetBoundingReport(lower_, upper_);
+      }
+
+      // Clear the mechanism. The sensitivity might have changed.
+      mechanism_.reset();
+    } else {
+      // Manual bounds were set and clamping was done upon adding entries.
+      sum = pos_sum_[0];
+    }
+
+    // Construct mechanism if needed. Mechanism is already constructed if
+    // NoiseConfidenceInterval() was called with manual bounds.
+    RETURN_IF_ERROR(BuildMechanism());
+
+    NoisyValue<T> result;
+    if (Algorithm<T>::ResultIncludes(kNoiseConfidenceInterval)) {
+      SetNoiseConfidenceInterval(
+          NoiseConfidenceIntervalImpl(kDefaultConfidenceLevel,
+                                      remaining_budget),
+          &result);
+    }
+
+    // Add noise to sum. Use the remaining privacy budget.
+    double noisy_sum = mechanism_->AddNoise(sum, remaining_budget);
+    if (std::is_integral<T>::value) {
+      result.value = std::round(noisy_sum);
+    } else {
+      result.value = noisy_sum;
+    }
+    return result;
+  }
+
+  // Returns zeroed partial sums and bin counts of the sizes of this algorithm.
+  BoundedPartials<T> EmptyPartials() const {
+    BoundedPartials<T> partials;
+    if (approx_bounds_) {
+      partials = approx_bounds_->EmptyPartials();
+    }
+    partials.pos_sum.assign(pos_sum_.size(), 0);
+    partials.neg_sum.assign(neg_sum_.size(), 0);
+    return partials;
+  }
+
+  // Adds the partial sums and bin counts of bs_summary to partials, or returns
+  // an error and leaves partials unchanged if their sizes differ.
+  base::Status AccumulateSummary(const BoundedSumSummary& bs_summary,
+                                 BoundedPartials<T>* partials) const {
+    ASSIGN_OR_RETURN(PackedValues<T> pos_sum,
+                     PackedValues<T>::Read(bs_summary.pos_sum_int(),
+                                           bs_summary.pos_sum_double(),
+                                           bs_summary.pos_sum()));
+    ASSIGN_OR_RETURN(PackedValues<T> neg_sum,
+                     PackedValues<T>::Read(bs_summary.neg_sum_int(),
+                                           bs_summary.neg_sum_double(),
+                                           bs_summary.neg_sum()));
+    if (partials->pos_sum.size() != pos_sum.size() ||
+        partials->neg_sum.size() != neg_sum.size()) {
+      return base::InvalidArgumentError(
+          "Merged BoundedSum must have the same amount of partial sum "
+          "values as this BoundedSum.");
+    }
+    if (approx_bounds_) {
+      RETURN_IF_ERROR(ApproxBounds<T>::AddBinsFromProto(
+          bs_summary.bounds_summary(), &partials->pos_bin_count,
+          &partials->neg_bin_count));
+    }
+    for (int i = 0; i < pos_sum.size(); ++i) {
+      partials->pos_sum[i] += pos_sum[i];
+    }
+    for (int i = 0; i < neg_sum.size(); ++i) {
+      partials->neg_sum[i] += neg_sum[i];
+    }
+    return base::OkStatus();
+  }
+
+  // Adds partials that were accumulated from summaries to the current state.
+  void AddPartials(const BoundedPartials<T>& partials) {
+    AddElementwise(partials.pos_sum, &pos_sum_);
+    AddElementwise(partials.neg_sum, &neg_sum_);
+    if (approx_bounds_) {
+      approx_bounds_->AddBins(partials.pos_bin_count, partials.neg_bin_count);
+    }
+  }
+
   base::Status BuildMechanism() {
     if (!mechanism_) {
       ASSIGN_OR_RETURN(
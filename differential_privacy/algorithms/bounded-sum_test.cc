@@ -16,6 +16,10 @@
 
 #include "differential_privacy/algorithms/bounded-sum.h"
 
+#include <cmath>
+#include <vector>
+
+#include "google/protobuf/arena.h"
 #include "differential_privacy/algorithms/algorithm.h"
 #include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
@@ -109,6 +113,87 @@ TYPED_TEST(BoundedSumTest, ClampTest) {
               Eq(static_cast<TypeParam>(6)));
 }
 
+TYPED_TEST(BoundedSumTest, AddColumnBatchMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 7, 2, 5, 0, 8};
+  // Rows 1, 4 and 8 are null.
+  std::vector<uint8_t> validity = {0xed, 0x00};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedSum<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedSum<TypeParam>> batched =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedSum<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    ColumnBatch<TypeParam> batch;
+    batch.values = values;
+    batch.validity = validity.data();
+    batched->AddColumnBatch(batch);
+    // An empty selection adds no rows.
+    batch.selection = absl::Span<const int64_t>();
+    batched->AddColumnBatch(batch);
+    for (int i : {0, 2, 3, 5, 6, 7}) {
+      expected->AddEntry(values[i]);
+    }
+    EXPECT_THAT(batched->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedSumTest, AddEntryWithMultiplicityMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 0};
+  std::vector<int64_t> multiplicities = {3, 1, 2, 4, 0};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedSum<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedSum<TypeParam>> weighted =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedSum<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    weighted->AddEntriesWithMultiplicities(values, multiplicities);
+    for (int i = 0; i < values.size(); ++i) {
+      for (int j = 0; j < multiplicities[i]; ++j) {
+        expected->AddEntry(values[i]);
+      }
+    }
+    EXPECT_THAT(weighted->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedSumTest, RemoveEntry) {
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .SetLower(1)
+          .SetUpper(5)
+          .Build()
+          .ValueOrDie();
+  for (TypeParam entry : {0, 2, 4, 10}) {
+    bs->AddEntry(entry);
+  }
+  EXPECT_OK(bs->RemoveEntry(0));
+  EXPECT_OK(bs->RemoveEntry(10));
+  EXPECT_THAT(GetValue<TypeParam>(bs->PartialResult().ValueOrDie()),
+              Eq(static_cast<TypeParam>(6)));
+}
+
+TYPED_TEST(BoundedSumTest, RemoveEntryRequiresManualBounds) {
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  bs->AddEntry(1);
+  EXPECT_EQ(bs->RemoveEntry(1).code(),
+            base::StatusCode::kFailedPrecondition);
+}
+
 TEST(BoundedSumTest, ConfidenceIntervalTest) {
   double epsilon = 0.5;
   double upperBound = 2;
@@ -265,6 +350,159 @@ TYPED_TEST(BoundedSumTest, SerializeMergePartialSumsTest) {
             GetValue<TypeParam>(bs2->PartialResult().ValueOrDie()));
 }
 
+TYPED_TEST(BoundedSumTest, ArenaSerializeAndResult) {
+  std::unique_ptr<ApproxBounds<TypeParam>> bounds =
+      typename ApproxBounds<TypeParam>::Builder()
+          .SetThreshold(1)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .SetApproxBounds(std::move(bounds))
+          .Build()
+          .ValueOrDie();
+  bs->AddEntry(-10);
+  bs->AddEntry(4);
+
+  google::protobuf::Arena arena;
+  Summary* summary = bs->Serialize(&arena);
+  EXPECT_EQ(summary->GetArena(), &arena);
+  EXPECT_THAT(*summary, EqualsProto(bs->Serialize()));
+
+  Output* output = bs->PartialResult(&arena).ValueOrDie();
+  EXPECT_EQ(output->GetArena(), &arena);
+  EXPECT_NEAR(GetValue<TypeParam>(*output), -6, 1e-10);
+  EXPECT_TRUE(output->error_report().has_bounding_report());
+}
+
+TYPED_TEST(BoundedSumTest, MergeAllMatchesMerge) {
+  typename ApproxBounds<TypeParam>::Builder bounds_builder;
+  typename BoundedSum<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>());
+  bounds_builder.SetThreshold(1).SetNumBins(20).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+
+  // Mix dense and sparse bins by giving some shards many distinct inputs.
+  // Inputs are integers so that sums in any order are exact.
+  std::vector<Summary> summaries;
+  for (int shard = 0; shard < 50; ++shard) {
+    std::unique_ptr<BoundedSum<TypeParam>> bs =
+        builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+            .Build()
+            .ValueOrDie();
+    bs->AddEntry(-shard);
+    for (int i = 0; i < (shard % 10 == 0 ? 30 : 1); ++i) {
+      bs->AddEntry(static_cast<TypeParam>(std::pow(2, i)));
+    }
+    summaries.push_back(bs->Serialize());
+  }
+
+  std::unique_ptr<BoundedSum<TypeParam>> expected =
+      builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+          .Build()
+          .ValueOrDie();
+  for (const Summary& summary : summaries) {
+    EXPECT_OK(expected->Merge(summary));
+  }
+  for (int num_threads : {1, 4}) {
+    std::unique_ptr<BoundedSum<TypeParam>> bs =
+        builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+            .Build()
+            .ValueOrDie();
+    EXPECT_OK(bs->MergeAll(summaries, num_threads));
+    EXPECT_THAT(bs->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedSumTest, MergeAllMergesNothingOnError) {
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetLower(0)
+          .SetUpper(10)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  bs->AddEntry(2);
+  std::vector<Summary> summaries(10, bs->Serialize());
+  summaries[7].clear_data();
+
+  EXPECT_FALSE(bs->MergeAll(summaries, 4).ok());
+  EXPECT_EQ(GetValue<TypeParam>(bs->PartialResult().ValueOrDie()), 2);
+}
+
+TYPED_TEST(BoundedSumTest, PartialValueMatchesPartialResult) {
+  std::vector<TypeParam> a = {-10, 4, 6, 8};
+  typename ApproxBounds<TypeParam>::Builder bounds_builder;
+  bounds_builder.SetThreshold(1).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  typename BoundedSum<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>());
+
+  // Automatic bounds.
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+          .Build()
+          .ValueOrDie();
+  bs->AddEntries(a.begin(), a.end());
+  std::unique_ptr<BoundedSum<TypeParam>> expected =
+      builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+          .Build()
+          .ValueOrDie();
+  Output output = expected->Result(a.begin(), a.end()).ValueOrDie();
+  NoisyValue<TypeParam> value = bs->PartialValue().ValueOrDie();
+  EXPECT_EQ(value.value, GetValue<TypeParam>(output));
+  EXPECT_EQ(value.has_noise_confidence_interval,
+            output.error_report().has_noise_confidence_interval());
+
+  // Manual bounds.
+  bs = builder.ClearBounds().SetLower(0).SetUpper(5).Build().ValueOrDie();
+  bs->AddEntries(a.begin(), a.end());
+  expected = builder.Build().ValueOrDie();
+  expected->AddEntries(a.begin(), a.end());
+  output = expected->PartialResult(0.5).ValueOrDie();
+  value = bs->PartialValue(0.5).ValueOrDie();
+  EXPECT_EQ(bs->RemainingPrivacyBudget(), 0.5);
+  EXPECT_EQ(value.value, GetValue<TypeParam>(output));
+  ASSERT_TRUE(value.has_noise_confidence_interval);
+  const ConfidenceInterval& interval =
+      output.error_report().noise_confidence_interval();
+  EXPECT_EQ(value.noise_lower_bound, interval.lower_bound());
+  EXPECT_EQ(value.noise_upper_bound, interval.upper_bound());
+  EXPECT_EQ(value.confidence_level, interval.confidence_level());
+}
+
+TYPED_TEST(BoundedSumTest, MergeLegacySummary) {
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetLower(0)
+          .SetUpper(10)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  bs->AddEntry(2);
+
+  // Summaries written before the packed fields store partial sums as
+  // ValueType.
+  BoundedSumSummary bs_summary;
+  SetValue<TypeParam>(bs_summary.add_pos_sum(), 3);
+  Summary summary;
+  summary.mutable_data()->PackFrom(bs_summary);
+  EXPECT_OK(bs->Merge(summary));
+  EXPECT_EQ(GetValue<TypeParam>(bs->PartialResult().ValueOrDie()), 5);
+
+  // Partial sums of the other type are not merged.
+  bs_summary.Clear();
+  if (std::is_integral<TypeParam>::value) {
+    bs_summary.add_pos_sum_double(1);
+  } else {
+    bs_summary.add_pos_sum_int(1);
+  }
+  summary.mutable_data()->PackFrom(bs_summary);
+  EXPECT_FALSE(bs->Merge(summary).ok());
+}
+
 TEST(BoundedSumTest, DropNanEntriesManualBounds) {
   std::vector<double> a = {NAN, 1};
   std::unique_ptr<BoundedSum<double>> bs =
@@ -350,6 +588,34 @@ TYPED_TEST(BoundedSumTest, AutomaticBoundsContainZero) {
               EqualsProto(expected_report));
 }
 
+TYPED_TEST(BoundedSumTest, ResultOptionsSkipBoundingReport) {
+  std::vector<TypeParam> a = {0, 0, 8, 8};
+  std::unique_ptr<ApproxBounds<TypeParam>> bounds =
+      typename ApproxBounds<TypeParam>::Builder()
+          .SetEpsilon(1)
+          .SetNumBins(5)
+          .SetBase(2)
+          .SetScale(1)
+          .SetThreshold(2)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  std::unique_ptr<BoundedSum<TypeParam>> bs =
+      typename BoundedSum<TypeParam>::Builder()
+          .SetEpsilon(1)
+          .SetApproxBounds(std::move(bounds))
+          .SetResultOptions(kNoiseConfidenceInterval)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  bs->AddEntries(a.begin(), a.end());
+  Output output = bs->PartialResult().ValueOrDie();
+
+  EXPECT_EQ(GetValue<TypeParam>(output.elements(0).value()), 16);
+  EXPECT_FALSE(output.error_report().has_bounding_report());
+  EXPECT_TRUE(output.error_report().has_noise_confidence_interval());
+}
+
 TYPED_TEST(BoundedSumTest, AutomaticBoundsNegative) {
   std::vector<TypeParam> a = {9, -2, -2, -4, -6, -6};
   std::unique_ptr<ApproxBounds<TypeParam>> bounds =
@@ -22,11 +22,23 @@
 #include "differential_privacy/algorithms/approx-bounds.h"
 #include "differential_privacy/algorithms/bounded-algorithm.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/algorithms/summary-reduction.h"
 #include "differential_privacy/proto/util.h"
 #include "absl/memory/memory.h"
 
 namespace differential_privacy {
 
+// Noisy statistics that BoundedVariance derives from the noisy count, sum and
+// sum of squares it computes for the variance. Since they are post-processing
+// of the same noisy values, releasing all of them costs no more privacy budget
+// than releasing the variance alone.
+struct BoundedStatistics {
+  double count;
+  double sum;
+  double mean;
+  double variance;
+};
+
 // Incrementally provides a differentially private variance for values in the
 // range [lower..upper]. Values outside of this range will be clamped so they
 // lie in the range. The output will also be clamped between 0 and (upper -
@@ -138,23 +150,25 @@ class BoundedVariance : public Algorithm<T> {
     }
   };
 
-  void AddEntry(const T& t) override {
+  void AddEntry(const T& t) override { AddEntryWithMultiplicity(t, 1); }
+
+  void AddEntryWithMultiplicity(const T& t, int64_t multiplicity) override {
     // Drop value if it is NaN.
-    if (std::isnan(t)) {
+    if (std::isnan(t) || multiplicity <= 0) {
       return;
     }
 
     // Count is unaffected by clamping.
-    ++raw_count_;
+    raw_count_ += multiplicity;
 
     // If bounds exist, clamp and record. Otherwise, store partial results and
     // feed input into ApproxBounds algorithm.
     if (!approx_bounds_) {
       double clamped = Clamp<double>(lower_, upper_, t);
-      pos_sum_[0] += clamped;
-      pos_sum_of_squares_[0] += clamped * clamped;
+      pos_sum_[0] += clamped * multiplicity;
+      pos_sum_of_squares_[0] += clamped * clamped * multiplicity;
     } else {
-      approx_bounds_->AddEntry(t);
+      approx_bounds_->AddEntryWithMultiplicity(t, multiplicity);
 
       // Add to partial sums and sum of squares.
       auto difference_of_squares = [](T val1, T val2) {
@@ -163,23 +177,209 @@ class BoundedVariance : public Algorithm<T> {
                (static_cast<double>(val1) - val2);
       };
       if (t >= 0) {
-        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t);
-        approx_bounds_->template AddToPartials<double>(&pos_sum_of_squares_, t,
-                                                       difference_of_squares);
+        approx_bounds_->template AddToPartialSums<T>(&pos_sum_, t,
+                                                     multiplicity);
+        approx_bounds_->template AddToPartials<double>(
+            &pos_sum_of_squares_, t, difference_of_squares, multiplicity);
       } else {
-        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t);
-        approx_bounds_->template AddToPartials<double>(&neg_sum_of_squares_, t,
-                                                       difference_of_squares);
+        approx_bounds_->template AddToPartialSums<T>(&neg_sum_, t,
+                                                     multiplicity);
+        approx_bounds_->template AddToPartials<double>(
+            &neg_sum_of_squares_, t, difference_of_squares, multiplicity);
       }
     }
   }
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
+  // With manual bounds, the batch is clamped and summed in one pass.
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    if (approx_bounds_) {
+      Algorithm<T>::AddColumnBatch(batch);
+      return;
+    }
+    T sum = pos_sum_[0];
+    double sum_of_squares = pos_sum_of_squares_[0];
+    size_t count = 0;
+    ForEachValid(batch, [&](const T& t) {
+      if (!std::isnan(t)) {
+        ++count;
+        double clamped = Clamp<double>(lower_, upper_, t);
+        sum += clamped;
+        sum_of_squares += clamped * clamped;
+      }
+    });
+    pos_sum_[0] = sum;
+    pos_sum_of_squares_[0] = sum_of_squares;
+    raw_count_ += count;
+  }
+
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
     DCHECK_GT(privacy_budget, 0.0)
         << "Privacy budget should be greater than zero.";
-    if (privacy_budget == 0.0) return Output();
+    if (privacy_budget == 0.0) return base::OkStatus();
+
+    BoundingReport* report =
+        approx_bounds_ && Algorithm<T>::ResultIncludes(kBoundingReport)
+            ? output->mutable_error_report()->mutable_bounding_report()
+            : nullptr;
+    ASSIGN_OR_RETURN(NoisyValue<double> variance,
+                     GenerateValue(privacy_budget, report, output->GetArena()));
+    AddToOutput(output, variance);
+    return base::OkStatus();
+  }
+
+  // Returns the noisy variance without constructing an Output. Consumes
+  // privacy budget like PartialResult. No bounding report is generated.
+  base::StatusOr<NoisyValue<double>> PartialValue(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
+    }
+    return GenerateValue(budget, nullptr, nullptr);
+  }
+
+  base::StatusOr<NoisyValue<double>> PartialValue() {
+    return PartialValue(Algorithm<T>::RemainingPrivacyBudget());
+  }
+
+  // Returns the noisy count, sum, mean and variance of the inputs. Consumes
+  // privacy budget like PartialResult. No bounding report is generated.
+  base::StatusOr<BoundedStatistics> PartialStatistics(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
+    }
+    return GenerateStatistics(budget, nullptr, nullptr);
+  }
+
+  base::StatusOr<BoundedStatistics> PartialStatistics() {
+    return PartialStatistics(Algorithm<T>::RemainingPrivacyBudget());
+  }
+
+  void ResetState() override {
+    std::fill(pos_sum_.begin(), pos_sum_.end(), 0);
+    std::fill(pos_sum_of_squares_.begin(), pos_sum_of_squares_.end(), 0);
+    std::fill(neg_sum_.begin(), neg_sum_.end(), 0);
+    std::fill(neg_sum_of_squares_.begin(), neg_sum_of_squares_.end(), 0);
+    raw_count_ = 0;
+
+    if (approx_bounds_) {
+      approx_bounds_->ResetState();
+      sum_mechanism_ = nullptr;
+      sos_mechanism_ = nullptr;
+    }
+  }
+
+  void SerializeTo(Summary* summary) override {
+    // Create BoundedVarianceSummary.
+    BoundedVarianceSummary local;
+    BoundedVarianceSummary* bv_summary =
+        ArenaOrLocal(summary->GetArena(), &local);
+    bv_summary->set_count(raw_count_);
+    AddPackedValues(pos_sum_, bv_summary->mutable_pos_sum_int(),
+                    bv_summary->mutable_pos_sum_double());
+    AddPackedValues(neg_sum_, bv_summary->mutable_neg_sum_int(),
+                    bv_summary->mutable_neg_sum_double());
+    bv_summary->mutable_pos_sum_of_squares()->Add(pos_sum_of_squares_.begin(),
+                                                  pos_sum_of_squares_.end());
+    bv_summary->mutable_neg_sum_of_squares()->Add(neg_sum_of_squares_.begin(),
+                                                  neg_sum_of_squares_.end());
+    if (approx_bounds_) {
+      approx_bounds_->SerializeToProto(bv_summary->mutable_bounds_summary());
+    }
+
+    // Fill Summary.
+    summary->mutable_data()->PackFrom(*bv_summary);
+  }
+
+  base::Status Merge(const Summary& summary) override {
+    if (!summary.has_data()) {
+      return base::InvalidArgumentError(
+          "Cannot merge summary with no bounded variance data.");
+    }
+
+    // Unpack bounded variance summary.
+    BoundedVarianceSummary bv_summary;
+    if (!summary.data().UnpackTo(&bv_summary)) {
+      return base::InvalidArgumentError(
+          "Bounded variance summary unable to be unpacked.");
+    }
+    BoundedPartials<T> partials = EmptyPartials();
+    base::Status status = AccumulateSummary(bv_summary, &partials);
+    if (!status.ok()) {
+      return status;
+    }
+    AddPartials(partials);
+    return base::OkStatus();
+  }
+
+  int64_t MemoryUsed() override {
+    int64_t memory = sizeof(BoundedVariance<T>) +
+                   sizeof(T) * (pos_sum_.capacity() + neg_sum_.capacity()) +
+                   sizeof(double) * (pos_sum_of_squares_.capacity() +
+                                     neg_sum_of_squares_.capacity());
+    if (approx_bounds_) {
+      memory += approx_bounds_->MemoryUsed();
+    }
+    if (sum_mechanism_) {
+      memory += sum_mechanism_->MemoryUsed();
+    }
+    if (mechanism_builder_) {
+      memory += sizeof(*mechanism_builder_);
+    }
+    return memory;
+  }
+
+ protected:
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    base::StatusOr<BoundedPartials<T>> partials =
+        ReduceSummaries<BoundedVarianceSummary, BoundedPartials<T>>(
+            summaries, EmptyPartials(),
+            [this](const BoundedVarianceSummary& bv_summary,
+                   BoundedPartials<T>* partials) {
+              return AccumulateSummary(bv_summary, partials);
+            },
+            [](const BoundedPartials<T>& from, BoundedPartials<T>* to) {
+              to->Add(from);
+            },
+            num_threads);
+    if (!partials.ok()) {
+      return partials.status();
+    }
+    AddPartials(partials.ValueOrDie());
+    return base::OkStatus();
+  }
+
+ private:
+  // BoundedStandardDeviation releases the square root of GenerateValue.
+  template <typename U,
+            typename std::enable_if<std::is_integral<U>::value ||
+                                    std::is_floating_point<U>::value>::type*>
+  friend class BoundedStandardDeviation;
+
+  // Computes the noisy variance with privacy_budget, which must be positive,
+  // without consuming budget of this algorithm. Writes the bounding report
+  // into report if bounds are automatically determined and report is not
+  // null. The approximate bounds are allocated on arena, or locally if arena is
+  // null.
+  base::StatusOr<NoisyValue<double>> GenerateValue(
+      double privacy_budget, BoundingReport* report,
+      google::protobuf::Arena* arena) {
+    ASSIGN_OR_RETURN(BoundedStatistics statistics,
+                     GenerateStatistics(privacy_budget, report, arena));
+    NoisyValue<double> result;
+    result.value = statistics.variance;
+    return result;
+  }
+
+  // Like GenerateValue, but returns all statistics computed for the variance.
+  base::StatusOr<BoundedStatistics> GenerateStatistics(
+      double privacy_budget, BoundingReport* report,
+      google::protobuf::Arena* arena) {
     double remaining_budget = privacy_budget;
-    Output output;
 
     // We need these values to find the final variance.
     double sum = 0;
@@ -189,10 +389,11 @@ class BoundedVariance : public Algorithm<T> {
       // Get bounds with a fraction of the privacy budget.
       double bounds_budget = privacy_budget / 2;
       remaining_budget -= bounds_budget;
-      ASSIGN_OR_RETURN(Output bounds,
-                       approx_bounds_->GenerateResult(bounds_budget));
-      lower_ = GetValue<T>(bounds.elements(0).value());
-      upper_ = GetValue<T>(bounds.elements(1).value());
+      Output local_bounds;
+      Output* bounds = ArenaOrLocal(arena, &local_bounds);
+      RETURN_IF_ERROR(approx_bounds_->GenerateResultTo(bounds_budget, bounds));
+      lower_ = GetValue<T>(bounds->elements(0).value());
+      upper_ = GetValue<T>(bounds->elements(1).value());
       RETURN_IF_ERROR(Builder::CheckBounds(lower_, upper_));
 
       // To find the sum, pass the identity function as the transform.
@@ -206,8 +407,9 @@ class BoundedVariance : public Algorithm<T> {
           lower_, upper_, raw_count_);
 
       // Populate the bounding report with ApproxBounds information.
-      *(output.mutable_error_report()->mutable_bounding_report()) =
-          approx_bounds_->GetBoundingReport(lower_, upper_);
+      if (report != nullptr) {
+        *report = approx_bounds_->GetBoundingReport(lower_, upper_);
+      }
 
       // Clear the mechanism. The sensitivity might have changed.
       sum_mechanism_.reset();
@@ -258,119 +460,15 @@ class BoundedVariance : public Algorithm<T> {
     }
 
     double noised_variance = mean_of_square - pow(mean, 2);
-    AddToOutput<double>(
-        &output, Clamp<double>(0.0, IntervalLengthSquared(lower_, upper_) / 4,
-                               noised_variance));
-    return output;
+    BoundedStatistics result;
+    result.variance = Clamp<double>(
+        0.0, IntervalLengthSquared(lower_, upper_) / 4, noised_variance);
+    result.count = std::max(noised_sum_count, 0.0);
+    result.mean = Clamp<double>(lower_, upper_, mean);
+    result.sum = result.mean * result.count;
+    return result;
   }
 
-  void ResetState() override {
-    std::fill(pos_sum_.begin(), pos_sum_.end(), 0);
-    std::fill(pos_sum_of_squares_.begin(), pos_sum_of_squares_.end(), 0);
-    std::fill(neg_sum_.begin(), neg_sum_.end(), 0);
-    std::fill(neg_sum_of_squares_.begin(), neg_sum_of_squares_.end(), 0);
-    raw_count_ = 0;
-
-    if (approx_bounds_) {
-      approx_bounds_->ResetState();
-      sum_mechanism_ = nullptr;
-      sos_mechanism_ = nullptr;
-    }
-  }
-
-  Summary Serialize() override {
-    // Create BoundedVarianceSummary.
-    BoundedVarianceSummary bv_summary;
-    bv_summary.set_count(raw_count_);
-    for (T x : pos_sum_) {
-      SetValue(bv_summary.add_pos_sum(), x);
-    }
-    for (T x : neg_sum_) {
-      SetValue(bv_summary.add_neg_sum(), x);
-    }
-    for (T x : pos_sum_of_squares_) {
-      bv_summary.add_pos_sum_of_squares(x);
-    }
-    for (T x : neg_sum_of_squares_) {
-      bv_summary.add_neg_sum_of_squares(x);
-    }
-    if (approx_bounds_) {
-      Summary approx_bounds_summary = approx_bounds_->Serialize();
-      approx_bounds_summary.data().UnpackTo(
-          bv_summary.mutable_bounds_summary());
-    }
-
-    // Create Summary.
-    Summary summary;
-    summary.mutable_data()->PackFrom(bv_summary);
-    return summary;
-  }
-
-  base::Status Merge(const Summary& summary) override {
-    if (!summary.has_data()) {
-      return base::InvalidArgumentError(
-          "Cannot merge summary with no bounded variance data.");
-    }
-
-    // Unpack bounded variance summary.
-    BoundedVarianceSummary bv_summary;
-    if (!summary.data().UnpackTo(&bv_summary)) {
-      return base::InvalidArgumentError(
-          "Bounded variance summary unable to be unpacked.");
-    }
-    if ((approx_bounds_ != nullptr) != bv_summary.has_bounds_summary()) {
-      return base::InvalidArgumentError(
-          "Merged BoundedVariance must have the same bounding strategy.");
-    }
-    if (pos_sum_.size() != bv_summary.pos_sum_size() ||
-        neg_sum_.size() != bv_summary.neg_sum_size() ||
-        pos_sum_of_squares_.size() != bv_summary.pos_sum_of_squares_size() ||
-        neg_sum_of_squares_.size() != bv_summary.neg_sum_of_squares_size()) {
-      return base::InvalidArgumentError(
-          "Merged BoundedVariance must have the same amount of partial "
-          "sum or sum of squares values as this BoundedVariance.");
-    }
-
-    // Add count and partial values to current ones.
-    raw_count_ += bv_summary.count();
-    for (int i = 0; i < pos_sum_.size(); ++i) {
-      pos_sum_[i] += GetValue<T>(bv_summary.pos_sum(i));
-      pos_sum_of_squares_[i] += bv_summary.pos_sum_of_squares(i);
-    }
-    for (int i = 0; i < neg_sum_.size(); ++i) {
-      neg_sum_[i] += GetValue<T>(bv_summary.neg_sum(i));
-      neg_sum_of_squares_[i] += bv_summary.neg_sum_of_squares(i);
-    }
-
-    // Merge approx bounds if auto-clamping.
-    if (approx_bounds_) {
-      Summary approx_bounds_summary;
-      approx_bounds_summary.mutable_data()->PackFrom(
-          bv_summary.bounds_summary());
-      RETURN_IF_ERROR(approx_bounds_->Merge(approx_bounds_summary));
-    }
-
-    return base::OkStatus();
-  }
-
-  int64_t MemoryUsed() override {
-    int64_t memory = sizeof(BoundedVariance<T>) +
-                   sizeof(T) * (pos_sum_.capacity() + neg_sum_.capacity()) +
-                   sizeof(double) * (pos_sum_of_squares_.capacity() +
-                                     neg_sum_of_squares_.capacity());
-    if (approx_bounds_) {
-      memory += approx_bounds_->MemoryUsed();
-    }
-    if (sum_mechanism_) {
-      memory += sum_mechanism_->MemoryUsed();
-    }
-    if (mechanism_builder_) {
-      memory += sizeof(*mechanism_builder_);
-    }
-    return memory;
-  }
-
- private:
   BoundedVariance(const double epsilon, const T lower, const T upper,
                   std::unique_ptr<LaplaceMechanism::Builder> mechanism_builder,
                   std::unique_ptr<LaplaceMechanism> sum_mechanism,
@@ -423,6 +521,76 @@ class BoundedVariance : public Algorithm<T> {
     return std::abs(upper * upper - lower * lower);
   }
 
+  // Returns a zero count and zeroed partial sums, sums of squares and bin
+  // counts of the sizes of this algorithm.
+  BoundedPartials<T> EmptyPartials() const {
+    BoundedPartials<T> partials;
+    if (approx_bounds_) {
+      partials = approx_bounds_->EmptyPartials();
+    }
+    partials.pos_sum.assign(pos_sum_.size(), 0);
+    partials.neg_sum.assign(neg_sum_.size(), 0);
+    partials.pos_sum_of_squares.assign(pos_sum_of_squares_.size(), 0);
+    partials.neg_sum_of_squares.assign(neg_sum_of_squares_.size(), 0);
+    return partials;
+  }
+
+  // Adds the count, partial values and bin counts of bv_summary to partials,
+  // or returns an error and leaves partials unchanged if bv_summary is not
+  // compatible with this algorithm.
+  base::Status AccumulateSummary(const BoundedVarianceSummary& bv_summary,
+                                 BoundedPartials<T>* partials) const {
+    if ((approx_bounds_ != nullptr) != bv_summary.has_bounds_summary()) {
+      return base::InvalidArgumentError(
+          "Merged BoundedVariance must have the same bounding strategy.");
+    }
+    ASSIGN_OR_RETURN(PackedValues<T> pos_sum,
+                     PackedValues<T>::Read(bv_summary.pos_sum_int(),
+                                           bv_summary.pos_sum_double(),
+                                           bv_summary.pos_sum()));
+    ASSIGN_OR_RETURN(PackedValues<T> neg_sum,
+                     PackedValues<T>::Read(bv_summary.neg_sum_int(),
+                                           bv_summary.neg_sum_double(),
+                                           bv_summary.neg_sum()));
+    if (partials->pos_sum.size() != pos_sum.size() ||
+        partials->neg_sum.size() != neg_sum.size() ||
+        partials->pos_sum_of_squares.size() !=
+            bv_summary.pos_sum_of_squares_size() ||
+        partials->neg_sum_of_squares.size() !=
+            bv_summary.neg_sum_of_squares_size()) {
+      return base::InvalidArgumentError(
+          "Merged BoundedVariance must have the same amount of partial "
+          "sum or sum of squares values as this BoundedVariance.");
+    }
+    if (approx_bounds_) {
+      RETURN_IF_ERROR(ApproxBounds<T>::AddBinsFromProto(
+          bv_summary.bounds_summary(), &partials->pos_bin_count,
+          &partials->neg_bin_count));
+    }
+    partials->count += bv_summary.count();
+    for (int i = 0; i < pos_sum.size(); ++i) {
+      partials->pos_sum[i] += pos_sum[i];
+      partials->pos_sum_of_squares[i] += bv_summary.pos_sum_of_squares(i);
+    }
+    for (int i = 0; i < neg_sum.size(); ++i) {
+      partials->neg_sum[i] += neg_sum[i];
+      partials->neg_sum_of_squares[i] += bv_summary.neg_sum_of_squares(i);
+    }
+    return base::OkStatus();
+  }
+
+  // Adds partials that were accumulated from summaries to the current state.
+  void AddPartials(const BoundedPartials<T>& partials) {
+    raw_count_ += partials.count;
+    AddElementwise(partials.pos_sum, &pos_sum_);
+    AddElementwise(partials.neg_sum, &neg_sum_);
+    AddElementwise(partials.pos_sum_of_squares, &pos_sum_of_squares_);
+    AddElementwise(partials.neg_sum_of_squares, &neg_sum_of_squares_);
+    if (approx_bounds_) {
+      approx_bounds_->AddBins(partials.pos_bin_count, partials.neg_bin_count);
+    }
+  }
+
   base::Status BuildMechanism() {
     if (!sum_mechanism_) {
       ASSIGN_OR_RETURN(
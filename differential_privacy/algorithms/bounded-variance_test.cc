@@ -247,6 +247,146 @@ TYPED_TEST(BoundedVarianceTest, SerializeMergePartialValuesTest) {
             GetValue<double>(bv2->PartialResult().ValueOrDie()));
 }
 
+TYPED_TEST(BoundedVarianceTest, MergeAllMatchesMerge) {
+  typename ApproxBounds<TypeParam>::Builder bounds_builder;
+  typename BoundedVariance<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>());
+  bounds_builder.SetThreshold(1).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+
+  // Shards with automatic bounding, so that partials and bins are merged.
+  std::vector<Summary> summaries;
+  for (int shard = 0; shard < 20; ++shard) {
+    std::unique_ptr<BoundedVariance<TypeParam>> bv =
+        builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+            .Build()
+            .ValueOrDie();
+    bv->AddEntry(shard % 7 - 3);
+    bv->AddEntry(shard);
+    summaries.push_back(bv->Serialize());
+  }
+
+  std::unique_ptr<BoundedVariance<TypeParam>> expected =
+      builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+          .Build()
+          .ValueOrDie();
+  for (const Summary& summary : summaries) {
+    EXPECT_OK(expected->Merge(summary));
+  }
+  for (int num_threads : {1, 4}) {
+    std::unique_ptr<BoundedVariance<TypeParam>> bv =
+        builder.SetApproxBounds(bounds_builder.Build().ValueOrDie())
+            .Build()
+            .ValueOrDie();
+    EXPECT_OK(bv->MergeAll(summaries, num_threads));
+    EXPECT_THAT(bv->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedVarianceTest, MergeAllMergesNothingOnError) {
+  typename BoundedVariance<TypeParam>::Builder builder;
+  builder.SetLower(0).SetUpper(10).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<BoundedVariance<TypeParam>> bv =
+      builder.Build().ValueOrDie();
+  bv->AddEntry(2);
+  std::vector<Summary> summaries(3, bv->Serialize());
+
+  // The last summary comes from automatic bounding.
+  summaries.push_back(builder.ClearBounds().Build().ValueOrDie()->Serialize());
+  Summary before = bv->Serialize();
+  EXPECT_EQ(bv->MergeAll(summaries, 2).message(),
+            "Merged BoundedVariance must have the same bounding strategy.");
+  EXPECT_THAT(bv->Serialize(), EqualsProto(before));
+}
+
+TYPED_TEST(BoundedVarianceTest, PartialValueMatchesPartialResult) {
+  std::vector<TypeParam> a = {1, 2, 3, 6};
+  typename BoundedVariance<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetLower(0)
+      .SetUpper(6);
+  std::unique_ptr<BoundedVariance<TypeParam>> bv =
+      builder.Build().ValueOrDie();
+  bv->AddEntries(a.begin(), a.end());
+  std::unique_ptr<BoundedVariance<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  Output output = expected->Result(a.begin(), a.end()).ValueOrDie();
+  EXPECT_EQ(bv->PartialValue().ValueOrDie().value, GetValue<double>(output));
+}
+
+TYPED_TEST(BoundedVarianceTest, AddColumnBatchMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 7, 2, 5, 0, 8};
+  // Rows 1, 4 and 8 are null.
+  std::vector<uint8_t> validity = {0xed, 0x00};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedVariance<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedVariance<TypeParam>> batched =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedVariance<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    ColumnBatch<TypeParam> batch;
+    batch.values = values;
+    batch.validity = validity.data();
+    batched->AddColumnBatch(batch);
+    for (int i : {0, 2, 3, 5, 6, 7}) {
+      expected->AddEntry(values[i]);
+    }
+    EXPECT_THAT(batched->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedVarianceTest, AddEntryWithMultiplicityMatchesAddEntry) {
+  std::vector<TypeParam> values = {1, 3, 10, -4, 0};
+  std::vector<int64_t> multiplicities = {3, 1, 2, 4, 0};
+  for (bool manual_bounds : {true, false}) {
+    typename BoundedVariance<TypeParam>::Builder builder;
+    builder.SetLaplaceMechanism(
+        absl::make_unique<ZeroNoiseMechanism::Builder>());
+    if (manual_bounds) {
+      builder.SetLower(0).SetUpper(6);
+    }
+    std::unique_ptr<BoundedVariance<TypeParam>> weighted =
+        builder.Build().ValueOrDie();
+    std::unique_ptr<BoundedVariance<TypeParam>> expected =
+        builder.Build().ValueOrDie();
+    weighted->AddEntriesWithMultiplicities(values, multiplicities);
+    for (int i = 0; i < values.size(); ++i) {
+      for (int j = 0; j < multiplicities[i]; ++j) {
+        expected->AddEntry(values[i]);
+      }
+    }
+    EXPECT_THAT(weighted->Serialize(), EqualsProto(expected->Serialize()));
+  }
+}
+
+TYPED_TEST(BoundedVarianceTest, PartialStatistics) {
+  std::vector<TypeParam> a = {1, 2, 3, 6};
+  typename BoundedVariance<TypeParam>::Builder builder;
+  builder.SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetLower(0)
+      .SetUpper(6);
+  std::unique_ptr<BoundedVariance<TypeParam>> bv =
+      builder.Build().ValueOrDie();
+  bv->AddEntries(a.begin(), a.end());
+  BoundedStatistics statistics = bv->PartialStatistics().ValueOrDie();
+  EXPECT_EQ(bv->RemainingPrivacyBudget(), 0);
+  EXPECT_DOUBLE_EQ(statistics.count, 4);
+  EXPECT_DOUBLE_EQ(statistics.sum, 12);
+  EXPECT_DOUBLE_EQ(statistics.mean, 3);
+  EXPECT_DOUBLE_EQ(statistics.variance, 3.5);
+
+  std::unique_ptr<BoundedVariance<TypeParam>> expected =
+      builder.Build().ValueOrDie();
+  Output output = expected->Result(a.begin(), a.end()).ValueOrDie();
+  EXPECT_EQ(statistics.variance, GetValue<double>(output));
+}
+
 TEST(BoundedVarianceTest, SensitivityOverflow) {
   auto statusor = typename BoundedVariance<int64_t>::Builder()
                       .SetEpsilon(1.0)
@@ -0,0 +1,99 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_CHECKPOINT_H_
+#define DIFFERENTIAL_PRIVACY_ALGORITHMS_CHECKPOINT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/arena.h"
+#include "differential_privacy/algorithms/algorithm.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/checkpoint_file.h"
+#include "differential_privacy/base/parallel.h"
+#include "differential_privacy/base/status.h"
+
+namespace differential_privacy {
+
+// Checkpoints of the state of many algorithms, e.g. all live aggregations of a
+// service, so that a restarted service restores them instead of re-ingesting
+// their inputs. Each algorithm is stored as an AlgorithmCheckpoint holding the
+// Summary that Serialize returns and its remaining privacy budget, and
+// restored with Merge, so any algorithm that supports Serialize can be
+// checkpointed. Restoring consumes the budget that had been consumed before
+// the checkpoint, so results released before a restart cannot be released
+// again.
+//
+// config_hash identifies the configuration that the algorithms were built
+// with, for example base::Fnv1aHash of their serialized parameters. Restoring
+// a checkpoint fails unless the same config_hash is passed, since summaries
+// can only be merged into algorithms with identical parameters.
+
+// Writes the state of each algorithm, with its key, to a checkpoint file at
+// path. Algorithms are serialized and written on up to num_threads threads.
+template <typename T>
+base::Status WriteCheckpoint(
+    const std::string& path, uint64_t config_hash,
+    const std::vector<std::pair<uint64_t, Algorithm<T>*>>& algorithms,
+    int num_threads = 1) {
+  google::protobuf::Arena arena;
+  std::vector<base::CheckpointMessage> messages(algorithms.size());
+  base::ParallelFor(algorithms.size(), num_threads, [&](int64_t i) {
+    Algorithm<T>* algorithm = algorithms[i].second;
+    AlgorithmCheckpoint* record =
+        google::protobuf::Arena::CreateMessage<AlgorithmCheckpoint>(&arena);
+    record->unsafe_arena_set_allocated_summary(algorithm->Serialize(&arena));
+    record->set_remaining_privacy_budget(algorithm->RemainingPrivacyBudget());
+    messages[i] = std::make_pair(algorithms[i].first, record);
+  });
+  return base::WriteCheckpointFile(path, config_hash, messages, num_threads);
+}
+
+// Restores the state of the record at index of checkpoint into algorithm,
+// which must be newly built or reset, and consumes the privacy budget that had
+// been consumed when the checkpoint was written. The record is parsed directly
+// from the mapped file.
+template <typename T>
+base::Status RestoreFromCheckpoint(const base::CheckpointFile& checkpoint,
+                                   int64_t index, Algorithm<T>* algorithm) {
+  AlgorithmCheckpoint record;
+  base::Status status = checkpoint.ParseRecord(index, &record);
+  if (!status.ok()) {
+    return status;
+  }
+  const double remaining_budget = record.remaining_privacy_budget();
+  if (!record.has_remaining_privacy_budget() ||
+      !(remaining_budget >= 0 && remaining_budget <= 1)) {
+    return base::DataLossError(
+        "Checkpoint record has no valid remaining privacy budget.");
+  }
+  status = algorithm->Merge(record.summary());
+  if (!status.ok()) {
+    return status;
+  }
+  algorithm->ConsumePrivacyBudget(std::max(
+      0.0, algorithm->RemainingPrivacyBudget() - remaining_budget));
+  return base::OkStatus();
+}
+
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_ALGORITHMS_CHECKPOINT_H_
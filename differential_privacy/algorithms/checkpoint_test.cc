@@ -0,0 +1,131 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/algorithms/checkpoint.h"
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "differential_privacy/algorithms/approx-bounds.h"
+#include "differential_privacy/algorithms/bounded-mean.h"
+#include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
+#include "differential_privacy/base/testing/proto_matchers.h"
+#include "differential_privacy/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace {
+
+using test_utils::ZeroNoiseMechanism;
+using ::differential_privacy::base::testing::EqualsProto;
+
+const uint64_t kConfigHash = base::Fnv1aHash("bounded mean, auto bounds");
+
+std::unique_ptr<BoundedMean<double>> MakeMean() {
+  return BoundedMean<double>::Builder()
+      .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetApproxBounds(
+          ApproxBounds<double>::Builder()
+              .SetThreshold(1)
+              .SetLaplaceMechanism(
+                  absl::make_unique<ZeroNoiseMechanism::Builder>())
+              .Build()
+              .ValueOrDie())
+      .Build()
+      .ValueOrDie();
+}
+
+TEST(CheckpointTest, RestoresBoundedMeans) {
+  const std::string path = ::testing::TempDir() + "/means";
+  std::vector<std::unique_ptr<BoundedMean<double>>> means;
+  std::vector<std::pair<uint64_t, Algorithm<double>*>> algorithms;
+  for (int i = 0; i < 20; ++i) {
+    means.push_back(MakeMean());
+    for (int j = 0; j <= i; ++j) {
+      means.back()->AddEntry(j - 5);
+    }
+    algorithms.push_back(std::make_pair(7 * i, means.back().get()));
+  }
+  EXPECT_OK(WriteCheckpoint(path, kConfigHash, algorithms, 4));
+
+  base::StatusOr<std::unique_ptr<base::CheckpointFile>> checkpoint =
+      base::CheckpointFile::Open(path, kConfigHash);
+  ASSERT_OK(checkpoint.status());
+  const base::CheckpointFile& file = *checkpoint.ValueOrDie();
+  ASSERT_EQ(file.num_records(), means.size());
+  for (int i = 0; i < file.num_records(); ++i) {
+    EXPECT_EQ(file.key(i), 7 * i);
+    std::unique_ptr<BoundedMean<double>> restored = MakeMean();
+    EXPECT_OK(RestoreFromCheckpoint(file, i, restored.get()));
+    EXPECT_THAT(restored->Serialize(), EqualsProto(means[i]->Serialize()));
+    EXPECT_EQ(GetValue<double>(restored->PartialResult().ValueOrDie()),
+              GetValue<double>(means[i]->PartialResult().ValueOrDie()));
+  }
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, RestoresApproxBounds) {
+  const std::string path = ::testing::TempDir() + "/bounds";
+  typename ApproxBounds<int64_t>::Builder builder;
+  builder.SetThreshold(1).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<ApproxBounds<int64_t>> bounds = builder.Build().ValueOrDie();
+  for (int64_t entry : {-8, 1, 3, 100}) {
+    bounds->AddEntry(entry);
+  }
+  EXPECT_OK(WriteCheckpoint<int64_t>(path, kConfigHash, {{1, bounds.get()}}));
+
+  base::StatusOr<std::unique_ptr<base::CheckpointFile>> checkpoint =
+      base::CheckpointFile::Open(path, kConfigHash);
+  ASSERT_OK(checkpoint.status());
+  std::unique_ptr<ApproxBounds<int64_t>> restored =
+      builder.Build().ValueOrDie();
+  EXPECT_EQ(
+      RestoreFromCheckpoint(*checkpoint.ValueOrDie(), 1, restored.get()).code(),
+      base::StatusCode::kOutOfRange);
+  EXPECT_OK(RestoreFromCheckpoint(*checkpoint.ValueOrDie(), 0, restored.get()));
+  EXPECT_THAT(restored->PartialResult().ValueOrDie(),
+              EqualsProto(bounds->PartialResult().ValueOrDie()));
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointTest, RestoresConsumedPrivacyBudget) {
+  const std::string path = ::testing::TempDir() + "/budget";
+  std::unique_ptr<BoundedMean<double>> partial = MakeMean();
+  std::unique_ptr<BoundedMean<double>> released = MakeMean();
+  partial->AddEntry(1);
+  released->AddEntry(1);
+  ASSERT_OK(partial->PartialResult(0.25).status());
+  ASSERT_OK(released->PartialResult().status());
+  EXPECT_OK(WriteCheckpoint<double>(
+      path, kConfigHash, {{1, partial.get()}, {2, released.get()}}));
+
+  base::StatusOr<std::unique_ptr<base::CheckpointFile>> checkpoint =
+      base::CheckpointFile::Open(path, kConfigHash);
+  ASSERT_OK(checkpoint.status());
+  std::unique_ptr<BoundedMean<double>> restored = MakeMean();
+  EXPECT_OK(RestoreFromCheckpoint(*checkpoint.ValueOrDie(), 0, restored.get()));
+  EXPECT_DOUBLE_EQ(restored->RemainingPrivacyBudget(), 0.75);
+  restored = MakeMean();
+  EXPECT_OK(RestoreFromCheckpoint(*checkpoint.ValueOrDie(), 1, restored.get()));
+  EXPECT_EQ(restored->RemainingPrivacyBudget(), 0);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace differential_privacy
@@ -0,0 +1,143 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_COLUMN_BATCH_H_
+#define DIFFERENTIAL_PRIVACY_ALGORITHMS_COLUMN_BATCH_H_
+
+#include <cstdint>
+
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "differential_privacy/base/logging.h"
+
+namespace differential_privacy {
+
+// A batch of entries in the layout of columnar formats such as Apache Arrow: a
+// contiguous buffer of values, an optional validity bitmap marking the null
+// rows, and an optional selection vector of the rows to use. None of the
+// buffers are owned by the batch.
+template <typename T>
+struct ColumnBatch {
+  // The values of all rows, including null rows, whose values are ignored.
+  absl::Span<const T> values;
+
+  // Bit i, counting from the least significant bit of byte 0, is set iff row
+  // i is valid. If null, all rows are valid.
+  const uint8_t* validity = nullptr;
+
+  // Indices of the rows in the batch, each in [0, values.size()). If unset, all
+  // rows are in the batch; an empty selection has no rows.
+  absl::optional<absl::Span<const int64_t>> selection;
+};
+
+namespace internal {
+
+// Returns whether row is valid according to the validity bitmap.
+inline bool IsValidRow(const uint8_t* validity, int64_t row) {
+  return validity[row / 8] & (1 << (row % 8));
+}
+
+// Returns the validity bits of the up to 64 rows from row begin, which must be
+// a multiple of 64, to num_rows. Bits of rows past num_rows are zero.
+inline uint64_t ValidityWord(const uint8_t* validity, int64_t begin,
+                             int64_t num_rows) {
+  const uint8_t* bytes = validity + begin / 8;
+  const int64_t rows = num_rows - begin;
+  const int64_t num_bytes = rows >= 64 ? 8 : (rows + 7) / 8;
+  uint64_t word = 0;
+  for (int64_t i = 0; i < num_bytes; ++i) {
+    word |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  if (rows < 64) {
+    word &= (uint64_t{1} << rows) - 1;
+  }
+  return word;
+}
+
+}  // namespace internal
+
+// Calls fn with each valid value of the batch, in order of the rows. Without a
+// selection vector, the validity bitmap is read 64 rows at a time, so that
+// runs of valid rows are passed without per-row checks and null runs are
+// skipped.
+template <typename T, typename Fn>
+void ForEachValid(const ColumnBatch<T>& batch, Fn fn) {
+  const T* values = batch.values.data();
+  const uint8_t* validity = batch.validity;
+  if (batch.selection.has_value()) {
+    for (int64_t row : *batch.selection) {
+      DCHECK_GE(row, 0);
+      DCHECK_LT(row, batch.values.size());
+      if (!validity || internal::IsValidRow(validity, row)) {
+        fn(values[row]);
+      }
+    }
+    return;
+  }
+  const int64_t num_rows = batch.values.size();
+  if (!validity) {
+    for (int64_t row = 0; row < num_rows; ++row) {
+      fn(values[row]);
+    }
+    return;
+  }
+  for (int64_t begin = 0; begin < num_rows; begin += 64) {
+    uint64_t word = internal::ValidityWord(validity, begin, num_rows);
+    if (word == ~uint64_t{0}) {
+      for (int64_t row = begin; row < begin + 64; ++row) {
+        fn(values[row]);
+      }
+      continue;
+    }
+    while (word != 0) {
+      fn(values[begin + __builtin_ctzll(word)]);
+      word &= word - 1;
+    }
+  }
+}
+
+// Returns the number of valid rows of the batch. Without a selection vector,
+// this counts the set bits of the validity bitmap without reading the values.
+template <typename T>
+int64_t CountValid(const ColumnBatch<T>& batch) {
+  const uint8_t* validity = batch.validity;
+  if (batch.selection.has_value()) {
+    if (!validity) {
+      return batch.selection->size();
+    }
+    int64_t count = 0;
+    for (int64_t row : *batch.selection) {
+      DCHECK_GE(row, 0);
+      DCHECK_LT(row, batch.values.size());
+      count += internal::IsValidRow(validity, row);
+    }
+    return count;
+  }
+  const int64_t num_rows = batch.values.size();
+  if (!validity) {
+    return num_rows;
+  }
+  int64_t count = 0;
+  for (int64_t begin = 0; begin < num_rows; begin += 64) {
+    count +=
+        __builtin_popcountll(internal::ValidityWord(validity, begin, num_rows));
+  }
+  return count;
+}
+
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_ALGORITHMS_COLUMN_BATCH_H_
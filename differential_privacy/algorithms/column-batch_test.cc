@@ -0,0 +1,119 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/algorithms/column-batch.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::vector<int64_t> ValidValues(const ColumnBatch<int64_t>& batch) {
+  std::vector<int64_t> values;
+  ForEachValid(batch, [&values](int64_t value) { values.push_back(value); });
+  return values;
+}
+
+// Returns the values 0, ..., num_rows - 1 and a validity bitmap in which row i
+// is valid iff valid(i).
+template <typename Valid>
+std::pair<std::vector<int64_t>, std::vector<uint8_t>> MakeColumn(
+    int64_t num_rows, Valid valid) {
+  std::vector<int64_t> values(num_rows);
+  std::vector<uint8_t> validity((num_rows + 7) / 8);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    values[i] = i;
+    if (valid(i)) {
+      validity[i / 8] |= 1 << (i % 8);
+    }
+  }
+  return {values, validity};
+}
+
+TEST(ColumnBatchTest, AllValid) {
+  std::vector<int64_t> values = {4, 5, 6};
+  ColumnBatch<int64_t> batch;
+  batch.values = values;
+  EXPECT_THAT(ValidValues(batch), ElementsAre(4, 5, 6));
+  EXPECT_EQ(CountValid(batch), 3);
+}
+
+TEST(ColumnBatchTest, Validity) {
+  // Spans full words of valid and of null rows, a mixed word, and a partial
+  // last word whose padding bits are set.
+  const int64_t num_rows = 64 * 4 + 13;
+  auto valid = [](int64_t i) {
+    return i < 64 || (i >= 128 && i % 3 == 0) || i >= 192;
+  };
+  auto column = MakeColumn(num_rows, valid);
+  column.second.back() |= 0xf0;
+  ColumnBatch<int64_t> batch;
+  batch.values = column.first;
+  batch.validity = column.second.data();
+
+  std::vector<int64_t> expected;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    if (valid(i)) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_THAT(ValidValues(batch), ElementsAreArray(expected));
+  EXPECT_EQ(CountValid(batch), expected.size());
+}
+
+TEST(ColumnBatchTest, Selection) {
+  auto column = MakeColumn(20, [](int64_t i) { return i % 2 == 0; });
+  std::vector<int64_t> selection = {1, 2, 8, 15, 16};
+  ColumnBatch<int64_t> batch;
+  batch.values = column.first;
+  batch.selection = selection;
+  EXPECT_THAT(ValidValues(batch), ElementsAre(1, 2, 8, 15, 16));
+  EXPECT_EQ(CountValid(batch), 5);
+
+  batch.validity = column.second.data();
+  EXPECT_THAT(ValidValues(batch), ElementsAre(2, 8, 16));
+  EXPECT_EQ(CountValid(batch), 3);
+}
+
+TEST(ColumnBatchTest, EmptySelection) {
+  auto column = MakeColumn(20, [](int64_t i) { return true; });
+  std::vector<int64_t> selection;
+  ColumnBatch<int64_t> batch;
+  batch.values = column.first;
+  batch.selection = selection;
+  EXPECT_THAT(ValidValues(batch), ElementsAre());
+  EXPECT_EQ(CountValid(batch), 0);
+
+  batch.validity = column.second.data();
+  EXPECT_THAT(ValidValues(batch), ElementsAre());
+  EXPECT_EQ(CountValid(batch), 0);
+}
+
+TEST(ColumnBatchTest, Empty) {
+  ColumnBatch<int64_t> batch;
+  EXPECT_THAT(ValidValues(batch), ElementsAre());
+  EXPECT_EQ(CountValid(batch), 0);
+}
+
+}  // namespace
+}  // namespace differential_privacy
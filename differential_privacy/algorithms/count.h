@@ -20,6 +20,7 @@
 #include "google/protobuf/any.pb.h"
 #include "differential_privacy/algorithms/algorithm.h"
 #include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/algorithms/summary-reduction.h"
 #include "differential_privacy/proto/summary.pb.h"
 
 namespace differential_privacy {
@@ -32,6 +33,29 @@ class Count : public Algorithm<T> {
 
   void AddEntry(const T& v) override { ++count_; }
 
+  void AddEntryWithMultiplicity(const T& v, int64_t multiplicity) override {
+    if (multiplicity > 0) {
+      count_ += multiplicity;
+    }
+  }
+
+  // Counts the valid rows of the batch from its validity bitmap, without
+  // reading the values.
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    count_ += CountValid(batch);
+  }
+
+  // Removes an entry that was previously added, e.g. when it leaves a sliding
+  // window. Returns an error if there are no entries to remove.
+  base::Status RemoveEntry(const T& v) {
+    if (count_ == 0) {
+      return base::FailedPreconditionError(
+          "Cannot remove an entry from an empty count.");
+    }
+    --count_;
+    return base::OkStatus();
+  }
+
   base::StatusOr<ConfidenceInterval> NoiseConfidenceInterval(
       double confidence_level, double privacy_budget = 1) override {
     return mechanism_->NoiseConfidenceInterval(confidence_level,
@@ -39,15 +63,13 @@ class Count : public Algorithm<T> {
   }
 
   // Create and return summary containing the count.
-  Summary Serialize() override {
+  void SerializeTo(Summary* summary) override {
     // Create CountSummary.
     CountSummary count_summ;
     count_summ.set_count(count_);
 
-    // Create Summary.
-    Summary summary;
-    summary.mutable_data()->PackFrom(count_summ);
-    return summary;
+    // Fill Summary.
+    summary->mutable_data()->PackFrom(count_summ);
   }
 
   // Add count from serialized data.
@@ -67,6 +89,21 @@ class Count : public Algorithm<T> {
     return base::OkStatus();
   }
 
+  // Returns the noisy count without constructing an Output. Consumes privacy
+  // budget like PartialResult.
+  base::StatusOr<NoisyValue<int64_t>> PartialValue(double privacy_budget) {
+    double budget = Algorithm<T>::ConsumePrivacyBudget(privacy_budget);
+    if (budget == 0.0) {
+      return base::InvalidArgumentError(
+          "Privacy budget should be greater than zero.");
+    }
+    return GenerateValue(budget);
+  }
+
+  base::StatusOr<NoisyValue<int64_t>> PartialValue() {
+    return PartialValue(Algorithm<T>::RemainingPrivacyBudget());
+  }
+
   int64_t MemoryUsed() override {
     int64_t memory = sizeof(Count<T>);
     if (mechanism_) {
@@ -76,19 +113,26 @@ class Count : public Algorithm<T> {
   }
 
  protected:
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
-    Output output;
-    std::size_t countWithNoise = std::max<int64_t>(
-        std::round(mechanism_->AddNoise(count_, privacy_budget)), 0);
-    AddToOutput<int64_t>(&output, countWithNoise);
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    AddToOutput(output, GenerateValue(privacy_budget));
+    return base::OkStatus();
+  }
 
-    base::StatusOr<ConfidenceInterval> interval =
-        NoiseConfidenceInterval(kDefaultConfidenceLevel, privacy_budget);
-    if (interval.ok()) {
-      *(output.mutable_error_report()->mutable_noise_confidence_interval()) =
-          interval.ValueOrDie();
+  base::Status MergeSummaries(absl::Span<const Summary> summaries,
+                              int num_threads) override {
+    base::StatusOr<int64_t> count = ReduceSummaries<CountSummary, int64_t>(
+        summaries, 0,
+        [](const CountSummary& count_summary, int64_t* count) {
+          *count += count_summary.count();
+          return base::OkStatus();
+        },
+        [](const int64_t& from, int64_t* to) { *to += from; }, num_threads);
+    if (!count.ok()) {
+      return count.status();
     }
-    return output;
+    count_ += count.ValueOrDie();
+    return base::OkStatus();
   }
 
   void ResetState() override { count_ = 0; }
@@ -100,6 +144,18 @@ class Count : public Algorithm<T> {
   std::size_t count_;
 
  private:
+  NoisyValue<int64_t> GenerateValue(double privacy_budget) {
+    NoisyValue<int64_t> result;
+    result.value = std::max<int64_t>(
+        std::round(mechanism_->AddNoise(count_, privacy_budget)), 0);
+    if (Algorithm<T>::ResultIncludes(kNoiseConfidenceInterval)) {
+      SetNoiseConfidenceInterval(
+          NoiseConfidenceInterval(kDefaultConfidenceLevel, privacy_budget),
+          &result);
+    }
+    return result;
+  }
+
   std::unique_ptr<LaplaceMechanism> mechanism_;
 };
 
@@ -19,6 +19,7 @@
 #include <memory>
 
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/arena.h"
 #include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
 #include "differential_privacy/proto/data.pb.h"
 #include "differential_privacy/proto/summary.pb.h"
@@ -38,6 +39,21 @@ using ::differential_privacy::base::testing::IsOkAndHolds;
 template <typename T>
 class CountTest : public testing::Test {};
 
+// Count that reports twice the number of inputs, by overriding only the result
+// hook of Algorithm.
+class DoubledCount : public Count<double> {
+ public:
+  DoubledCount()
+      : Count<double>(1.0, absl::make_unique<ZeroNoiseMechanism>(1.0, 1.0)) {}
+
+ protected:
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    AddToOutput<int64_t>(output, 2 * count_);
+    return base::OkStatus();
+  }
+};
+
 typedef ::testing::Types<int64_t, double> NumericTypes;
 TYPED_TEST_SUITE(CountTest, NumericTypes);
 
@@ -65,6 +81,68 @@ TYPED_TEST(CountTest, RepeatedResultTest) {
             GetValue<int64_t>(count->PartialResult(0.5).ValueOrDie()));
 }
 
+TYPED_TEST(CountTest, RemoveEntry) {
+  std::unique_ptr<Count<TypeParam>> count =
+      typename Count<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  EXPECT_EQ(count->RemoveEntry(1).code(),
+            base::StatusCode::kFailedPrecondition);
+  count->AddEntry(1);
+  count->AddEntry(2);
+  count->AddEntry(3);
+  EXPECT_OK(count->RemoveEntry(1));
+  EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()), 2);
+}
+
+TYPED_TEST(CountTest, AddColumnBatch) {
+  std::vector<TypeParam> values(100, 1);
+  std::vector<uint8_t> validity(13, 0xff);
+  validity[3] = 0x0f;
+  std::vector<int64_t> selection = {0, 24, 28, 99};
+  std::unique_ptr<Count<TypeParam>> count =
+      typename Count<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  ColumnBatch<TypeParam> batch;
+  batch.values = values;
+  batch.validity = validity.data();
+  count->AddColumnBatch(batch);
+  batch.selection = selection;
+  count->AddColumnBatch(batch);
+  EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()), 96 + 3);
+}
+
+TYPED_TEST(CountTest, AddColumnBatchEmptySelection) {
+  std::vector<TypeParam> values(100, 1);
+  std::vector<int64_t> selection;
+  std::unique_ptr<Count<TypeParam>> count =
+      typename Count<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  ColumnBatch<TypeParam> batch;
+  batch.values = values;
+  batch.selection = selection;
+  count->AddColumnBatch(batch);
+  EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()), 0);
+}
+
+TYPED_TEST(CountTest, AddEntryWithMultiplicity) {
+  std::unique_ptr<Count<TypeParam>> count =
+      typename Count<TypeParam>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  count->AddEntryWithMultiplicity(1, 1000000);
+  count->AddEntryWithMultiplicity(2, 0);
+  count->AddEntryWithMultiplicity(3, -5);
+  count->AddEntry(4);
+  EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()), 1000001);
+}
+
 TEST(CountTest, ConfidenceIntervalTest) {
   double epsilon = 0.5;
   double level = .95;
@@ -86,6 +164,42 @@ TEST(CountTest, ConfidenceIntervalTest) {
               EqualsProto(wantConfidenceInterval));
 }
 
+TEST(CountTest, NoResultOptionsOmitsConfidenceInterval) {
+  std::vector<double> c = {1, 2, 3};
+  std::unique_ptr<Count<double>> count =
+      Count<double>::Builder()
+          .SetResultOptions(kNoResultOptions)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  EXPECT_EQ(count->result_options(), kNoResultOptions);
+  Output output = count->Result(c.begin(), c.end()).ValueOrDie();
+  EXPECT_EQ(GetValue<int64_t>(output), 3);
+  EXPECT_FALSE(output.has_error_report());
+}
+
+TEST(CountTest, PartialValueTest) {
+  std::vector<double> c = {1, 2, 3, 4, 2, 3};
+  Count<double>::Builder builder;
+  builder.SetEpsilon(0.5).SetLaplaceMechanism(
+      absl::make_unique<ZeroNoiseMechanism::Builder>());
+  std::unique_ptr<Count<double>> count = builder.Build().ValueOrDie();
+  count->AddEntries(c.begin(), c.end());
+  NoisyValue<int64_t> value = count->PartialValue().ValueOrDie();
+  EXPECT_EQ(count->RemainingPrivacyBudget(), 0);
+  EXPECT_FALSE(count->PartialValue().ok());
+
+  std::unique_ptr<Count<double>> expected = builder.Build().ValueOrDie();
+  Output output = expected->Result(c.begin(), c.end()).ValueOrDie();
+  EXPECT_EQ(value.value, GetValue<int64_t>(output));
+  ASSERT_TRUE(value.has_noise_confidence_interval);
+  const ConfidenceInterval& interval =
+      output.error_report().noise_confidence_interval();
+  EXPECT_EQ(value.noise_lower_bound, interval.lower_bound());
+  EXPECT_EQ(value.noise_upper_bound, interval.upper_bound());
+  EXPECT_EQ(value.confidence_level, interval.confidence_level());
+}
+
 TEST(CountTest, SerializeTest) {
   std::unique_ptr<Count<double>> count =
       Count<double>::Builder().SetEpsilon(0.5).Build().ValueOrDie();
@@ -99,6 +213,36 @@ TEST(CountTest, SerializeTest) {
   EXPECT_EQ(count_summary.count(), 2);
 }
 
+TEST(CountTest, ArenaTest) {
+  std::vector<double> c = {1, 2, 3};
+  std::unique_ptr<Count<double>> count =
+      Count<double>::Builder()
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  google::protobuf::Arena arena;
+  Output* output = count->Result(c.begin(), c.end(), &arena).ValueOrDie();
+  EXPECT_EQ(output->GetArena(), &arena);
+  EXPECT_EQ(GetValue<int64_t>(*output), 3);
+  EXPECT_TRUE(output->error_report().has_noise_confidence_interval());
+
+  Summary* summary = count->Serialize(&arena);
+  EXPECT_EQ(summary->GetArena(), &arena);
+  CountSummary count_summary;
+  EXPECT_TRUE(summary->data().UnpackTo(&count_summary));
+  EXPECT_EQ(count_summary.count(), 3);
+}
+
+TEST(CountTest, SubclassResultUsedWithAndWithoutArena) {
+  DoubledCount count;
+  count.AddEntry(1);
+  count.AddEntry(2);
+  EXPECT_EQ(GetValue<int64_t>(count.PartialResult(0.5).ValueOrDie()), 4);
+  google::protobuf::Arena arena;
+  Output* output = count.PartialResult(0.5, &arena).ValueOrDie();
+  EXPECT_EQ(GetValue<int64_t>(*output), 4);
+}
+
 TEST(CountTest, MergeTest) {
   // Create summary.
   CountSummary count_summary;
@@ -118,6 +262,28 @@ TEST(CountTest, MergeTest) {
   EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()), 3);
 }
 
+TEST(CountTest, MergeAllTest) {
+  std::vector<Summary> summaries(100);
+  for (int i = 0; i < summaries.size(); ++i) {
+    CountSummary count_summary;
+    count_summary.set_count(i);
+    summaries[i].mutable_data()->PackFrom(count_summary);
+  }
+
+  for (int num_threads : {1, 4}) {
+    std::unique_ptr<Count<double>> count =
+        Count<double>::Builder()
+            .SetLaplaceMechanism(
+                absl::make_unique<ZeroNoiseMechanism::Builder>())
+            .Build()
+            .ValueOrDie();
+    count->AddEntry(0);
+    EXPECT_OK(count->MergeAll(summaries, num_threads));
+    EXPECT_EQ(GetValue<int64_t>(count->PartialResult().ValueOrDie()),
+              1 + 99 * 100 / 2);
+  }
+}
+
 TEST(CountTest, MemoryUsed) {
   std::unique_ptr<Count<double>> count =
       Count<double>::Builder().Build().ValueOrDie();
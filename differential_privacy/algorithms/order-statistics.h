@@ -17,6 +17,10 @@
 #ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_ORDER_STATISTICS_H_
 #define DIFFERENTIAL_PRIVACY_ALGORITHMS_ORDER_STATISTICS_H_
 
+#include <cmath>
+#include <vector>
+
+#include "differential_privacy/base/integer_percentile.h"
 #include "differential_privacy/base/percentile.h"
 #include "differential_privacy/algorithms/binary-search.h"
 #include "differential_privacy/algorithms/bounded-algorithm.h"
@@ -44,6 +48,19 @@ class OrderStatisticsBuilder
     return *static_cast<Builder*>(this);
   }
 
+  // Sets the container that collects the inputs and answers the rank queries
+  // of the search. Each algorithm built receives a clone of it. By default all
+  // inputs are kept exactly, in a base::IntegerPercentile for integers with
+  // small enough bounds and in a base::Percentile otherwise. A
+  // base::BucketedPercentile bounds memory and summary size by counting inputs
+  // in buckets of fixed width, at the cost of up to one bucket width of error.
+  // Noise is calibrated to a rank sensitivity of one, so adding or removing an
+  // input must change each rank count of the container by at most one.
+  Builder& SetRankSource(std::unique_ptr<base::Percentile<T>> rank_source) {
+    rank_source_ = std::move(rank_source);
+    return *static_cast<Builder*>(this);
+  }
+
  protected:
   // Check numeric parameters and construct quantiles and mechanism. Called
   // only at build.
@@ -59,11 +76,17 @@ class OrderStatisticsBuilder
                                      ->SetEpsilon(AlgorithmBuilder::epsilon_)
                                      .SetSensitivity(1)
                                      .Build());
-    quantiles_ = absl::make_unique<base::Percentile<T>>();
+    if (rank_source_) {
+      quantiles_ = rank_source_->Clone();
+    } else {
+      quantiles_ = base::MakeExactPercentile<T>(BoundedBuilder::lower_,
+                                                BoundedBuilder::upper_);
+    }
     return base::OkStatus();
   }
 
   int64_t datapoints_ = 50;
+  std::unique_ptr<base::Percentile<T>> rank_source_;
 
   // Constructed when processing parameters.
   std::unique_ptr<LaplaceMechanism> mechanism_;
@@ -172,7 +195,7 @@ class Percentile : public BinarySearch<T> {
    private:
     base::StatusOr<std::unique_ptr<Percentile<T>>> BuildAlgorithm() override {
       RETURN_IF_ERROR(OrderBuilder::ConstructDependencies());
-      if (percentile_ < 0 || percentile_ > 1) {
+      if (!(percentile_ >= 0 && percentile_ <= 1)) {
         return base::InvalidArgumentError(
             "Percentile must be between 0 and 1.");
       }
@@ -199,6 +222,117 @@ class Percentile : public BinarySearch<T> {
   const double percentile_;
 };
 
+// Releases several percentiles of the same inputs. All searches run over one
+// shared input set, which is stored and sorted once, instead of over a copy
+// per percentile. The privacy budget of each result is split between the
+// percentiles, evenly by default, and the output holds one element per
+// percentile in the order they were set. Confidence intervals of the
+// individual percentiles are not reported.
+template <typename T>
+class Quantiles : public BinarySearch<T> {
+ public:
+  class Builder : public OrderStatisticsBuilder<T, Quantiles<T>, Builder> {
+    using AlgorithmBuilder =
+        differential_privacy::AlgorithmBuilder<T, Quantiles<T>, Builder>;
+    using BoundedBuilder = BoundedAlgorithmBuilder<T, Quantiles<T>, Builder>;
+    using OrderBuilder = OrderStatisticsBuilder<T, Quantiles<T>, Builder>;
+
+   public:
+    Builder& SetPercentiles(std::vector<double> percentiles) {
+      percentiles_ = std::move(percentiles);
+      return *static_cast<Builder*>(this);
+    }
+
+    // Sets the relative share of the privacy budget spent on each percentile.
+    // Must have one positive weight per percentile.
+    Builder& SetBudgetSplit(std::vector<double> budget_split) {
+      budget_split_ = std::move(budget_split);
+      return *static_cast<Builder*>(this);
+    }
+
+   private:
+    base::StatusOr<std::unique_ptr<Quantiles<T>>> BuildAlgorithm() override {
+      RETURN_IF_ERROR(OrderBuilder::ConstructDependencies());
+      if (percentiles_.empty()) {
+        return base::InvalidArgumentError(
+            "At least one percentile must be set.");
+      }
+      for (double percentile : percentiles_) {
+        if (!(percentile >= 0 && percentile <= 1)) {
+          return base::InvalidArgumentError(
+              "Percentiles must be between 0 and 1.");
+        }
+      }
+      std::vector<double> fractions = budget_split_;
+      if (fractions.empty()) {
+        fractions.assign(percentiles_.size(), 1);
+      }
+      if (fractions.size() != percentiles_.size()) {
+        return base::InvalidArgumentError(
+            "Budget split must have one weight per percentile.");
+      }
+      double total = 0;
+      for (double weight : fractions) {
+        if (!(weight > 0) || std::isinf(weight)) {
+          return base::InvalidArgumentError(
+              "Budget split weights must be positive and finite.");
+        }
+        total += weight;
+      }
+      for (double& weight : fractions) {
+        weight /= total;
+      }
+      return absl::WrapUnique(new Quantiles(
+          percentiles_, std::move(fractions), AlgorithmBuilder::epsilon_,
+          BoundedBuilder::lower_, BoundedBuilder::upper_,
+          OrderBuilder::datapoints_, std::move(OrderBuilder::mechanism_),
+          std::move(OrderBuilder::quantiles_)));
+    }
+
+    std::vector<double> percentiles_;
+    std::vector<double> budget_split_;
+  };
+
+  const std::vector<double>& percentiles() { return percentiles_; }
+
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    DCHECK_GT(privacy_budget, 0.0)
+        << "Privacy budget should be greater than zero.";
+    if (privacy_budget == 0.0) return base::OkStatus();
+    for (int i = 0; i < percentiles_.size(); ++i) {
+      double result = BinarySearch<T>::BayesianSearch(
+          privacy_budget * budget_split_[i], percentiles_[i],
+          /*error=*/nullptr);
+      AddToOutput<T>(output, result);
+    }
+    return base::OkStatus();
+  }
+
+  int64_t MemoryUsed() override {
+    return BinarySearch<T>::MemoryUsed() +
+           sizeof(Quantiles<T>) - sizeof(BinarySearch<T>) +
+           sizeof(double) *
+               (percentiles_.capacity() + budget_split_.capacity());
+  }
+
+ private:
+  Quantiles(std::vector<double> percentiles, std::vector<double> budget_split,
+            double epsilon, T lower, T upper, int64_t datapoints,
+            std::unique_ptr<LaplaceMechanism> mechanism,
+            std::unique_ptr<base::Percentile<T>> quantiles)
+      : BinarySearch<T>(epsilon, lower, upper, datapoints,
+                        /*quantile=*/percentiles[0], std::move(mechanism),
+                        std::move(quantiles)),
+        percentiles_(std::move(percentiles)),
+        budget_split_(std::move(budget_split)) {}
+
+  const std::vector<double> percentiles_;
+
+  // Fraction of the privacy budget spent on each percentile. Sums to 1.
+  const std::vector<double> budget_split_;
+};
+
 }  // namespace continuous
 }  // namespace differential_privacy
 
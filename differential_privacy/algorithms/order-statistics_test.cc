@@ -16,8 +16,12 @@
 
 #include "differential_privacy/algorithms/order-statistics.h"
 
+#include <limits>
+
 #include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
 #include "differential_privacy/algorithms/util.h"
+#include "differential_privacy/base/bucketed_percentile.h"
+#include "differential_privacy/base/testing/proto_matchers.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/random/distributions.h"
@@ -27,6 +31,7 @@ namespace continuous {
 namespace {
 
 using test_utils::ZeroNoiseMechanism;
+using ::differential_privacy::base::testing::EqualsProto;
 
 static constexpr size_t kDataSize = 10000;
 static constexpr size_t kStatsSize = 500;
@@ -142,6 +147,162 @@ TEST(OrderStatisticsTest, Median_DefaultBounds) {
   EXPECT_EQ(GetValue<int64_t>(search->PartialResult(1.0).ValueOrDie()), 100);
 }
 
+TEST(OrderStatisticsTest, Quantiles) {
+  double epsilon = DefaultEpsilon();
+  int64_t lower = 0, upper = 2048;
+  std::unique_ptr<Quantiles<int64_t>> search =
+      typename Quantiles<int64_t>::Builder()
+          .SetPercentiles({.5, .9, .95, .99})
+          .SetEpsilon(epsilon)
+          .SetLower(lower)
+          .SetUpper(upper)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  for (int64_t i = 0; i < kDataSize; ++i) {
+    search->AddEntry(std::round(static_cast<double>(200) * i / kDataSize));
+  }
+  Output output = search->PartialResult(1.0).ValueOrDie();
+  ASSERT_EQ(output.elements_size(), 4);
+  EXPECT_NEAR(output.elements(0).value().int_value(), 100, 2);
+  EXPECT_NEAR(output.elements(1).value().int_value(), 180, 2);
+  EXPECT_NEAR(output.elements(2).value().int_value(), 190, 2);
+  EXPECT_NEAR(output.elements(3).value().int_value(), 198, 2);
+}
+
+TEST(OrderStatisticsTest, QuantilesBudgetSplit) {
+  double epsilon = DefaultEpsilon();
+  std::unique_ptr<Quantiles<double>> search =
+      typename Quantiles<double>::Builder()
+          .SetPercentiles({.25, .75})
+          .SetBudgetSplit({1, 3})
+          .SetEpsilon(epsilon)
+          .SetLower(0)
+          .SetUpper(100)
+          .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+          .Build()
+          .ValueOrDie();
+  EXPECT_THAT(search->percentiles(), testing::ElementsAre(.25, .75));
+  for (int64_t i = 0; i < kDataSize; ++i) {
+    search->AddEntry(100.0 * i / kDataSize);
+  }
+  Output output = search->PartialResult(1.0).ValueOrDie();
+  ASSERT_EQ(output.elements_size(), 2);
+  EXPECT_NEAR(output.elements(0).value().float_value(), 25, 1);
+  EXPECT_NEAR(output.elements(1).value().float_value(), 75, 1);
+}
+
+TEST(OrderStatisticsTest, QuantilesInvalidParameters) {
+  typename Quantiles<double>::Builder builder;
+  builder.SetEpsilon(DefaultEpsilon()).SetLower(0).SetUpper(1);
+  EXPECT_FALSE(builder.Build().ok());
+  EXPECT_FALSE(builder.SetPercentiles({.5, 2}).Build().ok());
+  EXPECT_FALSE(
+      builder.SetPercentiles({.5, std::numeric_limits<double>::quiet_NaN()})
+          .Build()
+          .ok());
+  EXPECT_TRUE(builder.SetPercentiles({.5, .9}).Build().ok());
+  EXPECT_FALSE(builder.SetBudgetSplit({1}).Build().ok());
+  EXPECT_FALSE(builder.SetBudgetSplit({1, 0}).Build().ok());
+  EXPECT_TRUE(builder.SetBudgetSplit({1, 2}).Build().ok());
+}
+
+TEST(OrderStatisticsTest, MedianWithBucketedRankSource) {
+  double epsilon = DefaultEpsilon();
+  int64_t lower = 0, upper = 2048;
+  typename Median<int64_t>::Builder builder;
+  builder.SetEpsilon(epsilon)
+      .SetLower(lower)
+      .SetUpper(upper)
+      .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .SetRankSource(absl::make_unique<base::BucketedPercentile<int64_t>>(
+          lower, upper, /*num_buckets=*/1024));
+  std::unique_ptr<Median<int64_t>> search1 = builder.Build().ValueOrDie();
+  std::unique_ptr<Median<int64_t>> search2 = builder.Build().ValueOrDie();
+  for (int64_t i = 0; i < kDataSize; i += 2) {
+    search1->AddEntry(std::round(static_cast<double>(200) * i / kDataSize));
+    search2->AddEntry(
+        std::round(static_cast<double>(200) * (i + 1) / kDataSize));
+  }
+  Summary summary = search1->Serialize();
+  BinarySearchSummary bs_summary;
+  ASSERT_TRUE(summary.data().UnpackTo(&bs_summary));
+  EXPECT_EQ(bs_summary.int_input_size(), 0);
+  EXPECT_EQ(bs_summary.bucketed_histogram().bin_count_size(), 1024);
+
+  EXPECT_TRUE(search2->Merge(summary).ok());
+  EXPECT_NEAR(GetValue<int64_t>(search2->PartialResult(1.0).ValueOrDie()), 100,
+              2);
+}
+
+TEST(OrderStatisticsTest, MergeBucketedIntoExact) {
+  typename Median<double>::Builder builder;
+  builder.SetEpsilon(DefaultEpsilon()).SetLower(0).SetUpper(10);
+  std::unique_ptr<Median<double>> exact = builder.Build().ValueOrDie();
+  std::unique_ptr<Median<double>> bucketed =
+      builder
+          .SetRankSource(
+              absl::make_unique<base::BucketedPercentile<double>>(0, 10))
+          .Build()
+          .ValueOrDie();
+  bucketed->AddEntry(1);
+  exact->AddEntry(2);
+  EXPECT_FALSE(exact->Merge(bucketed->Serialize()).ok());
+  EXPECT_TRUE(bucketed->Merge(exact->Serialize()).ok());
+}
+
+// Adds the same batches with AddColumnBatch and AddEntry to medians with
+// rank_source, or the default rank source if it is null, and checks that they
+// serialize the same inputs.
+template <typename T>
+void ExpectAddColumnBatchMatchesAddEntry(
+    std::unique_ptr<base::Percentile<T>> rank_source) {
+  typename Median<T>::Builder builder;
+  builder.SetEpsilon(DefaultEpsilon())
+      .SetLower(0)
+      .SetUpper(100)
+      .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>());
+  if (rank_source) {
+    builder.SetRankSource(std::move(rank_source));
+  }
+  std::unique_ptr<Median<T>> batched = builder.Build().ValueOrDie();
+  std::unique_ptr<Median<T>> expected = builder.Build().ValueOrDie();
+
+  // More valid rows than are passed to the rank source at once.
+  std::vector<T> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back((i * 7919) % 101);
+  }
+  // Rows 1 and 4 of every 8 are null.
+  std::vector<uint8_t> validity(values.size() / 8, 0xed);
+  std::vector<int64_t> selection = {998, 3, 3, 17};
+  ColumnBatch<T> batch;
+  batch.values = values;
+  batched->AddColumnBatch(batch);
+  batch.validity = validity.data();
+  batched->AddColumnBatch(batch);
+  batch.selection = absl::MakeConstSpan(selection);
+  batched->AddColumnBatch(batch);
+
+  expected->AddEntries(values.begin(), values.end());
+  for (int i = 0; i < values.size(); ++i) {
+    if (i % 8 != 1 && i % 8 != 4) {
+      expected->AddEntry(values[i]);
+    }
+  }
+  for (int64_t i : {998, 3, 3}) {
+    expected->AddEntry(values[i]);
+  }
+  EXPECT_THAT(batched->Serialize(), EqualsProto(expected->Serialize()));
+}
+
+TEST(OrderStatisticsTest, AddColumnBatchMatchesAddEntry) {
+  ExpectAddColumnBatchMatchesAddEntry<double>(nullptr);
+  ExpectAddColumnBatchMatchesAddEntry<int64_t>(nullptr);
+  ExpectAddColumnBatchMatchesAddEntry<int64_t>(
+      absl::make_unique<base::BucketedPercentile<int64_t>>(0, 100, 16));
+}
+
 }  // namespace
 }  // namespace continuous
 }  // namespace differential_privacy
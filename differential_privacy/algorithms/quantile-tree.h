@@ -0,0 +1,400 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_QUANTILE_TREE_H_
+#define DIFFERENTIAL_PRIVACY_ALGORITHMS_QUANTILE_TREE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "google/protobuf/any.pb.h"
+#include "differential_privacy/algorithms/algorithm.h"
+#include "differential_privacy/algorithms/bounded-algorithm.h"
+#include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "differential_privacy/base/status.h"
+
+namespace differential_privacy {
+
+// Default parameters of the quantile tree.
+const int kDefaultTreeHeight = 4;
+const int kDefaultBranchingFactor = 16;
+
+// Upper limit on the number of leaves of the quantile tree.
+const int64_t kMaxQuantileTreeLeaves = int64_t{1} << 48;
+
+// Differentially private quantiles from a hierarchical histogram.
+//
+// The search range [lower, upper] is divided into branching_factor^tree_height
+// equally sized leaves. Every node of the tree counts the inputs that fall into
+// the leaves below it, so an input increments one node per level and the
+// counts have L1 sensitivity tree_height. Memory is bounded by the number of
+// nodes and, since only nonzero counts are stored, by the number of distinct
+// leaves that received inputs. Inputs are not stored, so trees can be built
+// over streaming or sharded data in fixed memory and merged.
+//
+// A result noises the tree once, with Laplace noise for each node. A quantile
+// is found by descending from the root, choosing at each level the child whose
+// noisy counts contain the quantile, and interpolating linearly within the
+// final leaf. Nodes are noised lazily as the descent visits them, so each
+// quantile costs O(tree_height * branching_factor). Since any number of
+// quantiles are post-processing of the same noisy tree, GetNoisyQuantile can be
+// called after a result without consuming more privacy budget.
+//
+// Results are accurate to roughly the width of a leaf when the counts of the
+// nodes visited are large compared to the noise.
+template <typename T>
+class QuantileTree : public Algorithm<T> {
+ public:
+  class Builder;
+
+  void AddEntry(const T& t) override {
+    if (std::isnan(static_cast<double>(t))) {
+      return;
+    }
+    int64_t position = LeafPosition(t);
+    for (int level = tree_height_; level >= 1; --level) {
+      ++counts_[level_offsets_[level] + position];
+      position /= branching_factor_;
+    }
+    noised_ = false;
+  }
+
+  void AddColumnBatch(const ColumnBatch<T>& batch) override {
+    ForEachValid(batch, [this](const T& t) { QuantileTree<T>::AddEntry(t); });
+  }
+
+  // Returns the given quantile of the noisy tree released by the most recent
+  // result. Must be called after a result and before more inputs are added.
+  base::StatusOr<T> GetNoisyQuantile(double quantile) {
+    if (!noised_) {
+      return base::FailedPreconditionError(
+          "A result must be generated before querying noisy quantiles.");
+    }
+    if (!(quantile >= 0 && quantile <= 1)) {
+      return base::InvalidArgumentError("Quantile must be between 0 and 1.");
+    }
+    return NoisyQuantile(quantile);
+  }
+
+  void SerializeTo(Summary* summary) override {
+    std::vector<std::pair<int64_t, int64_t>> nodes(counts_.begin(),
+                                                   counts_.end());
+    std::sort(nodes.begin(), nodes.end());
+    QuantileTreeSummary local;
+    QuantileTreeSummary* tree_summary =
+        ArenaOrLocal(summary->GetArena(), &local);
+    tree_summary->set_tree_height(tree_height_);
+    tree_summary->set_branching_factor(branching_factor_);
+    SetValue<T>(tree_summary->mutable_lower(), lower_);
+    SetValue<T>(tree_summary->mutable_upper(), upper_);
+    tree_summary->mutable_node_index()->Reserve(nodes.size());
+    tree_summary->mutable_node_count()->Reserve(nodes.size());
+    for (const auto& node : nodes) {
+      tree_summary->add_node_index(node.first);
+      tree_summary->add_node_count(node.second);
+    }
+    summary->mutable_data()->PackFrom(*tree_summary);
+  }
+
+  base::Status Merge(const Summary& summary) override {
+    if (!summary.has_data()) {
+      return base::InvalidArgumentError(
+          "Cannot merge summary with no quantile tree data.");
+    }
+    QuantileTreeSummary tree_summary;
+    if (!summary.data().UnpackTo(&tree_summary)) {
+      return base::InvalidArgumentError(
+          "Quantile tree summary unable to be unpacked.");
+    }
+    if (tree_summary.tree_height() != tree_height_ ||
+        tree_summary.branching_factor() != branching_factor_) {
+      return base::InvalidArgumentError(
+          "Merged quantile trees must have the same height and branching "
+          "factor.");
+    }
+    if (!tree_summary.has_lower() || !tree_summary.has_upper() ||
+        GetValue<T>(tree_summary.lower()) != lower_ ||
+        GetValue<T>(tree_summary.upper()) != upper_) {
+      return base::InvalidArgumentError(
+          "Merged quantile trees must have the same bounds.");
+    }
+    if (tree_summary.node_index_size() != tree_summary.node_count_size()) {
+      return base::InvalidArgumentError(
+          "Quantile tree summary must have one count per node.");
+    }
+    for (int64_t index : tree_summary.node_index()) {
+      if (index < 0 || index >= level_offsets_[tree_height_ + 1]) {
+        return base::InvalidArgumentError(
+            "Quantile tree summary node index is out of range.");
+      }
+    }
+    for (int64_t count : tree_summary.node_count()) {
+      if (count < 0) {
+        return base::InvalidArgumentError(
+            "Quantile tree summary node counts must be nonnegative.");
+      }
+    }
+    for (int i = 0; i < tree_summary.node_index_size(); ++i) {
+      counts_[tree_summary.node_index(i)] += tree_summary.node_count(i);
+    }
+    noised_ = false;
+    return base::OkStatus();
+  }
+
+  int64_t MemoryUsed() override {
+    int64_t memory = sizeof(QuantileTree<T>) +
+                     sizeof(int64_t) * level_offsets_.capacity() +
+                     sizeof(double) * percentiles_.capacity() +
+                     sizeof(double) * children_.capacity();
+    memory += (sizeof(std::pair<const int64_t, int64_t>) + 1) *
+              counts_.capacity();
+    memory += (sizeof(std::pair<const int64_t, double>) + 1) *
+              noisy_counts_.capacity();
+    if (mechanism_) {
+      memory += mechanism_->MemoryUsed();
+    }
+    return memory;
+  }
+
+  int tree_height() const { return tree_height_; }
+  int branching_factor() const { return branching_factor_; }
+  const std::vector<double>& percentiles() const { return percentiles_; }
+
+ protected:
+  QuantileTree(double epsilon, T lower, T upper, int tree_height,
+               int branching_factor, std::vector<double> percentiles,
+               std::unique_ptr<LaplaceMechanism> mechanism)
+      : Algorithm<T>(epsilon),
+        lower_(lower),
+        upper_(upper),
+        tree_height_(tree_height),
+        branching_factor_(branching_factor),
+        percentiles_(std::move(percentiles)),
+        mechanism_(std::move(mechanism)) {
+    // Nodes of level l are stored at [level_offsets_[l],
+    // level_offsets_[l + 1]).
+    level_offsets_.push_back(0);
+    level_offsets_.push_back(0);
+    int64_t level_size = 1;
+    for (int level = 1; level <= tree_height_; ++level) {
+      level_size *= branching_factor_;
+      level_offsets_.push_back(level_offsets_.back() + level_size);
+    }
+    num_leaves_ = level_size;
+    children_.resize(branching_factor_);
+  }
+
+  // Noises the tree and returns the configured percentiles of it, one element
+  // each.
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
+    DCHECK_GT(privacy_budget, 0.0)
+        << "Privacy budget should be greater than zero.";
+    if (privacy_budget == 0.0) return base::OkStatus();
+    noisy_counts_.clear();
+    noise_budget_ = privacy_budget;
+    noised_ = true;
+    for (double percentile : percentiles_) {
+      AddToOutput<T>(output, NoisyQuantile(percentile));
+    }
+    return base::OkStatus();
+  }
+
+  void ResetState() override {
+    counts_.clear();
+    noisy_counts_.clear();
+    noised_ = false;
+  }
+
+ private:
+  // Returns the position of the leaf containing t, after clamping t to the
+  // search range.
+  int64_t LeafPosition(const T& t) {
+    double lower = lower_;
+    double fraction =
+        (Clamp<T>(lower_, upper_, t) - lower) / (upper_ - lower);
+    return std::min<int64_t>(num_leaves_ - 1, fraction * num_leaves_);
+  }
+
+  // Returns the noisy count of a node, noising it on first access.
+  double NoisyCount(int64_t index) {
+    auto it = noisy_counts_.find(index);
+    if (it != noisy_counts_.end()) {
+      return it->second;
+    }
+    auto count = counts_.find(index);
+    double noisy_count = mechanism_->AddNoise(
+        count == counts_.end() ? 0 : count->second, noise_budget_);
+    noisy_counts_[index] = noisy_count;
+    return noisy_count;
+  }
+
+  T NoisyQuantile(double quantile) {
+    double lower = lower_;
+    double width = static_cast<double>(upper_) - lower_;
+    int64_t position = 0;
+    for (int level = 1; level <= tree_height_; ++level) {
+      // Negative noisy counts are treated as empty.
+      double total = 0;
+      for (int c = 0; c < branching_factor_; ++c) {
+        children_[c] = std::max(
+            0.0, NoisyCount(level_offsets_[level] +
+                            position * branching_factor_ + c));
+        total += children_[c];
+      }
+      if (total <= 0) {
+        // No signal below this node. Interpolate over the whole node.
+        break;
+      }
+
+      // Find the first nonempty child whose cumulative count reaches the
+      // target rank, and the quantile of the target within that child.
+      double target = quantile * total;
+      double cumulative = 0;
+      int child = 0;
+      for (int c = 0; c < branching_factor_; ++c) {
+        if (children_[c] <= 0) {
+          continue;
+        }
+        child = c;
+        if (cumulative + children_[c] >= target) {
+          break;
+        }
+        cumulative += children_[c];
+      }
+      quantile = std::min(
+          1.0, std::max(0.0, (target - cumulative) / children_[child]));
+      width /= branching_factor_;
+      lower += child * width;
+      position = position * branching_factor_ + child;
+    }
+    double result = lower + quantile * width;
+    if (std::is_integral<T>::value) {
+      result = std::round(result);
+    }
+    return Clamp<double>(lower_, upper_, result);
+  }
+
+  const T lower_;
+  const T upper_;
+  const int tree_height_;
+  const int branching_factor_;
+  const std::vector<double> percentiles_;
+  std::unique_ptr<LaplaceMechanism> mechanism_;
+
+  std::vector<int64_t> level_offsets_;
+  int64_t num_leaves_;
+
+  // Nonzero counts of the nodes below the root, by node index.
+  absl::flat_hash_map<int64_t, int64_t> counts_;
+
+  // Noisy counts of the nodes visited since the most recent result, and the
+  // privacy budget they were noised with.
+  absl::flat_hash_map<int64_t, double> noisy_counts_;
+  double noise_budget_ = 0;
+  bool noised_ = false;
+
+  // Noisy counts of the children of the node being descended.
+  std::vector<double> children_;
+};
+
+template <typename T>
+class QuantileTree<T>::Builder
+    : public BoundedAlgorithmBuilder<T, QuantileTree<T>,
+                                     QuantileTree<T>::Builder> {
+  using AlgorithmBuilder =
+      differential_privacy::AlgorithmBuilder<T, QuantileTree<T>,
+                                             QuantileTree<T>::Builder>;
+  using BoundedBuilder =
+      BoundedAlgorithmBuilder<T, QuantileTree<T>, QuantileTree<T>::Builder>;
+
+ public:
+  Builder& SetTreeHeight(int tree_height) {
+    tree_height_ = tree_height;
+    return *this;
+  }
+
+  Builder& SetBranchingFactor(int branching_factor) {
+    branching_factor_ = branching_factor;
+    return *this;
+  }
+
+  // Percentiles released by each result, in order. Defaults to the median.
+  Builder& SetPercentiles(std::vector<double> percentiles) {
+    percentiles_ = std::move(percentiles);
+    return *this;
+  }
+
+ private:
+  base::StatusOr<std::unique_ptr<QuantileTree<T>>> BuildAlgorithm() override {
+    if (!BoundedBuilder::has_lower_ || !BoundedBuilder::has_upper_) {
+      return base::InvalidArgumentError(
+          "Quantile tree requires manually set lower and upper bounds.");
+    }
+    if (!(BoundedBuilder::lower_ < BoundedBuilder::upper_)) {
+      return base::InvalidArgumentError(
+          "Lower bound must be less than upper bound.");
+    }
+    if (tree_height_ < 1) {
+      return base::InvalidArgumentError("Tree height must be at least 1.");
+    }
+    if (branching_factor_ < 2) {
+      return base::InvalidArgumentError(
+          "Branching factor must be at least 2.");
+    }
+    int64_t num_leaves = 1;
+    for (int level = 0; level < tree_height_; ++level) {
+      num_leaves *= branching_factor_;
+      if (num_leaves > kMaxQuantileTreeLeaves) {
+        return base::InvalidArgumentError(
+            "Quantile tree has too many leaves. Reduce the tree height or "
+            "branching factor.");
+      }
+    }
+    if (percentiles_.empty()) {
+      return base::InvalidArgumentError(
+          "At least one percentile must be set.");
+    }
+    for (double percentile : percentiles_) {
+      if (!(percentile >= 0 && percentile <= 1)) {
+        return base::InvalidArgumentError(
+            "Percentiles must be between 0 and 1.");
+      }
+    }
+
+    // Each input contributes to one node per level.
+    std::unique_ptr<LaplaceMechanism> mechanism;
+    ASSIGN_OR_RETURN(mechanism, AlgorithmBuilder::laplace_mechanism_builder_
+                                    ->SetEpsilon(AlgorithmBuilder::epsilon_)
+                                    .SetSensitivity(tree_height_)
+                                    .Build());
+    return absl::WrapUnique(new QuantileTree<T>(
+        AlgorithmBuilder::epsilon_, BoundedBuilder::lower_,
+        BoundedBuilder::upper_, tree_height_, branching_factor_, percentiles_,
+        std::move(mechanism)));
+  }
+
+  int tree_height_ = kDefaultTreeHeight;
+  int branching_factor_ = kDefaultBranchingFactor;
+  std::vector<double> percentiles_ = {.5};
+};
+
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_ALGORITHMS_QUANTILE_TREE_H_
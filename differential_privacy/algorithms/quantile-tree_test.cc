@@ -0,0 +1,233 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/algorithms/quantile-tree.h"
+
+#include <limits>
+
+#include "differential_privacy/base/testing/proto_matchers.h"
+#include "differential_privacy/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
+
+namespace differential_privacy {
+namespace {
+
+using test_utils::ZeroNoiseMechanism;
+using ::differential_privacy::base::testing::EqualsProto;
+using ::testing::HasSubstr;
+using ::differential_privacy::base::testing::StatusIs;
+
+template <typename T>
+class QuantileTreeTest : public ::testing::Test {};
+
+typedef ::testing::Types<int64_t, double> NumericTypes;
+TYPED_TEST_SUITE(QuantileTreeTest, NumericTypes);
+
+Summary PackSummary(const QuantileTreeSummary& tree_summary) {
+  Summary summary;
+  summary.mutable_data()->PackFrom(tree_summary);
+  return summary;
+}
+
+template <typename T>
+std::unique_ptr<QuantileTree<T>> MakeTree(std::vector<double> percentiles) {
+  return typename QuantileTree<T>::Builder()
+      .SetEpsilon(1)
+      .SetLower(0)
+      .SetUpper(1000)
+      .SetPercentiles(std::move(percentiles))
+      .SetLaplaceMechanism(absl::make_unique<ZeroNoiseMechanism::Builder>())
+      .Build()
+      .ValueOrDie();
+}
+
+TYPED_TEST(QuantileTreeTest, Percentiles) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree =
+      MakeTree<TypeParam>({0, .25, .5, .9, 1});
+  for (int i = 0; i < 1000; ++i) {
+    tree->AddEntry(i);
+  }
+  Output output = tree->PartialResult().ValueOrDie();
+  ASSERT_EQ(output.elements_size(), 5);
+  EXPECT_NEAR(GetValue<TypeParam>(output.elements(0).value()), 0, 1);
+  EXPECT_NEAR(GetValue<TypeParam>(output.elements(1).value()), 250, 1);
+  EXPECT_NEAR(GetValue<TypeParam>(output.elements(2).value()), 500, 1);
+  EXPECT_NEAR(GetValue<TypeParam>(output.elements(3).value()), 900, 1);
+  EXPECT_NEAR(GetValue<TypeParam>(output.elements(4).value()), 1000, 1);
+}
+
+TYPED_TEST(QuantileTreeTest, AddColumnBatchMatchesAddEntry) {
+  std::vector<TypeParam> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back((i * 7919) % 1000);
+  }
+  // Rows 1 and 4 of every 8 are null.
+  std::vector<uint8_t> validity(values.size() / 8, 0xed);
+  std::unique_ptr<QuantileTree<TypeParam>> batched =
+      MakeTree<TypeParam>({.1, .5, .9});
+  std::unique_ptr<QuantileTree<TypeParam>> expected =
+      MakeTree<TypeParam>({.1, .5, .9});
+  ColumnBatch<TypeParam> batch;
+  batch.values = values;
+  batch.validity = validity.data();
+  batched->AddColumnBatch(batch);
+  for (int i = 0; i < values.size(); ++i) {
+    if (i % 8 != 1 && i % 8 != 4) {
+      expected->AddEntry(values[i]);
+    }
+  }
+  EXPECT_THAT(batched->PartialResult().ValueOrDie(),
+              EqualsProto(expected->PartialResult().ValueOrDie()));
+}
+
+TYPED_TEST(QuantileTreeTest, GetNoisyQuantile) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree = MakeTree<TypeParam>({.5});
+  for (int i = 0; i < 100; ++i) {
+    tree->AddEntry(100);
+    tree->AddEntry(700);
+  }
+  EXPECT_THAT(tree->GetNoisyQuantile(.5).status(),
+              StatusIs(base::StatusCode::kFailedPrecondition,
+                       HasSubstr("result must be generated")));
+  tree->PartialResult().ValueOrDie();
+  EXPECT_NEAR(tree->GetNoisyQuantile(.25).ValueOrDie(), 100, 1);
+  EXPECT_NEAR(tree->GetNoisyQuantile(.75).ValueOrDie(), 700, 1);
+  EXPECT_FALSE(tree->GetNoisyQuantile(2).ok());
+  EXPECT_FALSE(
+      tree->GetNoisyQuantile(std::numeric_limits<double>::quiet_NaN()).ok());
+
+  tree->AddEntry(1);
+  EXPECT_FALSE(tree->GetNoisyQuantile(.5).ok());
+}
+
+TYPED_TEST(QuantileTreeTest, ClampsInputs) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree = MakeTree<TypeParam>({0, 1});
+  tree->AddEntry(-50);
+  tree->AddEntry(5000);
+  Output output = tree->PartialResult().ValueOrDie();
+  EXPECT_GE(GetValue<TypeParam>(output.elements(0).value()), 0);
+  EXPECT_LE(GetValue<TypeParam>(output.elements(1).value()), 1000);
+}
+
+TYPED_TEST(QuantileTreeTest, SerializeMerge) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree1 = MakeTree<TypeParam>({.5});
+  std::unique_ptr<QuantileTree<TypeParam>> tree2 = MakeTree<TypeParam>({.5});
+  for (int i = 0; i < 500; ++i) {
+    tree1->AddEntry(i);
+    tree2->AddEntry(i + 500);
+  }
+  Summary summary = tree1->Serialize();
+  QuantileTreeSummary tree_summary;
+  ASSERT_TRUE(summary.data().UnpackTo(&tree_summary));
+  EXPECT_EQ(tree_summary.tree_height(), kDefaultTreeHeight);
+  EXPECT_EQ(tree_summary.node_index_size(), tree_summary.node_count_size());
+
+  EXPECT_OK(tree2->Merge(summary));
+  EXPECT_NEAR(GetValue<TypeParam>(tree2->PartialResult().ValueOrDie()), 500, 1);
+}
+
+TYPED_TEST(QuantileTreeTest, MergeErrors) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree = MakeTree<TypeParam>({.5});
+  std::unique_ptr<QuantileTree<TypeParam>> other =
+      typename QuantileTree<TypeParam>::Builder()
+          .SetLower(0)
+          .SetUpper(1000)
+          .SetTreeHeight(3)
+          .Build()
+          .ValueOrDie();
+  EXPECT_THAT(tree->Merge(other->Serialize()),
+              StatusIs(base::StatusCode::kInvalidArgument,
+                       HasSubstr("same height and branching factor")));
+  EXPECT_FALSE(tree->Merge(Summary()).ok());
+
+  std::unique_ptr<QuantileTree<TypeParam>> wider =
+      typename QuantileTree<TypeParam>::Builder()
+          .SetLower(0)
+          .SetUpper(1000000)
+          .Build()
+          .ValueOrDie();
+  wider->AddEntry(1);
+  EXPECT_THAT(tree->Merge(wider->Serialize()),
+              StatusIs(base::StatusCode::kInvalidArgument,
+                       HasSubstr("same bounds")));
+
+  QuantileTreeSummary tree_summary;
+  tree_summary.set_tree_height(kDefaultTreeHeight);
+  tree_summary.set_branching_factor(kDefaultBranchingFactor);
+  EXPECT_THAT(tree->Merge(PackSummary(tree_summary)),
+              StatusIs(base::StatusCode::kInvalidArgument,
+                       HasSubstr("same bounds")));
+
+  SetValue<TypeParam>(tree_summary.mutable_lower(), 0);
+  SetValue<TypeParam>(tree_summary.mutable_upper(), 1000);
+  tree_summary.add_node_index(-1);
+  tree_summary.add_node_count(1);
+  EXPECT_THAT(tree->Merge(PackSummary(tree_summary)),
+              StatusIs(base::StatusCode::kInvalidArgument,
+                       HasSubstr("out of range")));
+
+  tree_summary.set_node_index(0, 0);
+  tree_summary.set_node_count(0, -1);
+  EXPECT_THAT(tree->Merge(PackSummary(tree_summary)),
+              StatusIs(base::StatusCode::kInvalidArgument,
+                       HasSubstr("nonnegative")));
+}
+
+TYPED_TEST(QuantileTreeTest, BuildErrors) {
+  typename QuantileTree<TypeParam>::Builder builder;
+  EXPECT_FALSE(builder.Build().ok());
+  builder.SetLower(0).SetUpper(10);
+  EXPECT_OK(builder.Build().status());
+  EXPECT_FALSE(builder.SetLower(10).Build().ok());
+  builder.SetLower(0);
+  EXPECT_FALSE(builder.SetTreeHeight(0).Build().ok());
+  EXPECT_FALSE(builder.SetTreeHeight(100).Build().ok());
+  builder.SetTreeHeight(kDefaultTreeHeight);
+  EXPECT_FALSE(builder.SetBranchingFactor(1).Build().ok());
+  builder.SetBranchingFactor(kDefaultBranchingFactor);
+  EXPECT_FALSE(builder.SetPercentiles({}).Build().ok());
+  EXPECT_FALSE(builder.SetPercentiles({1.5}).Build().ok());
+  EXPECT_FALSE(
+      builder.SetPercentiles({std::numeric_limits<double>::quiet_NaN()})
+          .Build()
+          .ok());
+}
+
+TYPED_TEST(QuantileTreeTest, ResetAndMemory) {
+  std::unique_ptr<QuantileTree<TypeParam>> tree = MakeTree<TypeParam>({.5});
+  int64_t empty_memory = tree->MemoryUsed();
+  for (int i = 0; i < 1000; ++i) {
+    tree->AddEntry(i);
+  }
+  int64_t memory = tree->MemoryUsed();
+  EXPECT_GT(memory, empty_memory);
+
+  // Memory is bounded by the number of distinct leaves, not inputs.
+  for (int i = 0; i < 100000; ++i) {
+    tree->AddEntry(i % 1000);
+  }
+  EXPECT_EQ(tree->MemoryUsed(), memory);
+
+  tree->Reset();
+  QuantileTreeSummary tree_summary;
+  ASSERT_TRUE(tree->Serialize().data().UnpackTo(&tree_summary));
+  EXPECT_EQ(tree_summary.node_index_size(), 0);
+}
+
+}  // namespace
+}  // namespace differential_privacy
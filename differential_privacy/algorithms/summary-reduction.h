@@ -0,0 +1,135 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_SUMMARY_REDUCTION_H_
+#define DIFFERENTIAL_PRIVACY_ALGORITHMS_SUMMARY_REDUCTION_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "differential_privacy/proto/summary.pb.h"
+#include "absl/types/span.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/parallel.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/statusor.h"
+
+namespace differential_privacy {
+
+// Adds from to to elementwise. Both vectors must have the same size. The loop
+// runs over two distinct contiguous arrays, which compilers vectorize.
+template <typename V>
+void AddElementwise(const std::vector<V>& from, std::vector<V>* to) {
+  const V* in = from.data();
+  V* out = to->data();
+  const size_t size = to->size();
+  for (size_t i = 0; i < size; ++i) {
+    out[i] += in[i];
+  }
+}
+
+// Mergeable state of ApproxBounds and the bounded algorithms. Each algorithm
+// only uses some of the vectors and leaves the others empty.
+template <typename T>
+struct BoundedPartials {
+  int64_t count = 0;
+  std::vector<T> pos_sum;
+  std::vector<T> neg_sum;
+  std::vector<double> pos_sum_of_squares;
+  std::vector<double> neg_sum_of_squares;
+  std::vector<int64_t> pos_bin_count;
+  std::vector<int64_t> neg_bin_count;
+
+  // Adds other, whose vectors must have the same sizes as these.
+  void Add(const BoundedPartials& other) {
+    count += other.count;
+    AddElementwise(other.pos_sum, &pos_sum);
+    AddElementwise(other.neg_sum, &neg_sum);
+    AddElementwise(other.pos_sum_of_squares, &pos_sum_of_squares);
+    AddElementwise(other.neg_sum_of_squares, &neg_sum_of_squares);
+    AddElementwise(other.pos_bin_count, &pos_bin_count);
+    AddElementwise(other.neg_bin_count, &neg_bin_count);
+  }
+};
+
+// Reduces summaries whose data holds an algorithm summary of type S into one
+// Partials. The summaries are split into one contiguous chunk per thread. Each
+// thread unpacks the summaries of its chunk and adds them into a copy of empty
+// with accumulate, and the chunk partials are then combined pairwise in a tree
+// of depth log2(num_threads) with combine(from, to).
+//
+// Returns the error of the first summary, in order, that cannot be unpacked or
+// that accumulate rejects. Partials are only returned if all summaries are
+// valid, so callers can apply them without leaving a partial merge behind.
+template <typename S, typename Partials>
+base::StatusOr<Partials> ReduceSummaries(
+    absl::Span<const Summary> summaries, const Partials& empty,
+    const std::function<base::Status(const S&, Partials*)>& accumulate,
+    const std::function<void(const Partials&, Partials*)>& combine,
+    int num_threads) {
+  const int64_t num_summaries = summaries.size();
+  const int64_t num_chunks = std::max<int64_t>(
+      1, std::min<int64_t>(std::max(num_threads, 1), num_summaries));
+  const int64_t chunk_size = (num_summaries + num_chunks - 1) / num_chunks;
+  std::vector<Partials> partials(num_chunks, empty);
+  std::vector<base::Status> statuses(num_chunks);
+
+  // The same threads unpack the chunks and combine them at each level.
+  base::ThreadPool pool(num_chunks);
+  pool.ParallelFor(num_chunks, [&](int64_t chunk) {
+    S typed_summary;
+    const int64_t end = std::min(num_summaries, (chunk + 1) * chunk_size);
+    for (int64_t i = chunk * chunk_size; i < end; ++i) {
+      if (!summaries[i].has_data() ||
+          !summaries[i].data().UnpackTo(&typed_summary)) {
+        statuses[chunk] = base::InvalidArgumentError(
+            "Summary to merge does not hold data of this algorithm type.");
+        return;
+      }
+      base::Status status = accumulate(typed_summary, &partials[chunk]);
+      if (!status.ok()) {
+        statuses[chunk] = status;
+        return;
+      }
+    }
+  });
+  for (const base::Status& status : statuses) {
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  // At each level, chunk i absorbs chunk i + stride for every i that is a
+  // multiple of 2 * stride, so partials[0] holds the total at the end.
+  for (int64_t stride = 1; stride < num_chunks; stride *= 2) {
+    const int64_t num_pairs = (num_chunks + 2 * stride - 1) / (2 * stride);
+    pool.ParallelFor(num_pairs, [&](int64_t pair) {
+      const int64_t left = pair * 2 * stride;
+      const int64_t right = left + stride;
+      if (right < num_chunks) {
+        combine(partials[right], &partials[left]);
+      }
+    });
+  }
+  return std::move(partials[0]);
+}
+
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_ALGORITHMS_SUMMARY_REDUCTION_H_
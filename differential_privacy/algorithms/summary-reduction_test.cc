@@ -0,0 +1,102 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/algorithms/summary-reduction.h"
+
+#include <vector>
+
+#include "google/protobuf/any.pb.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "absl/strings/str_cat.h"
+#include "differential_privacy/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace {
+
+using ::differential_privacy::base::testing::IsOkAndHolds;
+using ::differential_privacy::base::testing::StatusIs;
+using ::testing::HasSubstr;
+
+std::vector<Summary> CountSummaries(int num_summaries) {
+  std::vector<Summary> summaries(num_summaries);
+  for (int i = 0; i < num_summaries; ++i) {
+    CountSummary count_summary;
+    count_summary.set_count(i);
+    summaries[i].mutable_data()->PackFrom(count_summary);
+  }
+  return summaries;
+}
+
+base::StatusOr<int64_t> ReduceCounts(const std::vector<Summary>& summaries,
+                                     int num_threads) {
+  return ReduceSummaries<CountSummary, int64_t>(
+      summaries, 0,
+      [](const CountSummary& count_summary, int64_t* count) {
+        if (count_summary.count() < 0) {
+          return base::InvalidArgumentError(
+              absl::StrCat("Negative count ", count_summary.count()));
+        }
+        *count += count_summary.count();
+        return base::OkStatus();
+      },
+      [](const int64_t& from, int64_t* to) { *to += from; }, num_threads);
+}
+
+TEST(SummaryReductionTest, AddElementwise) {
+  std::vector<int64_t> to = {1, 2, 3};
+  AddElementwise(std::vector<int64_t>{10, 20, 30}, &to);
+  EXPECT_THAT(to, testing::ElementsAre(11, 22, 33));
+}
+
+TEST(SummaryReductionTest, ReducesWithAnyNumberOfThreads) {
+  std::vector<Summary> summaries = CountSummaries(1000);
+  for (int num_threads : {1, 2, 3, 4, 7, 16}) {
+    EXPECT_THAT(ReduceCounts(summaries, num_threads),
+                IsOkAndHolds(999 * 1000 / 2));
+  }
+  EXPECT_THAT(ReduceCounts(CountSummaries(3), 8), IsOkAndHolds(3));
+}
+
+TEST(SummaryReductionTest, EmptyReturnsEmptyPartials) {
+  EXPECT_THAT(ReduceCounts({}, 4), IsOkAndHolds(0));
+}
+
+TEST(SummaryReductionTest, ReturnsFirstErrorInOrder) {
+  std::vector<Summary> summaries = CountSummaries(100);
+  for (int i : {30, 80}) {
+    CountSummary count_summary;
+    count_summary.set_count(-i);
+    summaries[i].mutable_data()->PackFrom(count_summary);
+  }
+  for (int num_threads : {1, 4}) {
+    EXPECT_THAT(ReduceCounts(summaries, num_threads).status(),
+                StatusIs(base::StatusCode::kInvalidArgument,
+                         HasSubstr("-30")));
+  }
+}
+
+TEST(SummaryReductionTest, RejectsSummaryOfOtherType) {
+  std::vector<Summary> summaries = CountSummaries(10);
+  summaries[5].mutable_data()->PackFrom(BoundedSumSummary());
+  EXPECT_FALSE(ReduceCounts(summaries, 4).ok());
+  summaries[5].clear_data();
+  EXPECT_FALSE(ReduceCounts(summaries, 4).ok());
+}
+
+}  // namespace
+}  // namespace differential_privacy
@@ -0,0 +1,237 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_ALGORITHMS_WINDOWED_AGGREGATOR_H_
+#define DIFFERENTIAL_PRIVACY_ALGORITHMS_WINDOWED_AGGREGATOR_H_
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "differential_privacy/algorithms/algorithm.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "absl/memory/memory.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/base/statusor.h"
+
+namespace differential_privacy {
+
+// Answers sliding-window queries over a stream of inputs that is divided into
+// buckets of a fixed time granularity, without re-ingesting raw inputs.
+//
+// The aggregator keeps a ring buffer of the last num_buckets sealed buckets.
+// Inputs are added to the open bucket until Advance() is called, which seals
+// the open bucket into the ring and starts a new one. Each sealed bucket is
+// stored as the Summary of the algorithm state it accumulated (counts, partial
+// sums, ApproxBounds bins, etc.), and a segment tree over the ring stores the
+// merged summaries of every aligned range of buckets. A query for the last n
+// buckets therefore merges O(log num_buckets) precomputed summaries into a
+// fresh algorithm instead of replaying every row in the window.
+//
+// For example, with 5 minute buckets and num_buckets = 288, Window(288) returns
+// an algorithm holding the last 24 hours of inputs, and Window(12) one holding
+// the last hour.
+//
+// Algorithm must be an Algorithm<T> whose summaries merge associatively, which
+// is true of all algorithms in this library. Every algorithm returned by
+// Window() has its full privacy budget. Inputs in overlapping windows are
+// released once per window, so privacy accounting across windows is the
+// responsibility of the caller.
+template <typename T, class Algorithm>
+class WindowedAggregator {
+ public:
+  // Returns a new algorithm with parameters identical to all other algorithms
+  // returned by the factory.
+  using AlgorithmFactory =
+      std::function<base::StatusOr<std::unique_ptr<Algorithm>>()>;
+
+  class Builder {
+   public:
+    // Number of sealed buckets kept in the ring. This is the largest window
+    // that can be queried.
+    Builder& SetNumBuckets(int64_t num_buckets) {
+      num_buckets_ = num_buckets;
+      return *this;
+    }
+
+    // Sets the factory used to construct the per-bucket algorithms and the
+    // algorithms returned by Window().
+    Builder& SetAlgorithmFactory(AlgorithmFactory factory) {
+      factory_ = std::move(factory);
+      return *this;
+    }
+
+    base::StatusOr<std::unique_ptr<WindowedAggregator>> Build() {
+      if (num_buckets_ < 1) {
+        return base::InvalidArgumentError(
+            "Number of buckets must be positive.");
+      }
+      if (!factory_) {
+        return base::InvalidArgumentError("Algorithm factory must be set.");
+      }
+      std::unique_ptr<Algorithm> current, scratch;
+      ASSIGN_OR_RETURN(current, factory_());
+      ASSIGN_OR_RETURN(scratch, factory_());
+      return absl::WrapUnique(new WindowedAggregator(
+          num_buckets_, factory_, std::move(current), std::move(scratch)));
+    }
+
+   private:
+    int64_t num_buckets_ = 0;
+    AlgorithmFactory factory_;
+  };
+
+  // Adds one input to the open bucket.
+  void AddEntry(const T& t) { current_->AddEntry(t); }
+
+  // Adds multiple inputs to the open bucket.
+  template <typename Iterator>
+  void AddEntries(Iterator begin, Iterator end) {
+    current_->AddEntries(begin, end);
+  }
+
+  // Seals the open bucket into the ring and starts a new, empty bucket. Once
+  // the ring is full, the oldest bucket is dropped.
+  base::Status Advance() {
+    int64_t leaf = leaf_offset_ + head_;
+    tree_[leaf] = current_->Serialize();
+    current_->Reset();
+    for (int64_t node = leaf / 2; node >= 1; node /= 2) {
+      RETURN_IF_ERROR(Combine(node));
+    }
+    head_ = (head_ + 1) % num_buckets_;
+    num_sealed_ = std::min(num_sealed_ + 1, num_buckets_);
+    return base::OkStatus();
+  }
+
+  // Returns a new algorithm containing the inputs of the num_buckets most
+  // recently sealed buckets. The open bucket is not included. If fewer buckets
+  // have been sealed, the window contains all sealed buckets.
+  base::StatusOr<std::unique_ptr<Algorithm>> Window(int64_t num_buckets) {
+    if (num_buckets < 1 || num_buckets > num_buckets_) {
+      return base::InvalidArgumentError(
+          "Window must contain between 1 and the number of buckets in the "
+          "ring.");
+    }
+    std::unique_ptr<Algorithm> window;
+    ASSIGN_OR_RETURN(window, factory_());
+
+    // The window occupies ring positions [head - n, head), which wrap around
+    // the end of the ring at most once.
+    int64_t n = std::min(num_buckets, num_sealed_);
+    int64_t begin = head_ - n;
+    if (begin < 0) {
+      RETURN_IF_ERROR(MergeRange(begin + num_buckets_, num_buckets_,
+                                 window.get()));
+      begin = 0;
+    }
+    RETURN_IF_ERROR(MergeRange(begin, head_, window.get()));
+    return window;
+  }
+
+  // Number of buckets in the ring.
+  int64_t num_buckets() const { return num_buckets_; }
+
+  // Number of buckets sealed so far, up to the number of buckets in the ring.
+  int64_t num_sealed() const { return num_sealed_; }
+
+  int64_t MemoryUsed() {
+    int64_t memory = sizeof(WindowedAggregator<T, Algorithm>) +
+                     sizeof(Summary) * tree_.capacity();
+    for (const Summary& summary : tree_) {
+      memory += summary.SpaceUsedLong() - sizeof(Summary);
+    }
+    memory += current_->MemoryUsed() + scratch_->MemoryUsed();
+    return memory;
+  }
+
+ private:
+  WindowedAggregator(int64_t num_buckets, AlgorithmFactory factory,
+                     std::unique_ptr<Algorithm> current,
+                     std::unique_ptr<Algorithm> scratch)
+      : num_buckets_(num_buckets),
+        factory_(std::move(factory)),
+        current_(std::move(current)),
+        scratch_(std::move(scratch)) {
+    // Leaves of the segment tree are stored at [leaf_offset_, 2 *
+    // leaf_offset_), and node i has children 2i and 2i + 1.
+    leaf_offset_ = 1;
+    while (leaf_offset_ < num_buckets_) {
+      leaf_offset_ *= 2;
+    }
+    tree_.resize(2 * leaf_offset_);
+  }
+
+  // Recomputes the summary of an internal node from its children. Empty
+  // summaries, i.e. of buckets that were never sealed, are skipped.
+  base::Status Combine(int64_t node) {
+    const Summary& left = tree_[2 * node];
+    const Summary& right = tree_[2 * node + 1];
+    if (!left.has_data() || !right.has_data()) {
+      tree_[node] = left.has_data() ? left : right;
+      return base::OkStatus();
+    }
+    scratch_->Reset();
+    RETURN_IF_ERROR(scratch_->Merge(left));
+    RETURN_IF_ERROR(scratch_->Merge(right));
+    tree_[node] = scratch_->Serialize();
+    return base::OkStatus();
+  }
+
+  // Merges the summaries of ring positions [begin, end) into the algorithm.
+  base::Status MergeRange(int64_t begin, int64_t end, Algorithm* algorithm) {
+    for (begin += leaf_offset_, end += leaf_offset_; begin < end;
+         begin /= 2, end /= 2) {
+      if (begin & 1) {
+        RETURN_IF_ERROR(MergeNode(begin++, algorithm));
+      }
+      if (end & 1) {
+        RETURN_IF_ERROR(MergeNode(--end, algorithm));
+      }
+    }
+    return base::OkStatus();
+  }
+
+  base::Status MergeNode(int64_t node, Algorithm* algorithm) {
+    if (!tree_[node].has_data()) {
+      return base::OkStatus();
+    }
+    return algorithm->Merge(tree_[node]);
+  }
+
+  const int64_t num_buckets_;
+  AlgorithmFactory factory_;
+
+  // Accumulates inputs of the open bucket.
+  std::unique_ptr<Algorithm> current_;
+
+  // Used to merge the summaries of sibling nodes. Never produces results.
+  std::unique_ptr<Algorithm> scratch_;
+
+  // Segment tree of merged bucket summaries.
+  std::vector<Summary> tree_;
+  int64_t leaf_offset_;
+
+  // Ring position the next sealed bucket is written to.
+  int64_t head_ = 0;
+  int64_t num_sealed_ = 0;
+};
+
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_ALGORITHMS_WINDOWED_AGGREGATOR_H_
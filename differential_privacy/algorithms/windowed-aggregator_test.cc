@@ -0,0 +1,148 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/algorithms/windowed-aggregator.h"
+
+#include <memory>
+
+#include "differential_privacy/algorithms/bounded-sum.h"
+#include "differential_privacy/algorithms/count.h"
+#include "differential_privacy/algorithms/numerical-mechanisms-testing.h"
+#include "differential_privacy/base/testing/status_matchers.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace {
+
+using test_utils::ZeroNoiseMechanism;
+using ::differential_privacy::base::testing::StatusIs;
+
+using CountWindows = WindowedAggregator<double, Count<double>>;
+
+std::unique_ptr<CountWindows> MakeCountWindows(int64_t num_buckets) {
+  return CountWindows::Builder()
+      .SetNumBuckets(num_buckets)
+      .SetAlgorithmFactory([]() {
+        return Count<double>::Builder()
+            .SetLaplaceMechanism(
+                absl::make_unique<ZeroNoiseMechanism::Builder>())
+            .Build();
+      })
+      .Build()
+      .ValueOrDie();
+}
+
+int64_t WindowCount(CountWindows* windows, int64_t num_buckets) {
+  std::unique_ptr<Count<double>> count =
+      windows->Window(num_buckets).ValueOrDie();
+  return GetValue<int64_t>(count->PartialResult().ValueOrDie());
+}
+
+TEST(WindowedAggregatorTest, BuildErrors) {
+  EXPECT_THAT(CountWindows::Builder()
+                  .SetNumBuckets(0)
+                  .SetAlgorithmFactory(
+                      []() { return Count<double>::Builder().Build(); })
+                  .Build()
+                  .status(),
+              StatusIs(base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(CountWindows::Builder()
+                  .SetNumBuckets(4)
+                  .Build()
+                  .status(),
+              StatusIs(base::StatusCode::kInvalidArgument));
+}
+
+TEST(WindowedAggregatorTest, WindowSizeErrors) {
+  auto windows = MakeCountWindows(4);
+  EXPECT_THAT(windows->Window(0).status(),
+              StatusIs(base::StatusCode::kInvalidArgument));
+  EXPECT_THAT(windows->Window(5).status(),
+              StatusIs(base::StatusCode::kInvalidArgument));
+}
+
+TEST(WindowedAggregatorTest, OpenBucketExcluded) {
+  auto windows = MakeCountWindows(4);
+  windows->AddEntry(1);
+  EXPECT_EQ(WindowCount(windows.get(), 4), 0);
+  EXPECT_OK(windows->Advance());
+  EXPECT_EQ(WindowCount(windows.get(), 4), 1);
+}
+
+TEST(WindowedAggregatorTest, SlidingWindowCounts) {
+  // Bucket i receives i + 1 entries.
+  const int64_t num_buckets = 5;
+  auto windows = MakeCountWindows(num_buckets);
+  std::vector<int64_t> bucket_sizes;
+  for (int64_t i = 0; i < 12; ++i) {
+    for (int64_t j = 0; j <= i; ++j) {
+      windows->AddEntry(j);
+    }
+    EXPECT_OK(windows->Advance());
+    bucket_sizes.push_back(i + 1);
+
+    // Compare every window size against the sum of the newest buckets.
+    for (int64_t n = 1; n <= num_buckets; ++n) {
+      int64_t expected = 0;
+      for (int64_t k = 0; k < n && k < bucket_sizes.size(); ++k) {
+        expected += bucket_sizes[bucket_sizes.size() - 1 - k];
+      }
+      EXPECT_EQ(WindowCount(windows.get(), n), expected)
+          << "after bucket " << i << " with window " << n;
+    }
+  }
+  EXPECT_EQ(windows->num_sealed(), num_buckets);
+}
+
+TEST(WindowedAggregatorTest, BoundedSumWindows) {
+  auto windows =
+      WindowedAggregator<int64_t, BoundedSum<int64_t>>::Builder()
+          .SetNumBuckets(3)
+          .SetAlgorithmFactory([]() {
+            return BoundedSum<int64_t>::Builder()
+                .SetLower(0)
+                .SetUpper(10)
+                .SetLaplaceMechanism(
+                    absl::make_unique<ZeroNoiseMechanism::Builder>())
+                .Build();
+          })
+          .Build()
+          .ValueOrDie();
+  std::vector<int64_t> first = {1, 2, 3};
+  std::vector<int64_t> second = {20, 5};
+  windows->AddEntries(first.begin(), first.end());
+  EXPECT_OK(windows->Advance());
+  windows->AddEntries(second.begin(), second.end());
+  EXPECT_OK(windows->Advance());
+
+  auto last = windows->Window(1).ValueOrDie();
+  EXPECT_EQ(GetValue<int64_t>(last->PartialResult().ValueOrDie()), 15);
+  auto both = windows->Window(2).ValueOrDie();
+  EXPECT_EQ(GetValue<int64_t>(both->PartialResult().ValueOrDie()), 21);
+}
+
+TEST(WindowedAggregatorTest, MemoryUsed) {
+  auto windows = MakeCountWindows(8);
+  int64_t empty_memory = windows->MemoryUsed();
+  EXPECT_GT(empty_memory, 0);
+  windows->AddEntry(1);
+  EXPECT_OK(windows->Advance());
+  EXPECT_GT(windows->MemoryUsed(), empty_memory);
+}
+
+}  // namespace
+}  // namespace differential_privacy
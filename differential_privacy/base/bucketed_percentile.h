@@ -0,0 +1,222 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_BUCKETED_PERCENTILE_H_
+#define DIFFERENTIAL_PRIVACY_BASE_BUCKETED_PERCENTILE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/percentile.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "differential_privacy/proto/util.h"
+
+namespace differential_privacy {
+namespace base {
+
+// Default number of buckets of a BucketedPercentile.
+const int64_t kDefaultNumBuckets = 1 << 12;
+
+// BucketedPercentile is a bounded-memory, mergeable replacement for Percentile.
+// Inputs are clamped to [lower, upper], which is split into buckets of equal
+// width, and only the number of inputs per bucket is kept. Memory and
+// serialized summaries are O(num_buckets) regardless of the number of inputs.
+//
+// Each input is treated as if it were equal to the lower edge of its bucket,
+// and ranks are exact for these rounded inputs. Since every input is rounded
+// independently of the others, adding or removing one input changes each rank
+// count by at most one, so order statistics keep their privacy guarantee. The
+// price is accuracy: results are off by up to one bucket width,
+// (upper - lower) / num_buckets, in addition to the noise.
+//
+// Bucketed histograms can only be merged with histograms of the same bounds
+// and number of buckets. Inputs stored by a Percentile can be merged into a
+// BucketedPercentile, but not the other way around.
+template <typename T>
+class BucketedPercentile : public Percentile<T> {
+ public:
+  // lower should be less than upper. If not, all inputs share one bucket.
+  BucketedPercentile(T lower, T upper, int64_t num_buckets = kDefaultNumBuckets)
+      : lower_(lower),
+        upper_(upper),
+        width_((static_cast<double>(upper) - lower) /
+               std::max<int64_t>(num_buckets, 1)),
+        counts_(std::max<int64_t>(num_buckets, 1), 0) {}
+
+  std::unique_ptr<Percentile<T>> Clone() const override {
+    return std::unique_ptr<Percentile<T>>(new BucketedPercentile<T>(*this));
+  }
+
+  void Add(const T& t) override {
+    if (!std::isnan(t)) {
+      ++counts_[Bucket(t)];
+      ++num_values_;
+      prefix_.clear();
+    }
+  }
+
+  void AddAll(absl::Span<const T> values) override {
+    for (const T& t : values) {
+      if (!std::isnan(t)) {
+        ++counts_[Bucket(t)];
+        ++num_values_;
+      }
+    }
+    prefix_.clear();
+  }
+
+  void Reset() override {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    prefix_.clear();
+    num_values_ = 0;
+  }
+
+  void SerializeToProto(BinarySearchSummary* summary) override {
+    BucketedHistogramSummary* histogram = summary->mutable_bucketed_histogram();
+    histogram->set_lower(lower_);
+    histogram->set_upper(upper_);
+    histogram->mutable_bin_count()->Reserve(counts_.size());
+    for (int64_t count : counts_) {
+      histogram->add_bin_count(count);
+    }
+  }
+
+  // Merges the bucketed histogram, the counting histogram and the stored inputs
+  // of the summary. The whole summary is validated before any of it is merged.
+  base::Status MergeFromProto(const BinarySearchSummary& summary) override {
+    ASSIGN_OR_RETURN(PackedValues<T> inputs,
+                     PackedValues<T>::Read(summary.int_input(),
+                                           summary.double_input(),
+                                           summary.input()));
+    const BucketedHistogramSummary& histogram = summary.bucketed_histogram();
+    int64_t histogram_size = 0;
+    if (summary.has_bucketed_histogram()) {
+      if (histogram.lower() != static_cast<double>(lower_) ||
+          histogram.upper() != static_cast<double>(upper_) ||
+          histogram.bin_count_size() != counts_.size()) {
+        return base::InvalidArgumentError(
+            "Bucketed histograms must have the same bounds and number of "
+            "buckets to be merged.");
+      }
+      for (int64_t count : histogram.bin_count()) {
+        if (count < 0) {
+          return base::InvalidArgumentError(
+              "Bucketed histogram counts must be nonnegative.");
+        }
+        if (count > std::numeric_limits<int64_t>::max() - histogram_size) {
+          return base::InvalidArgumentError(
+              "Bucketed histogram has too many inputs.");
+        }
+        histogram_size += count;
+      }
+    }
+    const CountingHistogramSummary& counting = summary.histogram();
+    if (summary.has_histogram()) {
+      ASSIGN_OR_RETURN(int64_t counting_size,
+                       Percentile<T>::ValidateHistogram(counting));
+      if (counting_size > std::numeric_limits<int64_t>::max() - histogram_size) {
+        return base::InvalidArgumentError(
+            "Bucketed histogram has too many inputs.");
+      }
+      histogram_size += counting_size;
+    }
+    if (histogram_size > std::numeric_limits<int64_t>::max() - num_values_ -
+                             inputs.size()) {
+      return base::InvalidArgumentError(
+          "Bucketed histogram has too many inputs.");
+    }
+    for (int i = 0; i < histogram.bin_count_size(); ++i) {
+      counts_[i] += histogram.bin_count(i);
+    }
+    // Each value counted by a counting histogram falls into a single bucket.
+    for (int i = 0; i < counting.bin_count_size(); ++i) {
+      counts_[Bucket(static_cast<T>(counting.lower() + i))] +=
+          counting.bin_count(i);
+    }
+    num_values_ += histogram_size;
+    prefix_.clear();
+    for (int i = 0; i < inputs.size(); ++i) {
+      Add(inputs[i]);
+    }
+    return base::OkStatus();
+  }
+
+  int64_t Memory() override {
+    return sizeof(BucketedPercentile<T>) +
+           sizeof(int64_t) * (counts_.capacity() + prefix_.capacity());
+  }
+
+  int64_t num_values() override { return num_values_; }
+
+  std::pair<double, double> GetRelativeRank(const T& t) override {
+    if (num_values_ == 0 || std::isnan(t)) {
+      return std::make_pair(0, 1);
+    }
+    if (t < lower_) {
+      return std::make_pair(0, 0);
+    }
+    if (prefix_.empty()) {
+      // prefix_[i] is the number of inputs in buckets before the i-th.
+      prefix_.reserve(counts_.size() + 1);
+      prefix_.push_back(0);
+      for (int64_t count : counts_) {
+        prefix_.push_back(prefix_.back() + count);
+      }
+    }
+    int64_t bucket = Bucket(t);
+    double num_le = prefix_[bucket + 1];
+    double num_lt = BucketLower(bucket) < t ? num_le : prefix_[bucket];
+    return std::make_pair(num_lt / num_values_, num_le / num_values_);
+  }
+
+  T lower() const { return lower_; }
+  T upper() const { return upper_; }
+  int64_t num_buckets() const { return counts_.size(); }
+
+ private:
+  // Returns the bucket of t after clamping it to [lower_, upper_].
+  int64_t Bucket(const T& t) const {
+    if (!(t > lower_) || width_ == 0) {
+      return 0;
+    }
+    double bucket = std::floor((static_cast<double>(t) - lower_) / width_);
+    return std::min<double>(bucket, counts_.size() - 1);
+  }
+
+  double BucketLower(int64_t bucket) const { return lower_ + bucket * width_; }
+
+  T lower_;
+  T upper_;
+  double width_;
+  std::vector<int64_t> counts_;
+  int64_t num_values_ = 0;
+
+  // Prefix sums of counts_, empty until the next rank query after a change.
+  std::vector<int64_t> prefix_;
+};
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_BUCKETED_PERCENTILE_H_
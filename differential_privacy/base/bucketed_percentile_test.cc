@@ -0,0 +1,222 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/bucketed_percentile.h"
+
+#include "differential_privacy/proto/summary.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+template <typename T>
+class BucketedPercentileTest : public ::testing::Test {};
+
+typedef ::testing::Types<int64_t, double> NumericTypes;
+TYPED_TEST_SUITE(BucketedPercentileTest, NumericTypes);
+
+TYPED_TEST(BucketedPercentileTest, EmptyInputSet) {
+  BucketedPercentile<TypeParam> percentile(0, 10);
+  EXPECT_EQ(percentile.num_values(), 0);
+  EXPECT_EQ(std::make_pair(0.0, 1.0), percentile.GetRelativeRank(1));
+}
+
+TYPED_TEST(BucketedPercentileTest, ExactOnBucketEdges) {
+  BucketedPercentile<TypeParam> percentile(0, 10, /*num_buckets=*/10);
+  percentile.Add(5);
+  percentile.Add(3);
+  percentile.Add(3);
+  percentile.Add(5);
+  percentile.Add(1);
+  EXPECT_EQ(percentile.num_values(), 5);
+  EXPECT_EQ(std::make_pair(0.0, 0.0), percentile.GetRelativeRank(-1));
+  EXPECT_EQ(std::make_pair(0.0, 0.2), percentile.GetRelativeRank(1));
+  EXPECT_EQ(std::make_pair(0.2, 0.6), percentile.GetRelativeRank(3));
+  EXPECT_EQ(std::make_pair(0.6, 0.6), percentile.GetRelativeRank(4));
+  EXPECT_EQ(std::make_pair(1.0, 1.0), percentile.GetRelativeRank(6));
+}
+
+TEST(BucketedPercentileTest, RoundsInputsToBucketLowerEdge) {
+  BucketedPercentile<double> percentile(0, 10, /*num_buckets=*/5);
+  percentile.Add(2.5);
+  percentile.Add(3.9);
+  percentile.Add(9);
+  // 2.5 and 3.9 are counted as 2, and 9 as 8.
+  EXPECT_EQ(std::make_pair(0.0, 2.0 / 3), percentile.GetRelativeRank(2));
+  EXPECT_EQ(std::make_pair(2.0 / 3, 2.0 / 3), percentile.GetRelativeRank(2.5));
+  EXPECT_EQ(std::make_pair(2.0 / 3, 1.0), percentile.GetRelativeRank(8));
+}
+
+TEST(BucketedPercentileTest, ClampsInputs) {
+  BucketedPercentile<double> percentile(0, 10, /*num_buckets=*/10);
+  percentile.Add(-100);
+  percentile.Add(100);
+  percentile.Add(10);
+  EXPECT_EQ(std::make_pair(0.0, 1.0 / 3), percentile.GetRelativeRank(0));
+  EXPECT_EQ(std::make_pair(1.0 / 3, 1.0), percentile.GetRelativeRank(9));
+  EXPECT_EQ(std::make_pair(1.0, 1.0), percentile.GetRelativeRank(10));
+}
+
+TEST(BucketedPercentileTest, IgnoresNan) {
+  BucketedPercentile<double> percentile(0, 10);
+  percentile.Add(std::nan(""));
+  EXPECT_EQ(percentile.num_values(), 0);
+}
+
+TEST(BucketedPercentileTest, AddingAnInputChangesRankCountsByAtMostOne) {
+  BucketedPercentile<double> percentile(-1, 1, /*num_buckets=*/7);
+  for (int i = 0; i < 100; ++i) {
+    percentile.Add(std::sin(i));
+  }
+  std::unique_ptr<Percentile<double>> neighbor = percentile.Clone();
+  neighbor->Add(0.3);
+  for (double t = -1.5; t <= 1.5; t += 0.01) {
+    std::pair<double, double> rank = percentile.GetRelativeRank(t);
+    std::pair<double, double> neighbor_rank = neighbor->GetRelativeRank(t);
+    EXPECT_LE(std::abs(rank.first * 100 - neighbor_rank.first * 101),
+              1 + 1e-9);
+    EXPECT_LE(std::abs(rank.second * 100 - neighbor_rank.second * 101),
+              1 + 1e-9);
+  }
+}
+
+TYPED_TEST(BucketedPercentileTest, MemoryIsBounded) {
+  BucketedPercentile<TypeParam> percentile(0, 1000, /*num_buckets=*/100);
+  int64_t memory = percentile.Memory();
+  for (int i = 0; i < 100000; ++i) {
+    percentile.Add(i % 1000);
+  }
+  percentile.GetRelativeRank(500);
+  EXPECT_EQ(percentile.num_values(), 100000);
+  EXPECT_LE(percentile.Memory(), memory + 101 * sizeof(int64_t));
+}
+
+TYPED_TEST(BucketedPercentileTest, SerializeMerge) {
+  BucketedPercentile<TypeParam> percentile1(0, 10, /*num_buckets=*/10);
+  percentile1.Add(4);
+  percentile1.Add(8);
+  BinarySearchSummary summary;
+  percentile1.SerializeToProto(&summary);
+  EXPECT_EQ(summary.input_size(), 0);
+  EXPECT_EQ(summary.bucketed_histogram().bin_count_size(), 10);
+
+  BucketedPercentile<TypeParam> percentile2(0, 10, /*num_buckets=*/10);
+  percentile2.Add(2);
+  EXPECT_TRUE(percentile2.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile2.num_values(), 3);
+  EXPECT_EQ(std::make_pair(1.0 / 3, 2.0 / 3), percentile2.GetRelativeRank(4));
+
+  Percentile<TypeParam> exact;
+  EXPECT_FALSE(exact.MergeFromProto(summary).ok());
+}
+
+TYPED_TEST(BucketedPercentileTest, MergeStoredInputs) {
+  Percentile<TypeParam> exact;
+  exact.Add(4);
+  BinarySearchSummary summary;
+  exact.SerializeToProto(&summary);
+
+  BucketedPercentile<TypeParam> percentile(0, 10, /*num_buckets=*/10);
+  percentile.Add(2);
+  EXPECT_TRUE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(std::make_pair(0.5, 1.0), percentile.GetRelativeRank(4));
+}
+
+TEST(BucketedPercentileTest, MergeCountingHistogram) {
+  BinarySearchSummary summary;
+  CountingHistogramSummary* histogram = summary.mutable_histogram();
+  histogram->set_lower(3);
+  histogram->set_upper(5);
+  histogram->add_bin_count(2);
+  histogram->add_bin_count(0);
+  histogram->add_bin_count(1);
+
+  BucketedPercentile<int64_t> percentile(0, 10, /*num_buckets=*/5);
+  percentile.Add(0);
+  EXPECT_TRUE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 4);
+  // 3 is counted as 2, and 5 as 4.
+  EXPECT_EQ(std::make_pair(0.25, 0.75), percentile.GetRelativeRank(2));
+  EXPECT_EQ(std::make_pair(0.75, 1.0), percentile.GetRelativeRank(4));
+
+  histogram->set_bin_count(1, -1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 4);
+}
+
+TEST(BucketedPercentileTest, MergeRejectsOtherBuckets) {
+  BucketedPercentile<double> percentile(0, 10, /*num_buckets=*/10);
+  BinarySearchSummary summary;
+  BucketedPercentile<double>(0, 20, /*num_buckets=*/10)
+      .SerializeToProto(&summary);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+
+  summary.Clear();
+  BucketedPercentile<double>(0, 10, /*num_buckets=*/5)
+      .SerializeToProto(&summary);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+}
+
+TEST(BucketedPercentileTest, MergeRejectsInvalidCounts) {
+  BucketedPercentile<double> percentile(0, 10, /*num_buckets=*/2);
+  percentile.Add(1);
+  BinarySearchSummary summary;
+  BucketedHistogramSummary* histogram = summary.mutable_bucketed_histogram();
+  histogram->set_lower(0);
+  histogram->set_upper(10);
+  histogram->add_bin_count(1);
+  histogram->add_bin_count(-1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+
+  histogram->set_bin_count(0, std::numeric_limits<int64_t>::max());
+  histogram->set_bin_count(1, 1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 1);
+}
+
+TEST(BucketedPercentileTest, MergeRejectsOtherInputType) {
+  BucketedPercentile<int64_t> percentile(0, 10);
+  BinarySearchSummary summary;
+  summary.add_double_input(1.5);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 0);
+}
+
+TYPED_TEST(BucketedPercentileTest, LegacyOverloads) {
+  BucketedPercentile<TypeParam> bucketed(0, 10);
+  Percentile<TypeParam>& percentile = bucketed;
+  percentile.Add(1);
+  google::protobuf::RepeatedPtrField<ValueType> values;
+  EXPECT_FALSE(percentile.SerializeToProto(&values).ok());
+
+  SetValue<TypeParam>(values.Add(), 4);
+  EXPECT_TRUE(percentile.MergeFromProto(values).ok());
+  EXPECT_EQ(percentile.num_values(), 2);
+}
+
+TYPED_TEST(BucketedPercentileTest, Reset) {
+  BucketedPercentile<TypeParam> percentile(0, 10);
+  percentile.Add(1);
+  percentile.Reset();
+  EXPECT_EQ(percentile.num_values(), 0);
+  EXPECT_EQ(std::make_pair(0.0, 1.0), percentile.GetRelativeRank(1));
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
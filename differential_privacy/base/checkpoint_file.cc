@@ -0,0 +1,219 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/checkpoint_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "absl/strings/str_cat.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/logging.h"
+#include "differential_privacy/base/parallel.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+constexpr char kMagic[8] = {'D', 'P', 'C', 'K', 'P', 'T', '\0', '\0'};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t config_hash;
+  uint64_t num_records;
+};
+static_assert(sizeof(Header) == 32, "Checkpoint header must be packed.");
+
+// Entries of the record table are key, offset and size.
+constexpr int64_t kEntrySize = 3 * sizeof(uint64_t);
+
+int64_t AlignUp(int64_t offset) { return (offset + 7) & ~int64_t{7}; }
+
+Status ErrnoError(absl::string_view action, const std::string& path) {
+  return InternalError(absl::StrCat("Failed to ", action, " ", path, ": ",
+                                    std::strerror(errno)));
+}
+
+}  // namespace
+
+uint64_t Fnv1aHash(absl::string_view data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+Status WriteCheckpointFile(const std::string& path, uint64_t config_hash,
+                           const std::vector<CheckpointMessage>& messages,
+                           int num_threads) {
+  // Lay out the records. ByteSizeLong caches the sizes that serialization
+  // into the mapping relies on.
+  const int64_t num_records = messages.size();
+  std::vector<uint64_t> table(3 * num_records);
+  int64_t size = sizeof(Header) + kEntrySize * num_records;
+  for (int64_t i = 0; i < num_records; ++i) {
+    size = AlignUp(size);
+    table[3 * i] = messages[i].first;
+    table[3 * i + 1] = size;
+    table[3 * i + 2] = messages[i].second->ByteSizeLong();
+    size += table[3 * i + 2];
+  }
+
+  const std::string temp_path = path + ".tmp";
+  int fd = open(temp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return ErrnoError("create", temp_path);
+  }
+  if (ftruncate(fd, size) != 0) {
+    Status status = ErrnoError("resize", temp_path);
+    close(fd);
+    return status;
+  }
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    Status status = ErrnoError("map", temp_path);
+    close(fd);
+    return status;
+  }
+
+  char* data = static_cast<char*>(mapping);
+  Header header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kCheckpointFormatVersion;
+  header.config_hash = config_hash;
+  header.num_records = num_records;
+  std::memcpy(data, &header, sizeof(Header));
+  std::memcpy(data + sizeof(Header), table.data(), kEntrySize * num_records);
+  ParallelFor(num_records, num_threads, [&](int64_t i) {
+    messages[i].second->SerializeWithCachedSizesToArray(
+        reinterpret_cast<uint8_t*>(data + table[3 * i + 1]));
+  });
+
+  bool synced = munmap(mapping, size) == 0 && fsync(fd) == 0;
+  Status status = synced ? OkStatus() : ErrnoError("write", temp_path);
+  if (close(fd) != 0 && status.ok()) {
+    status = ErrnoError("close", temp_path);
+  }
+  if (status.ok() && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    status = ErrnoError("rename", temp_path);
+  }
+  if (!status.ok()) {
+    unlink(temp_path.c_str());
+  }
+  return status;
+}
+
+StatusOr<std::unique_ptr<CheckpointFile>> CheckpointFile::Open(
+    const std::string& path, uint64_t config_hash) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ErrnoError("open", path);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    Status status = ErrnoError("stat", path);
+    close(fd);
+    return status;
+  }
+  const int64_t size = file_stat.st_size;
+  if (size < sizeof(Header)) {
+    close(fd);
+    return DataLossError(absl::StrCat(path, " is not a checkpoint file."));
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError("map", path);
+  }
+  const char* data = static_cast<const char*>(mapping);
+
+  // Validate the header and that all records lie within the file, so that
+  // record accessors need no checks.
+  Header header;
+  std::memcpy(&header, data, sizeof(Header));
+  Status status;
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    status = DataLossError(absl::StrCat(path, " is not a checkpoint file."));
+  } else if (header.version != kCheckpointFormatVersion) {
+    status = FailedPreconditionError(
+        absl::StrCat("Checkpoint format version ", header.version,
+                     " is not supported; expected version ",
+                     kCheckpointFormatVersion, "."));
+  } else if (header.config_hash != config_hash) {
+    status = FailedPreconditionError(
+        "Checkpoint was written with a different configuration.");
+  } else if (header.num_records >
+             (size - sizeof(Header)) / static_cast<uint64_t>(kEntrySize)) {
+    status = DataLossError("Checkpoint record table is truncated.");
+  } else {
+    const uint64_t* table =
+        reinterpret_cast<const uint64_t*>(data + sizeof(Header));
+    for (uint64_t i = 0; i < header.num_records; ++i) {
+      uint64_t offset = table[3 * i + 1];
+      uint64_t record_size = table[3 * i + 2];
+      if (offset > size || record_size > size - offset) {
+        status = DataLossError("Checkpoint record is truncated.");
+        break;
+      }
+    }
+  }
+  if (!status.ok()) {
+    munmap(mapping, size);
+    return status;
+  }
+  return std::unique_ptr<CheckpointFile>(
+      new CheckpointFile(data, size, header.num_records));
+}
+
+CheckpointFile::~CheckpointFile() {
+  munmap(const_cast<char*>(data_), size_);
+}
+
+Status CheckpointFile::ParseRecord(
+    int64_t index, google::protobuf::MessageLite* message) const {
+  if (index < 0 || index >= num_records_) {
+    return OutOfRangeError(absl::StrCat("Checkpoint record index ", index,
+                                        " is not in [0, ", num_records_,
+                                        ")."));
+  }
+  absl::string_view serialized = record(index);
+  if (!message->ParseFromArray(serialized.data(), serialized.size())) {
+    return DataLossError(
+        absl::StrCat("Checkpoint record ", index, " cannot be parsed."));
+  }
+  return OkStatus();
+}
+
+const uint64_t* CheckpointFile::Entry(int64_t index) const {
+  DCHECK_GE(index, 0);
+  DCHECK_LT(index, num_records_);
+  return reinterpret_cast<const uint64_t*>(data_ + sizeof(Header)) +
+         3 * index;
+}
+
+}  // namespace base
+}  // namespace differential_privacy
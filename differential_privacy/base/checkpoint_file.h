@@ -0,0 +1,112 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_CHECKPOINT_FILE_H_
+#define DIFFERENTIAL_PRIVACY_BASE_CHECKPOINT_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/message_lite.h"
+#include "absl/strings/string_view.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/statusor.h"
+
+namespace differential_privacy {
+namespace base {
+
+// Version of the checkpoint file format. Files of other versions are rejected.
+const uint32_t kCheckpointFormatVersion = 1;
+
+// Returns the 64-bit FNV-1a hash of data. The hash is stable across builds and
+// platforms, so it can fingerprint the configuration that checkpointed state
+// was created with, e.g. the serialized parameters of its algorithms.
+uint64_t Fnv1aHash(absl::string_view data);
+
+// A checkpoint file stores keyed, serialized messages in host byte order:
+//
+//   header:  uint64 magic, uint32 format version, uint32 reserved,
+//            uint64 config hash, uint64 number of records
+//   table:   per record, uint64 key, uint64 offset, uint64 size
+//   records: serialized messages, each starting at an 8-byte aligned offset
+//
+// Checkpoints are written in bulk by WriteCheckpointFile and read through a
+// read-only memory mapping by CheckpointFile, which parses records in place.
+// Keys identify records for the caller and need not be unique or sorted.
+
+// A message to checkpoint and its key.
+using CheckpointMessage =
+    std::pair<uint64_t, const google::protobuf::MessageLite*>;
+
+// Writes messages, each with its key, to path. The file is sized upfront and
+// memory-mapped, and messages are serialized directly into the mapping on up
+// to num_threads threads. The checkpoint is written to a temporary file that
+// is renamed to path once complete, so path never holds a partial checkpoint.
+base::Status WriteCheckpointFile(
+    const std::string& path, uint64_t config_hash,
+    const std::vector<CheckpointMessage>& messages, int num_threads);
+
+// Read-only view of a checkpoint file written by WriteCheckpointFile.
+class CheckpointFile {
+ public:
+  // Maps the file at path. Returns an error if the file is not a checkpoint of
+  // the current format version, was written with a different config_hash, or
+  // is truncated.
+  static base::StatusOr<std::unique_ptr<CheckpointFile>> Open(
+      const std::string& path, uint64_t config_hash);
+
+  ~CheckpointFile();
+
+  CheckpointFile(const CheckpointFile&) = delete;
+  CheckpointFile& operator=(const CheckpointFile&) = delete;
+
+  int64_t num_records() const { return num_records_; }
+
+  // Returns the key of the record at index, which must be in
+  // [0, num_records()).
+  uint64_t key(int64_t index) const { return Entry(index)[0]; }
+
+  // Returns the serialized message of the record at index, which must be in
+  // [0, num_records()). The view points into the mapping and is valid for the
+  // lifetime of this CheckpointFile.
+  absl::string_view record(int64_t index) const {
+    const uint64_t* entry = Entry(index);
+    return absl::string_view(data_ + entry[1], entry[2]);
+  }
+
+  // Parses the record at index into message. Returns an error if index is not
+  // in [0, num_records()) or the record cannot be parsed.
+  base::Status ParseRecord(int64_t index,
+                           google::protobuf::MessageLite* message) const;
+
+ private:
+  CheckpointFile(const char* data, int64_t size, int64_t num_records)
+      : data_(data), size_(size), num_records_(num_records) {}
+
+  const uint64_t* Entry(int64_t index) const;
+
+  const char* data_;
+  int64_t size_;
+  int64_t num_records_;
+};
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_CHECKPOINT_FILE_H_
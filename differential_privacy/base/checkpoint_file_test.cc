@@ -0,0 +1,152 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/checkpoint_file.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "differential_privacy/proto/summary.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+const uint64_t kConfigHash = 42;
+
+std::string TestPath(const std::string& name) {
+  return ::testing::TempDir() + "/" + name;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << contents;
+}
+
+// Writes a checkpoint of count summaries with counts 0, ..., n - 1 and keys
+// 1000, ..., 1000 + n - 1.
+void WriteCounts(const std::string& path, int n, int num_threads) {
+  std::vector<CountSummary> summaries(n);
+  std::vector<CheckpointMessage> messages;
+  for (int i = 0; i < n; ++i) {
+    summaries[i].set_count(i);
+    messages.push_back(std::make_pair(1000 + i, &summaries[i]));
+  }
+  ASSERT_TRUE(
+      WriteCheckpointFile(path, kConfigHash, messages, num_threads).ok());
+}
+
+TEST(CheckpointFileTest, Fnv1aHash) {
+  EXPECT_EQ(Fnv1aHash(""), 14695981039346656037ull);
+  EXPECT_EQ(Fnv1aHash("a"), 0xaf63dc4c8601ec8cull);
+  EXPECT_NE(Fnv1aHash("epsilon=1"), Fnv1aHash("epsilon=2"));
+}
+
+TEST(CheckpointFileTest, RoundTrip) {
+  const std::string path = TestPath("round_trip");
+  for (int num_threads : {1, 4}) {
+    WriteCounts(path, 100, num_threads);
+    StatusOr<std::unique_ptr<CheckpointFile>> checkpoint =
+        CheckpointFile::Open(path, kConfigHash);
+    ASSERT_TRUE(checkpoint.ok());
+    const CheckpointFile& file = *checkpoint.ValueOrDie();
+    ASSERT_EQ(file.num_records(), 100);
+    for (int i = 0; i < 100; ++i) {
+      EXPECT_EQ(file.key(i), 1000 + i);
+      CountSummary summary;
+      EXPECT_TRUE(file.ParseRecord(i, &summary).ok());
+      EXPECT_EQ(summary.count(), i);
+    }
+  }
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointFileTest, RejectsRecordIndexOutOfRange) {
+  const std::string path = TestPath("index_out_of_range");
+  WriteCounts(path, 3, 1);
+  StatusOr<std::unique_ptr<CheckpointFile>> checkpoint =
+      CheckpointFile::Open(path, kConfigHash);
+  ASSERT_TRUE(checkpoint.ok());
+  CountSummary summary;
+  for (int64_t index : {-1, 3, 1 << 30}) {
+    EXPECT_EQ(checkpoint.ValueOrDie()->ParseRecord(index, &summary).code(),
+              StatusCode::kOutOfRange);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointFileTest, Empty) {
+  const std::string path = TestPath("empty");
+  WriteCounts(path, 0, 1);
+  StatusOr<std::unique_ptr<CheckpointFile>> checkpoint =
+      CheckpointFile::Open(path, kConfigHash);
+  ASSERT_TRUE(checkpoint.ok());
+  EXPECT_EQ(checkpoint.ValueOrDie()->num_records(), 0);
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointFileTest, RejectsOtherConfig) {
+  const std::string path = TestPath("other_config");
+  WriteCounts(path, 3, 1);
+  EXPECT_EQ(CheckpointFile::Open(path, kConfigHash + 1).status().code(),
+            StatusCode::kFailedPrecondition);
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointFileTest, RejectsOtherVersion) {
+  const std::string path = TestPath("other_version");
+  WriteCounts(path, 3, 1);
+  std::string contents = ReadFile(path);
+  // The version follows the 8-byte magic.
+  contents[8] = kCheckpointFormatVersion + 1;
+  WriteFile(path, contents);
+  EXPECT_EQ(CheckpointFile::Open(path, kConfigHash).status().code(),
+            StatusCode::kFailedPrecondition);
+  std::remove(path.c_str());
+}
+
+TEST(CheckpointFileTest, RejectsCorruptFiles) {
+  const std::string path = TestPath("corrupt");
+  EXPECT_FALSE(CheckpointFile::Open(path, kConfigHash).ok());
+
+  WriteFile(path, "not a checkpoint file at all, but long enough");
+  EXPECT_EQ(CheckpointFile::Open(path, kConfigHash).status().code(),
+            StatusCode::kDataLoss);
+
+  WriteCounts(path, 3, 1);
+  std::string contents = ReadFile(path);
+  WriteFile(path, contents.substr(0, contents.size() - 1));
+  EXPECT_EQ(CheckpointFile::Open(path, kConfigHash).status().code(),
+            StatusCode::kDataLoss);
+
+  WriteFile(path, contents.substr(0, 40));
+  EXPECT_EQ(CheckpointFile::Open(path, kConfigHash).status().code(),
+            StatusCode::kDataLoss);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
@@ -0,0 +1,296 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_INTEGER_PERCENTILE_H_
+#define DIFFERENTIAL_PRIVACY_BASE_INTEGER_PERCENTILE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/percentile.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/proto/summary.pb.h"
+#include "differential_privacy/proto/util.h"
+
+namespace differential_privacy {
+namespace base {
+
+// Largest number of distinct values in the range of an IntegerPercentile.
+const int64_t kMaxCountingDomain = 1 << 16;
+
+// IntegerPercentile is an exact Percentile for integers that mostly fall into
+// a small range [lower, upper], such as latencies in milliseconds or ages.
+// Inputs are stored as in Percentile until there are more of them than values
+// in the range. From then on, inputs in the range are counted per value
+// instead of stored, so memory is O(min(n, upper - lower)), and relative ranks
+// of values in the range are O(1) lookups in a prefix sum of the counts.
+// Inputs outside of the range are always stored and searched as in
+// Percentile. Returned ranks are identical to those of Percentile.
+template <typename T>
+class IntegerPercentile : public Percentile<T> {
+  static_assert(std::is_integral<T>::value,
+                "IntegerPercentile requires integer inputs.");
+
+ public:
+  // Returns whether [lower, upper] is small enough to be counted per value.
+  static bool SupportsRange(T lower, T upper) {
+    return lower <= upper &&
+           static_cast<double>(upper) - lower + 1 <= kMaxCountingDomain;
+  }
+
+  // The range must be supported. Stored inputs are sorted on
+  // options.num_sort_threads threads.
+  IntegerPercentile(T lower, T upper,
+                    const PercentileOptions& options = PercentileOptions())
+      : lower_(lower),
+        upper_(upper),
+        range_size_(upper - lower + 1),
+        num_sort_threads_(options.num_sort_threads) {}
+
+  std::unique_ptr<Percentile<T>> Clone() const override {
+    return std::unique_ptr<Percentile<T>>(new IntegerPercentile<T>(*this));
+  }
+
+  void Add(const T& t) override { AddWithCount(t, 1); }
+
+  void AddAll(absl::Span<const T> values) override {
+    for (const T& t : values) {
+      AddWithCount(t, 1);
+    }
+  }
+
+  void Reset() override {
+    counts_.clear();
+    prefix_form_ = false;
+    num_counted_ = 0;
+    stored_.clear();
+    stored_sorted_ = true;
+  }
+
+  void SerializeToProto(BinarySearchSummary* summary) override {
+    if (!counts_.empty()) {
+      SetPrefixForm(false);
+      CountingHistogramSummary* histogram = summary->mutable_histogram();
+      histogram->set_lower(lower_);
+      histogram->set_upper(upper_);
+      histogram->mutable_bin_count()->Reserve(range_size_);
+      for (int64_t i = 0; i < range_size_; ++i) {
+        histogram->add_bin_count(counts_[i]);
+      }
+    }
+    AddPackedValues(stored_, summary->mutable_int_input(),
+                    summary->mutable_double_input());
+  }
+
+  base::Status MergeFromProto(const BinarySearchSummary& summary) override {
+    if (summary.has_bucketed_histogram()) {
+      return base::InvalidArgumentError(
+          "Cannot merge a bucketed histogram into an exact percentile.");
+    }
+    ASSIGN_OR_RETURN(PackedValues<T> inputs,
+                     PackedValues<T>::Read(summary.int_input(),
+                                           summary.double_input(),
+                                           summary.input()));
+    if (summary.has_histogram()) {
+      const CountingHistogramSummary& histogram = summary.histogram();
+      ASSIGN_OR_RETURN(int64_t histogram_size,
+                       Percentile<T>::ValidateHistogram(histogram));
+      if (histogram_size > std::numeric_limits<int64_t>::max() - num_counted_) {
+        return base::InvalidArgumentError(
+            "Counting histogram has too many inputs.");
+      }
+      // Bins outside of the range are stored one input at a time.
+      int64_t num_stored = 0;
+      for (int i = 0; i < histogram.bin_count_size(); ++i) {
+        if (!InRange(static_cast<T>(histogram.lower() + i))) {
+          num_stored += histogram.bin_count(i);
+        }
+      }
+      if (num_stored > kMaxExpandedHistogramSize) {
+        return base::InvalidArgumentError(
+            "Counting histogram has too many inputs to be stored.");
+      }
+      if (histogram.lower() == lower_ && histogram.upper() == upper_) {
+        if (counts_.empty()) {
+          StartCounting();
+        }
+        SetPrefixForm(false);
+        for (int64_t i = 0; i < range_size_; ++i) {
+          counts_[i] += histogram.bin_count(i);
+          num_counted_ += histogram.bin_count(i);
+        }
+      } else {
+        for (int i = 0; i < histogram.bin_count_size(); ++i) {
+          if (histogram.bin_count(i) > 0) {
+            AddWithCount(static_cast<T>(histogram.lower() + i),
+                         histogram.bin_count(i));
+          }
+        }
+      }
+    }
+    for (int i = 0; i < inputs.size(); ++i) {
+      Add(inputs[i]);
+    }
+    return base::OkStatus();
+  }
+
+  int64_t Memory() override {
+    return sizeof(IntegerPercentile<T>) +
+           sizeof(int64_t) * counts_.capacity() +
+           sizeof(T) * stored_.capacity();
+  }
+
+  int64_t num_values() override { return num_counted_ + stored_.size(); }
+
+  std::pair<double, double> GetRelativeRank(const T& t) override {
+    if (num_values() == 0) {
+      return std::make_pair(0, 1);
+    }
+    if (!stored_sorted_) {
+      internal::SortValues(&stored_, num_sort_threads_);
+      stored_sorted_ = true;
+    }
+    auto lb = std::lower_bound(stored_.begin(), stored_.end(), t);
+    auto ub = std::upper_bound(lb, stored_.end(), t);
+    double num_lt = std::distance(stored_.begin(), lb);
+    double num_le = std::distance(stored_.begin(), ub);
+
+    if (!counts_.empty()) {
+      SetPrefixForm(true);
+      if (t > upper_) {
+        num_lt += num_counted_;
+        num_le += num_counted_;
+      } else if (t >= lower_) {
+        num_lt += counts_[t - lower_];
+        num_le += counts_[t - lower_ + 1];
+      }
+    }
+    return std::make_pair(num_lt / num_values(), num_le / num_values());
+  }
+
+  T lower() const { return lower_; }
+  T upper() const { return upper_; }
+
+ private:
+  bool InRange(const T& t) const { return lower_ <= t && t <= upper_; }
+
+  // Adds count copies of t. Starts counting before storing more inputs than
+  // there are values in the range, so that an input in the range with a large
+  // count is never stored count times.
+  void AddWithCount(const T& t, int64_t count) {
+    if (counts_.empty() && InRange(t) &&
+        stored_.size() + count > range_size_) {
+      StartCounting();
+    }
+    if (!counts_.empty() && InRange(t)) {
+      SetPrefixForm(false);
+      counts_[t - lower_] += count;
+      num_counted_ += count;
+      return;
+    }
+    stored_.insert(stored_.end(), count, t);
+    stored_sorted_ = false;
+    if (counts_.empty() && stored_.size() > range_size_) {
+      StartCounting();
+    }
+  }
+
+  // Moves the stored inputs in the range into counts.
+  void StartCounting() {
+    counts_.assign(range_size_ + 1, 0);
+    prefix_form_ = false;
+    auto outside = std::partition(stored_.begin(), stored_.end(),
+                                  [this](const T& t) { return !InRange(t); });
+    for (auto it = outside; it != stored_.end(); ++it) {
+      ++counts_[*it - lower_];
+    }
+    num_counted_ = std::distance(outside, stored_.end());
+    stored_.erase(outside, stored_.end());
+    stored_.shrink_to_fit();
+    stored_sorted_ = false;
+  }
+
+  // In count form, counts_[i] is the number of counted inputs equal to
+  // lower_ + i. In prefix form, counts_[i] is the number of counted inputs less
+  // than lower_ + i. Rank queries use the prefix form and additions the count
+  // form, so each conversion is O(upper - lower) and only happens when queries
+  // and additions alternate.
+  void SetPrefixForm(bool prefix_form) {
+    if (prefix_form == prefix_form_) {
+      return;
+    }
+    if (prefix_form) {
+      int64_t sum = 0;
+      for (int64_t& count : counts_) {
+        int64_t value = count;
+        count = sum;
+        sum += value;
+      }
+    } else {
+      for (int64_t i = 0; i < range_size_; ++i) {
+        counts_[i] = counts_[i + 1] - counts_[i];
+      }
+      counts_[range_size_] = 0;
+    }
+    prefix_form_ = prefix_form;
+  }
+
+  T lower_;
+  T upper_;
+  int64_t range_size_;
+  int num_sort_threads_;
+
+  // Empty until the inputs outnumber the values in the range. Has one more
+  // entry than there are values in the range.
+  std::vector<int64_t> counts_;
+  bool prefix_form_ = false;
+  int64_t num_counted_ = 0;
+
+  // Inputs that are not counted.
+  std::vector<T> stored_;
+  bool stored_sorted_ = true;
+};
+
+// Returns an exact Percentile for inputs expected in [lower, upper]: an
+// IntegerPercentile for integers from a small enough range, and a Percentile
+// otherwise.
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+std::unique_ptr<Percentile<T>> MakeExactPercentile(T lower, T upper) {
+  if (IntegerPercentile<T>::SupportsRange(lower, upper)) {
+    return std::unique_ptr<Percentile<T>>(
+        new IntegerPercentile<T>(lower, upper));
+  }
+  return std::unique_ptr<Percentile<T>>(new Percentile<T>());
+}
+
+template <typename T,
+          typename std::enable_if<!std::is_integral<T>::value>::type* = nullptr>
+std::unique_ptr<Percentile<T>> MakeExactPercentile(T lower, T upper) {
+  return std::unique_ptr<Percentile<T>>(new Percentile<T>());
+}
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_INTEGER_PERCENTILE_H_
@@ -0,0 +1,199 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/integer_percentile.h"
+
+#include "differential_privacy/proto/summary.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+// Adds the same inputs to an IntegerPercentile and a Percentile, and checks
+// that they return the same ranks.
+void ExpectSameRanks(IntegerPercentile<int64_t>* integer_percentile,
+                     Percentile<int64_t>* percentile) {
+  EXPECT_EQ(integer_percentile->num_values(), percentile->num_values());
+  for (int64_t probe = -20; probe <= 1020; ++probe) {
+    EXPECT_EQ(integer_percentile->GetRelativeRank(probe),
+              percentile->GetRelativeRank(probe))
+        << "probe " << probe;
+  }
+}
+
+TEST(IntegerPercentileTest, SupportsRange) {
+  EXPECT_TRUE(IntegerPercentile<int64_t>::SupportsRange(0, 1000));
+  EXPECT_TRUE(IntegerPercentile<int64_t>::SupportsRange(5, 5));
+  EXPECT_FALSE(IntegerPercentile<int64_t>::SupportsRange(5, 4));
+  EXPECT_FALSE(IntegerPercentile<int64_t>::SupportsRange(
+      std::numeric_limits<int64_t>::lowest(),
+      std::numeric_limits<int64_t>::max()));
+}
+
+TEST(IntegerPercentileTest, EmptyInputSet) {
+  IntegerPercentile<int64_t> percentile(0, 10);
+  EXPECT_EQ(percentile.num_values(), 0);
+  EXPECT_EQ(std::make_pair(0.0, 1.0), percentile.GetRelativeRank(1));
+}
+
+TEST(IntegerPercentileTest, SmallInputSet) {
+  IntegerPercentile<int64_t> percentile(0, 1000);
+  Percentile<int64_t> expected;
+  for (int64_t value : {5, 3, 3, 5, 1}) {
+    percentile.Add(value);
+    expected.Add(value);
+  }
+  EXPECT_EQ(std::make_pair(0.2, 0.6), percentile.GetRelativeRank(3));
+  ExpectSameRanks(&percentile, &expected);
+}
+
+TEST(IntegerPercentileTest, CountsLargeInputSet) {
+  IntegerPercentile<int64_t> percentile(0, 1000);
+  Percentile<int64_t> expected;
+  for (int64_t i = 0; i < 100000; ++i) {
+    // Mostly in range, with some inputs below and above it.
+    int64_t value = (i * 7919) % 1040 - 20;
+    percentile.Add(value);
+    expected.Add(value);
+  }
+  ExpectSameRanks(&percentile, &expected);
+  EXPECT_LT(10 * percentile.Memory(), expected.Memory());
+
+  // Additions after queries are counted too.
+  for (int64_t value : {-5, 0, 500, 1000, 2000}) {
+    percentile.Add(value);
+    expected.Add(value);
+  }
+  ExpectSameRanks(&percentile, &expected);
+}
+
+TEST(IntegerPercentileTest, SortsOnSeveralThreads) {
+  PercentileOptions options;
+  options.num_sort_threads = 4;
+  IntegerPercentile<int64_t> percentile(0, 1000, options);
+  Percentile<int64_t> expected;
+  for (int64_t i = 0; i < 1000; ++i) {
+    int64_t value = (i * 7919) % 1040 - 20;
+    percentile.Add(value);
+    expected.Add(value);
+  }
+  ExpectSameRanks(&percentile, &expected);
+}
+
+TEST(IntegerPercentileTest, Reset) {
+  IntegerPercentile<int64_t> percentile(0, 10);
+  for (int64_t i = 0; i < 100; ++i) {
+    percentile.Add(i % 12);
+  }
+  percentile.Reset();
+  EXPECT_EQ(percentile.num_values(), 0);
+  percentile.Add(3);
+  EXPECT_EQ(std::make_pair(0.0, 1.0), percentile.GetRelativeRank(3));
+}
+
+TEST(IntegerPercentileTest, SerializeMerge) {
+  IntegerPercentile<int64_t> percentile1(0, 100), percentile2(0, 100);
+  Percentile<int64_t> expected;
+  for (int64_t i = 0; i < 1000; ++i) {
+    percentile1.Add(i % 110);
+    percentile2.Add(i % 90);
+    expected.Add(i % 110);
+    expected.Add(i % 90);
+  }
+  BinarySearchSummary summary;
+  percentile1.SerializeToProto(&summary);
+  EXPECT_TRUE(summary.has_histogram());
+  EXPECT_EQ(summary.histogram().bin_count_size(), 101);
+  EXPECT_GT(summary.int_input_size(), 0);
+
+  EXPECT_TRUE(percentile2.MergeFromProto(summary).ok());
+  ExpectSameRanks(&percentile2, &expected);
+
+  // Exact percentiles and integer percentiles with other ranges merge the
+  // counts as inputs.
+  Percentile<int64_t> exact;
+  EXPECT_TRUE(exact.MergeFromProto(summary).ok());
+  IntegerPercentile<int64_t> other_range(-5, 5);
+  EXPECT_TRUE(other_range.MergeFromProto(summary).ok());
+  for (int64_t probe : {-1, 0, 50, 100, 105}) {
+    EXPECT_EQ(exact.GetRelativeRank(probe),
+              percentile1.GetRelativeRank(probe));
+    EXPECT_EQ(other_range.GetRelativeRank(probe),
+              percentile1.GetRelativeRank(probe));
+  }
+}
+
+TEST(IntegerPercentileTest, MergeLargeCountsFromOtherRange) {
+  BinarySearchSummary summary;
+  summary.mutable_histogram()->set_lower(0);
+  summary.mutable_histogram()->set_upper(3);
+  for (int64_t count : {int64_t{1} << 40, int64_t{0}, int64_t{3},
+                        int64_t{1} << 40}) {
+    summary.mutable_histogram()->add_bin_count(count);
+  }
+
+  // Bins in the range are counted without storing their inputs.
+  IntegerPercentile<int64_t> percentile(-10, 2);
+  percentile.Add(-1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 1);
+  summary.mutable_histogram()->set_bin_count(3, 2);
+  EXPECT_TRUE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 1 + (int64_t{1} << 40) + 3 + 2);
+  EXPECT_LT(percentile.Memory(), 1 << 20);
+  std::pair<double, double> rank = percentile.GetRelativeRank(0);
+  EXPECT_NEAR(rank.first, 0, 1e-9);
+  EXPECT_NEAR(rank.second, 1, 1e-9);
+
+  // An exact percentile stores every input, so it rejects the histogram.
+  Percentile<int64_t> exact;
+  EXPECT_EQ(exact.MergeFromProto(summary).code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_EQ(exact.num_values(), 0);
+}
+
+TEST(IntegerPercentileTest, MergeErrors) {
+  IntegerPercentile<int64_t> percentile(0, 100);
+  BinarySearchSummary summary;
+  summary.mutable_histogram()->set_lower(0);
+  summary.mutable_histogram()->set_upper(1);
+  summary.mutable_histogram()->add_bin_count(1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+  summary.mutable_histogram()->add_bin_count(-1);
+  EXPECT_FALSE(percentile.MergeFromProto(summary).ok());
+
+  BinarySearchSummary bucketed_summary;
+  bucketed_summary.mutable_bucketed_histogram();
+  EXPECT_FALSE(percentile.MergeFromProto(bucketed_summary).ok());
+}
+
+TEST(IntegerPercentileTest, MakeExactPercentile) {
+  std::unique_ptr<Percentile<int64_t>> small = MakeExactPercentile<int64_t>(
+      0, 100);
+  EXPECT_NE(dynamic_cast<IntegerPercentile<int64_t>*>(small.get()), nullptr);
+  std::unique_ptr<Percentile<int64_t>> large = MakeExactPercentile<int64_t>(
+      0, int64_t{1} << 40);
+  EXPECT_EQ(dynamic_cast<IntegerPercentile<int64_t>*>(large.get()), nullptr);
+  std::unique_ptr<Percentile<double>> floating =
+      MakeExactPercentile<double>(0, 100);
+  EXPECT_NE(floating, nullptr);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
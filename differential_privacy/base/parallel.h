@@ -0,0 +1,147 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_PARALLEL_H_
+#define DIFFERENTIAL_PRIVACY_BASE_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace differential_privacy {
+namespace base {
+
+// A fixed set of threads that run the tasks of successive ParallelFor calls,
+// so that algorithms with several parallel phases, such as sorts, start their
+// threads once. The calling thread of ParallelFor runs tasks too, so a pool of
+// num_threads <= 1 starts no threads and runs all tasks inline.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads) {
+    for (int i = 1; i < num_threads; ++i) {
+      threads_.emplace_back([this] { RunWorker(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int num_threads() const { return threads_.size() + 1; }
+
+  // Calls fn(task) for each task in [0, num_tasks) on the threads of the pool
+  // and the calling thread, and returns once all calls have finished. Tasks
+  // must not depend on each other. Must not be called from a task, or from
+  // several threads at once.
+  void ParallelFor(int64_t num_tasks, const std::function<void(int64_t)>& fn) {
+    if (threads_.empty() || num_tasks <= 1) {
+      for (int64_t task = 0; task < num_tasks; ++task) {
+        fn(task);
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      fn_ = &fn;
+      num_tasks_ = num_tasks;
+      next_task_ = 0;
+      busy_workers_ = threads_.size();
+      ++generation_;
+    }
+    work_cv_.notify_all();
+    RunTasks(fn, num_tasks);
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+    fn_ = nullptr;
+  }
+
+ private:
+  // Runs the tasks of each ParallelFor call until the pool is destroyed.
+  void RunWorker() {
+    int64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      work_cv_.wait(lock, [this, generation] {
+        return stop_ || generation_ != generation;
+      });
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+      const std::function<void(int64_t)>& fn = *fn_;
+      const int64_t num_tasks = num_tasks_;
+      lock.unlock();
+      RunTasks(fn, num_tasks);
+      lock.lock();
+      if (--busy_workers_ == 0) {
+        done_cv_.notify_one();
+      }
+    }
+  }
+
+  // Claims and runs tasks until none are left.
+  void RunTasks(const std::function<void(int64_t)>& fn, int64_t num_tasks) {
+    for (int64_t task = next_task_++; task < num_tasks; task = next_task_++) {
+      fn(task);
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mu_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+
+  // The current ParallelFor call, numbered by generation_.
+  const std::function<void(int64_t)>* fn_ = nullptr;
+  int64_t num_tasks_ = 0;
+  int64_t generation_ = 0;
+  std::atomic<int64_t> next_task_{0};
+  int64_t busy_workers_ = 0;
+};
+
+// Calls fn(task) for each task in [0, num_tasks), spread over at most
+// num_threads threads, and returns once all calls have finished. The calling
+// thread runs tasks too; if num_threads <= 1 or there is a single task, all
+// tasks run inline. Tasks must not depend on each other. Starts and joins its
+// threads on every call, so algorithms with several parallel phases should
+// share a ThreadPool between them instead.
+inline void ParallelFor(int64_t num_tasks, int num_threads,
+                        const std::function<void(int64_t)>& fn) {
+  ThreadPool pool(std::min<int64_t>(num_threads, num_tasks));
+  pool.ParallelFor(num_tasks, fn);
+}
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_PARALLEL_H_
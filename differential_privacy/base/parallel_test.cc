@@ -0,0 +1,60 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+TEST(ParallelTest, RunsEachTaskOnce) {
+  for (int num_threads : {0, 1, 3, 16}) {
+    std::vector<int> runs(10, 0);
+    ParallelFor(runs.size(), num_threads, [&](int64_t task) { ++runs[task]; });
+    EXPECT_THAT(runs, ::testing::Each(1));
+  }
+}
+
+TEST(ParallelTest, ThreadPoolRunsEachTaskOfEachCallOnce) {
+  for (int num_threads : {0, 1, 3, 16}) {
+    ThreadPool pool(num_threads);
+    EXPECT_EQ(pool.num_threads(), std::max(num_threads, 1));
+    for (int num_tasks : {0, 1, 2, 10, 100}) {
+      std::vector<std::atomic<int>> runs(num_tasks);
+      pool.ParallelFor(num_tasks, [&](int64_t task) { ++runs[task]; });
+      for (const std::atomic<int>& run : runs) {
+        EXPECT_EQ(run, 1);
+      }
+    }
+  }
+}
+
+TEST(ParallelTest, NoTasks) {
+  int runs = 0;
+  ParallelFor(0, 4, [&](int64_t task) { ++runs; });
+  EXPECT_EQ(runs, 0);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
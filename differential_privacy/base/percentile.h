@@ -17,14 +17,73 @@
 #ifndef DIFFERENTIAL_PRIVACY_BASE_PERCENTILE_H_
 #define DIFFERENTIAL_PRIVACY_BASE_PERCENTILE_H_
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/repeated_field.h"
+#include "absl/types/span.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/radix_sort.h"
+#include "differential_privacy/base/sample_sort.h"
+#include "differential_privacy/base/status.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/base/statusor.h"
+#include "differential_privacy/proto/summary.pb.h"
 #include "differential_privacy/proto/util.h"
 
 namespace differential_privacy {
 namespace base {
 
+// Largest number of inputs a counting histogram may expand into when merged
+// into a container that stores its inputs one by one. Larger histograms are
+// rejected instead of allocated.
+const int64_t kMaxExpandedHistogramSize = int64_t{1} << 28;
+
+namespace internal {
+
+// Sorts integers with a radix sort and other types with a sample sort, on up
+// to num_threads threads. Both need a temporary copy of the values, so a
+// single thread sorts in place with std::sort instead.
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+void SortValues(std::vector<T>* values, int num_threads) {
+  if (num_threads <= 1) {
+    std::sort(values->begin(), values->end());
+    return;
+  }
+  RadixSort(values, num_threads);
+}
+
+template <typename T,
+          typename std::enable_if<!std::is_integral<T>::value>::type* = nullptr>
+void SortValues(std::vector<T>* values, int num_threads) {
+  ParallelSampleSort(values, num_threads);
+}
+
+}  // namespace internal
+
+struct PercentileOptions {
+  // Number of threads used to sort the inputs. By default, inputs are sorted
+  // on the calling thread, which is required where spawning threads is not
+  // allowed, e.g. in PostgreSQL backends. Small inputs are always sorted on
+  // the calling thread.
+  int num_sort_threads = 1;
+
+  // If true, the inputs are not sorted. Instead, each rank query partitions
+  // the inputs around the queried value, within the range left by previous
+  // queries. This is faster than sorting when few values are queried, or when
+  // queried values converge as in binary search.
+  bool lazy_partition = false;
+};
+
 // Percentile contains an underlying vector that stores an input set. Percentile
 // retrieves the relative rank of a value with respect to the input set.
 //
@@ -45,64 +104,289 @@ namespace base {
 // Adding inputs is an O(1) operation. Retrieving a percentile sorts the
 // underlying vector only if there has been an addition since the previous sort.
 // Thus, retrieving a percentile is O(nlog n) worst case and O(log n) if no
-// additional inputs have been added.
+// additional inputs have been added. When sorted on several threads, integer
+// inputs are radix sorted in O(n).
+//
+// After sorting, a sampled rank index is built over the inputs so that
+// repeated rank queries, as issued by binary search, touch a few contiguous
+// blocks instead of binary searching the entire vector.
+//
+// PercentileOptions can sort the inputs on several threads, or replace the
+// sort by partitioning the inputs lazily, introselect-style, around the
+// queried values only.
+//
+// Subclasses may store the input set differently, e.g. the bounded-memory
+// BucketedPercentile. Order statistics calibrate their noise to a rank
+// sensitivity of one, so adding or removing an input must change each returned
+// rank count by at most one.
 template <typename T>
 class Percentile {
  public:
   Percentile() {}
+  explicit Percentile(const PercentileOptions& options) : options_(options) {}
+  virtual ~Percentile() = default;
+
+  // Returns a new instance of the same type and configuration holding a copy of
+  // the inputs.
+  virtual std::unique_ptr<Percentile<T>> Clone() const {
+    return std::unique_ptr<Percentile<T>>(new Percentile<T>(*this));
+  }
 
-  void Add(const T& t) {
+  virtual void Add(const T& t) {
     if (!std::isnan(t)) {
       inputs_.push_back(t);
       sorted_ = false;
     }
   }
 
-  void Reset() {
+  // Adds each of values, as if by Add, with one virtual call for all of them.
+  virtual void AddAll(absl::Span<const T> values) {
+    inputs_.reserve(inputs_.size() + values.size());
+    for (const T& t : values) {
+      if (!std::isnan(t)) {
+        inputs_.push_back(t);
+      }
+    }
+    sorted_ = false;
+  }
+
+  virtual void Reset() {
     inputs_.clear();
+    index_.clear();
+    partitions_.clear();
     sorted_ = true;
   }
 
-  void SerializeToProto(google::protobuf::RepeatedPtrField<ValueType>* values) {
-    for (const T& t : inputs_) {
-      values->Add(MakeValueType(t));
+  // Serializes the input set as a list of values, the format of summaries
+  // written before BinarySearchSummary had packed fields. Goes through the
+  // virtual SerializeToProto below, and returns an error if the input set is
+  // counted rather than stored, e.g. by a BucketedPercentile.
+  base::Status SerializeToProto(
+      google::protobuf::RepeatedPtrField<ValueType>* values) {
+    BinarySearchSummary summary;
+    SerializeToProto(&summary);
+    if (summary.has_bucketed_histogram() || summary.has_histogram()) {
+      return base::InvalidArgumentError(
+          "Only stored inputs can be serialized as a list of values.");
     }
+    ASSIGN_OR_RETURN(PackedValues<T> inputs,
+                     PackedValues<T>::Read(summary.int_input(),
+                                           summary.double_input(),
+                                           summary.input()));
+    values->Reserve(values->size() + inputs.size());
+    for (int i = 0; i < inputs.size(); ++i) {
+      values->Add(MakeValueType(inputs[i]));
+    }
+    return base::OkStatus();
+  }
+
+  // Merges a list of values written by the overload above through the virtual
+  // MergeFromProto below.
+  base::Status MergeFromProto(
+      const google::protobuf::RepeatedPtrField<ValueType>& values) {
+    BinarySearchSummary summary;
+    *summary.mutable_input() = values;
+    return MergeFromProto(summary);
+  }
+
+  // Serializes the input set into the binary search summary.
+  virtual void SerializeToProto(BinarySearchSummary* summary) {
+    AddPackedValues(inputs_, summary->mutable_int_input(),
+                    summary->mutable_double_input());
   }
 
-  void MergeFromProto(google::protobuf::RepeatedPtrField<ValueType> values) {
-    for (const ValueType v : values) {
-      inputs_.push_back(GetValue<T>(v));
+  // Merges the input set serialized in the binary search summary. Returns an
+  // error if the summary holds a bucketed histogram, whose inputs are not
+  // known exactly.
+  virtual base::Status MergeFromProto(const BinarySearchSummary& summary) {
+    if (summary.has_bucketed_histogram()) {
+      return base::InvalidArgumentError(
+          "Cannot merge a bucketed histogram into a percentile that stores its "
+          "inputs.");
+    }
+    ASSIGN_OR_RETURN(PackedValues<T> inputs,
+                     PackedValues<T>::Read(summary.int_input(),
+                                           summary.double_input(),
+                                           summary.input()));
+    if (summary.has_histogram()) {
+      const CountingHistogramSummary& histogram = summary.histogram();
+      ASSIGN_OR_RETURN(int64_t histogram_size, ValidateHistogram(histogram));
+      if (histogram_size > kMaxExpandedHistogramSize) {
+        return base::InvalidArgumentError(
+            "Counting histogram has too many inputs to be stored.");
+      }
+      inputs_.reserve(inputs_.size() + histogram_size);
+      for (int i = 0; i < histogram.bin_count_size(); ++i) {
+        inputs_.insert(inputs_.end(), histogram.bin_count(i),
+                       static_cast<T>(histogram.lower() + i));
+      }
       sorted_ = false;
     }
+    inputs_.reserve(inputs_.size() + inputs.size());
+    for (int i = 0; i < inputs.size(); ++i) {
+      Percentile<T>::Add(inputs[i]);
+    }
+    return base::OkStatus();
   }
 
-  int64_t Memory() {
-    return sizeof(Percentile<T>) + sizeof(T) * inputs_.capacity();
+  virtual int64_t Memory() {
+    // Estimates the size of a map node as the entry and three pointers.
+    int64_t memory =
+        sizeof(Percentile<T>) + sizeof(T) * inputs_.capacity() +
+        sizeof(std::vector<T>) * index_.capacity() +
+        (sizeof(typename PartitionMap::value_type) + 3 * sizeof(void*)) *
+            partitions_.size();
+    for (const std::vector<T>& level : index_) {
+      memory += sizeof(T) * level.capacity();
+    }
+    return memory;
   }
 
-  int64_t num_values() { return inputs_.size(); }
+  virtual int64_t num_values() { return inputs_.size(); }
 
   // Obtain the relative rank of value t with respect to the added inputs.
-  std::pair<double, double> GetRelativeRank(const T& t) {
+  virtual std::pair<double, double> GetRelativeRank(const T& t) {
     if (num_values() == 0) {
       return std::make_pair(0, 1);
     }
 
+    if (options_.lazy_partition) {
+      if (!sorted_) {
+        partitions_.clear();
+        sorted_ = true;
+      }
+      if (std::isnan(t)) {
+        return std::make_pair(0, 1);
+      }
+      double num_lt = PartitionPoint(t, /*inclusive=*/false);
+      double num_le = PartitionPoint(t, /*inclusive=*/true);
+      return std::make_pair(num_lt / num_values(), num_le / num_values());
+    }
+
     // If something has been added since the last sort, sort again.
     if (!sorted_) {
-      std::sort(inputs_.begin(), inputs_.end());
+      internal::SortValues(&inputs_, options_.num_sort_threads);
+      BuildIndex();
       sorted_ = true;
     }
-    auto lb = std::lower_bound(inputs_.begin(), inputs_.end(), t);
-    auto ub = std::upper_bound(lb, inputs_.end(), t);
-    double num_lt = std::distance(inputs_.begin(), lb);
-    double num_le = std::distance(inputs_.begin(), ub);
+    double num_lt = IndexedRank(
+        t, [](const T& value, const T& t) { return value < t; });
+    double num_le = IndexedRank(
+        t, [](const T& value, const T& t) { return !(t < value); });
     return std::make_pair(num_lt / num_values(), num_le / num_values());
   }
 
+ protected:
+  // Returns the number of inputs counted by the histogram, or an error unless
+  // the histogram has one nonnegative count per value of its range and the
+  // counts add up to at most the largest int64_t.
+  static base::StatusOr<int64_t> ValidateHistogram(
+      const CountingHistogramSummary& histogram) {
+    if (histogram.upper() < histogram.lower() ||
+        histogram.upper() - static_cast<double>(histogram.lower()) + 1 !=
+            histogram.bin_count_size()) {
+      return base::InvalidArgumentError(
+          "Counting histogram must have one count per value of its range.");
+    }
+    int64_t size = 0;
+    for (int64_t count : histogram.bin_count()) {
+      if (count < 0) {
+        return base::InvalidArgumentError(
+            "Counting histogram counts must be nonnegative.");
+      }
+      if (count > std::numeric_limits<int64_t>::max() - size) {
+        return base::InvalidArgumentError(
+            "Counting histogram has too many inputs.");
+      }
+      size += count;
+    }
+    return size;
+  }
+
  private:
+  // Partition points of the inputs in lazy partition mode. The entry for key
+  // (v, inclusive) is the number of inputs less than v, or less than or equal
+  // to v if inclusive. Inputs before it satisfy that predicate, and inputs
+  // after it do not.
+  using PartitionMap = std::map<std::pair<T, bool>, int64_t>;
+
+  // Returns the number of inputs less than t, or less than or equal to t if
+  // inclusive. Partitions the inputs between the closest existing partition
+  // points around t, which shrinks as queries converge.
+  int64_t PartitionPoint(const T& t, bool inclusive) {
+    std::pair<T, bool> key(t, inclusive);
+    auto next = partitions_.lower_bound(key);
+    if (next != partitions_.end() && next->first == key) {
+      return next->second;
+    }
+    int64_t begin = next == partitions_.begin() ? 0 : std::prev(next)->second;
+    int64_t end = next == partitions_.end() ? inputs_.size() : next->second;
+    auto split = std::partition(
+        inputs_.begin() + begin, inputs_.begin() + end,
+        [&t, inclusive](const T& value) {
+          return inclusive ? !(t < value) : value < t;
+        });
+    int64_t point = std::distance(inputs_.begin(), split);
+    partitions_.emplace_hint(next, key, point);
+    return point;
+  }
+
+  // Number of entries of a level summarized by one entry of the level above.
+  static constexpr size_t kIndexFanout = 16;
+
+  // Builds the rank index over the sorted inputs. index_[0] holds every
+  // kIndexFanout-th input, and each following level every kIndexFanout-th
+  // entry of the level below, until a level fits in a single block.
+  void BuildIndex() {
+    index_.clear();
+    const std::vector<T>* below = &inputs_;
+    while (below->size() > kIndexFanout) {
+      std::vector<T> level;
+      level.reserve((below->size() + kIndexFanout - 1) / kIndexFanout);
+      for (size_t i = 0; i < below->size(); i += kIndexFanout) {
+        level.push_back((*below)[i]);
+      }
+      index_.push_back(std::move(level));
+      below = &index_.back();
+    }
+  }
+
+  // Returns the number of sorted inputs for which in_prefix(input, t) holds,
+  // where in_prefix is true for a prefix of the inputs. This is the distance
+  // from the beginning of the inputs to std::lower_bound for value < t and to
+  // std::upper_bound for !(t < value).
+  //
+  // The count in each level bounds the count in the level below to a single
+  // block of at most kIndexFanout entries, which is scanned without branches.
+  template <typename InPrefix>
+  size_t IndexedRank(const T& t, InPrefix in_prefix) const {
+    size_t count = 0;
+    for (int level = index_.size(); level >= 0; --level) {
+      const std::vector<T>& entries = level == 0 ? inputs_ : index_[level - 1];
+      size_t begin = 0;
+      size_t end = entries.size();
+      if (level < index_.size()) {
+        // entries[(count - 1) * kIndexFanout] is in the prefix and
+        // entries[count * kIndexFanout] is not.
+        begin = count == 0 ? 0 : (count - 1) * kIndexFanout + 1;
+        end = std::min(end, count * kIndexFanout);
+      }
+      size_t block_count = 0;
+      for (size_t i = begin; i < end; ++i) {
+        block_count += in_prefix(entries[i], t);
+      }
+      count = begin + block_count;
+    }
+    return count;
+  }
+
+  PercentileOptions options_;
   std::vector<T> inputs_;
   bool sorted_ = true;
+  PartitionMap partitions_;
+
+  // Sampled levels of the sorted inputs, from the finest to the coarsest.
+  std::vector<std::vector<T>> index_;
 };
 
 }  // namespace base
@@ -79,6 +79,82 @@ TYPED_TEST(PercentileTest, LargeInputSet) {
             percentile.GetRelativeRank(num_values));
 }
 
+TYPED_TEST(PercentileTest, IndexedRankMatchesBinarySearch) {
+  Percentile<TypeParam> percentile;
+  std::vector<TypeParam> sorted;
+  for (int64_t i = 0; i < 100000; ++i) {
+    TypeParam value = (i * 7919) % 4999;
+    percentile.Add(value);
+    sorted.push_back(value);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  for (int64_t probe = -1; probe <= 5000; probe += 7) {
+    double num_lt =
+        std::lower_bound(sorted.begin(), sorted.end(), probe) - sorted.begin();
+    double num_le =
+        std::upper_bound(sorted.begin(), sorted.end(), probe) - sorted.begin();
+    EXPECT_EQ(std::make_pair(num_lt / sorted.size(), num_le / sorted.size()),
+              percentile.GetRelativeRank(probe));
+  }
+
+  // Adding an input rebuilds the index.
+  percentile.Add(-10);
+  EXPECT_EQ(std::make_pair(1.0 / 100001, 1.0 / 100001),
+            percentile.GetRelativeRank(-1));
+}
+
+TYPED_TEST(PercentileTest, OptionsMatchDefault) {
+  PercentileOptions threaded;
+  threaded.num_sort_threads = 4;
+  PercentileOptions lazy;
+  lazy.lazy_partition = true;
+  Percentile<TypeParam> expected;
+  std::vector<Percentile<TypeParam>> percentiles = {
+      Percentile<TypeParam>(threaded), Percentile<TypeParam>(lazy)};
+  for (int64_t i = 0; i < 100000; ++i) {
+    TypeParam value = (i * 7919) % 4999;
+    expected.Add(value);
+    for (Percentile<TypeParam>& percentile : percentiles) {
+      percentile.Add(value);
+    }
+  }
+
+  // Probes converge on a value as in binary search, then jump around.
+  std::vector<TypeParam> probes = {2500, 1250, 1875, 1562, 1718, 1640, 1640,
+                                   -1,   5000, 0,    4998, 3000, 1641, 1639};
+  for (TypeParam probe : probes) {
+    for (Percentile<TypeParam>& percentile : percentiles) {
+      EXPECT_EQ(expected.GetRelativeRank(probe),
+                percentile.GetRelativeRank(probe));
+    }
+  }
+
+  // Adding an input invalidates previous partitions.
+  expected.Add(1640);
+  for (Percentile<TypeParam>& percentile : percentiles) {
+    percentile.Add(1640);
+    EXPECT_EQ(expected.GetRelativeRank(1640),
+              percentile.GetRelativeRank(1640));
+    EXPECT_EQ(expected.GetRelativeRank(1000),
+              percentile.GetRelativeRank(1000));
+  }
+}
+
+TEST(PercentileTest, AddAllMatchesAdd) {
+  std::vector<double> values = {5, 3, std::nan(""), 3, 5, 1};
+  Percentile<double> percentile;
+  Percentile<double> expected;
+  percentile.AddAll(values);
+  for (double value : values) {
+    expected.Add(value);
+  }
+  EXPECT_EQ(percentile.num_values(), 5);
+  for (double probe : {0, 1, 3, 4, 5, 6}) {
+    EXPECT_EQ(percentile.GetRelativeRank(probe),
+              expected.GetRelativeRank(probe));
+  }
+}
+
 TYPED_TEST(PercentileTest, Reset) {
   Percentile<TypeParam> percentile;
   percentile.Add(1);
@@ -98,16 +174,59 @@ TYPED_TEST(PercentileTest, SerializeMerge) {
   Percentile<TypeParam> percentile;
   percentile.Add(4);
   BinarySearchSummary summary;
-  percentile.SerializeToProto(summary.mutable_input());
+  EXPECT_TRUE(percentile.SerializeToProto(summary.mutable_input()).ok());
 
   Percentile<TypeParam> percentile2;
   percentile2.Add(2);
-  percentile2.MergeFromProto(summary.input());
+  EXPECT_TRUE(percentile2.MergeFromProto(summary.input()).ok());
   percentile2.Add(3);
   percentile2.Add(1);
   EXPECT_EQ(std::make_pair(.25, .5), percentile2.GetRelativeRank(2));
 }
 
+TYPED_TEST(PercentileTest, SerializeMergeSummary) {
+  Percentile<TypeParam> percentile;
+  percentile.Add(4);
+  BinarySearchSummary summary;
+  percentile.SerializeToProto(&summary);
+  EXPECT_EQ(summary.input_size(), 0);
+  EXPECT_EQ(summary.int_input_size() + summary.double_input_size(), 1);
+
+  Percentile<TypeParam> percentile2;
+  percentile2.Add(2);
+  EXPECT_TRUE(percentile2.MergeFromProto(summary).ok());
+  EXPECT_EQ(std::make_pair(.5, 1.0), percentile2.GetRelativeRank(4));
+
+  summary.mutable_bucketed_histogram()->add_bin_count(1);
+  EXPECT_FALSE(percentile2.MergeFromProto(summary).ok());
+}
+
+TYPED_TEST(PercentileTest, MergeLegacySummary) {
+  BinarySearchSummary summary;
+  SetValue<TypeParam>(summary.add_input(), 4);
+  SetValue<TypeParam>(summary.add_input(), 6);
+
+  Percentile<TypeParam> percentile;
+  percentile.Add(2);
+  EXPECT_TRUE(percentile.MergeFromProto(summary).ok());
+  EXPECT_EQ(percentile.num_values(), 3);
+  EXPECT_EQ(std::make_pair(1.0 / 3, 2.0 / 3), percentile.GetRelativeRank(4));
+}
+
+TEST(PercentileTest, MergeSummaryOfOtherType) {
+  BinarySearchSummary summary;
+  summary.add_int_input(4);
+  summary.mutable_histogram()->set_lower(0);
+  summary.mutable_histogram()->set_upper(0);
+  summary.mutable_histogram()->add_bin_count(1);
+
+  Percentile<double> percentile;
+  percentile.Add(2);
+  EXPECT_EQ(percentile.MergeFromProto(summary).code(),
+            StatusCode::kInvalidArgument);
+  EXPECT_EQ(percentile.num_values(), 1);
+}
+
 }  // namespace
 }  // namespace base
 }  // namespace differential_privacy
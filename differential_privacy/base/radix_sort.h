@@ -0,0 +1,133 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_RADIX_SORT_H_
+#define DIFFERENTIAL_PRIVACY_BASE_RADIX_SORT_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "differential_privacy/base/parallel.h"
+
+namespace differential_privacy {
+namespace base {
+
+// Inputs smaller than this are sorted with std::sort.
+const int64_t kRadixSortMinSize = 1 << 12;
+
+// Number of inputs sorted by each thread of the parallel radix sort.
+const int64_t kRadixSortChunkSize = 1 << 16;
+
+namespace internal {
+
+// Maps an integer to an unsigned key with the same order.
+template <typename T>
+typename std::make_unsigned<T>::type RadixKey(T value) {
+  using Key = typename std::make_unsigned<T>::type;
+  Key key = static_cast<Key>(value);
+  if (std::is_signed<T>::value) {
+    key ^= Key{1} << (std::numeric_limits<Key>::digits - 1);
+  }
+  return key;
+}
+
+}  // namespace internal
+
+// Sorts integers in ascending order with a least significant digit radix sort
+// on 8 bit digits, in O(n) time and with an O(n) temporary buffer. Digits that
+// are equal for all values, such as the high bytes of values from a small
+// range, are skipped. Each pass counts and scatters contiguous chunks of the
+// values on up to num_threads threads, by default on the calling thread only.
+// The threads are started once for all passes.
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+void RadixSort(std::vector<T>* values, int num_threads = 1) {
+  const int64_t n = values->size();
+  if (n < kRadixSortMinSize) {
+    std::sort(values->begin(), values->end());
+    return;
+  }
+  constexpr int kNumBuckets = 256;
+  constexpr int kNumDigits = sizeof(T);
+  using Histogram = std::array<int64_t, kNumBuckets>;
+
+  // A digit needs a pass unless every value has the same digit.
+  const auto first_key = internal::RadixKey((*values)[0]);
+  decltype(internal::RadixKey(T())) differs = 0;
+  for (const T& value : *values) {
+    differs |= internal::RadixKey(value) ^ first_key;
+  }
+
+  const int64_t num_chunks =
+      (n + kRadixSortChunkSize - 1) / kRadixSortChunkSize;
+  std::vector<Histogram> offsets(num_chunks);
+  std::vector<T> buffer(n);
+  std::vector<T>* from = values;
+  std::vector<T>* to = &buffer;
+  ThreadPool pool(std::min<int64_t>(num_threads, num_chunks));
+  for (int digit = 0; digit < kNumDigits; ++digit) {
+    if (((differs >> (8 * digit)) & 0xff) == 0) {
+      continue;
+    }
+    const int shift = 8 * digit;
+    auto bucket = [shift](T value) {
+      return (internal::RadixKey(value) >> shift) & 0xff;
+    };
+
+    // Count the digits of each chunk.
+    pool.ParallelFor(num_chunks, [&](int64_t chunk) {
+      Histogram& histogram = offsets[chunk];
+      histogram.fill(0);
+      int64_t end = std::min(n, (chunk + 1) * kRadixSortChunkSize);
+      for (int64_t i = chunk * kRadixSortChunkSize; i < end; ++i) {
+        ++histogram[bucket((*from)[i])];
+      }
+    });
+
+    // Turn the counts into the first output position of each digit in each
+    // chunk, so that the scatter is stable.
+    int64_t position = 0;
+    for (int b = 0; b < kNumBuckets; ++b) {
+      for (Histogram& histogram : offsets) {
+        int64_t count = histogram[b];
+        histogram[b] = position;
+        position += count;
+      }
+    }
+
+    pool.ParallelFor(num_chunks, [&](int64_t chunk) {
+      Histogram& histogram = offsets[chunk];
+      int64_t end = std::min(n, (chunk + 1) * kRadixSortChunkSize);
+      for (int64_t i = chunk * kRadixSortChunkSize; i < end; ++i) {
+        T value = (*from)[i];
+        (*to)[histogram[bucket(value)]++] = value;
+      }
+    });
+    std::swap(from, to);
+  }
+  if (from != values) {
+    values->swap(buffer);
+  }
+}
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_RADIX_SORT_H_
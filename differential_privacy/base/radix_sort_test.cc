@@ -0,0 +1,82 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/radix_sort.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+template <typename T>
+class RadixSortTest : public ::testing::Test {};
+
+typedef ::testing::Types<int32_t, int64_t, uint32_t, uint64_t> IntegerTypes;
+TYPED_TEST_SUITE(RadixSortTest, IntegerTypes);
+
+template <typename T>
+std::vector<T> Values(int64_t size, uint64_t multiplier) {
+  std::vector<T> values;
+  for (int64_t i = 0; i < size; ++i) {
+    values.push_back(static_cast<T>(i * multiplier));
+  }
+  return values;
+}
+
+template <typename T>
+void ExpectSorts(std::vector<T> values, int num_threads) {
+  std::vector<T> expected = values;
+  std::sort(expected.begin(), expected.end());
+  RadixSort(&values, num_threads);
+  EXPECT_EQ(values, expected);
+}
+
+TYPED_TEST(RadixSortTest, Small) {
+  ExpectSorts<TypeParam>({3, 1, 2, 1}, 1);
+  ExpectSorts<TypeParam>({}, 1);
+}
+
+TYPED_TEST(RadixSortTest, FullRange) {
+  // The multiplier scatters values over the whole range of the type,
+  // including negative values for signed types.
+  for (int num_threads : {1, 4}) {
+    ExpectSorts(Values<TypeParam>(300000, 0x9e3779b97f4a7c15), num_threads);
+  }
+}
+
+TYPED_TEST(RadixSortTest, SmallRange) {
+  for (int num_threads : {1, 4}) {
+    ExpectSorts(Values<TypeParam>(300000, 7919), num_threads);
+  }
+}
+
+TYPED_TEST(RadixSortTest, Extremes) {
+  std::vector<TypeParam> values(kRadixSortMinSize, 0);
+  values[1] = std::numeric_limits<TypeParam>::max();
+  values[2] = std::numeric_limits<TypeParam>::lowest();
+  values[3] = 1;
+  ExpectSorts(values, 2);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
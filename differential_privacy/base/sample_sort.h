@@ -0,0 +1,116 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_BASE_SAMPLE_SORT_H_
+#define DIFFERENTIAL_PRIVACY_BASE_SAMPLE_SORT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "differential_privacy/base/parallel.h"
+
+namespace differential_privacy {
+namespace base {
+
+// Inputs smaller than this are sorted with std::sort on the calling thread.
+const int64_t kSampleSortMinSize = 1 << 16;
+
+// Number of samples taken per bucket to choose the splitters.
+const int64_t kSampleSortOversampling = 64;
+
+// Sorts values in ascending order on up to num_threads threads with a sample
+// sort. Splitters are chosen from an evenly spaced sample of the values, which
+// divide the values into one bucket per thread. Each thread counts and then
+// scatters the values of a contiguous chunk into the buckets, and finally each
+// bucket is sorted with std::sort. The threads are started once and run all
+// three phases. Uses an O(n) temporary buffer. By default, or with
+// num_threads <= 1, sorts in place with std::sort.
+//
+// T must have a strict weak order under operator<, so floating point values
+// must not be NaN.
+template <typename T>
+void ParallelSampleSort(std::vector<T>* values, int num_threads = 1) {
+  const int64_t n = values->size();
+  if (num_threads <= 1 || n < kSampleSortMinSize) {
+    std::sort(values->begin(), values->end());
+    return;
+  }
+  const int64_t num_buckets = num_threads;
+  ThreadPool pool(num_threads);
+
+  // Choose num_buckets - 1 splitters from a sorted, evenly spaced sample.
+  const int64_t num_samples =
+      std::min(n, num_buckets * kSampleSortOversampling);
+  std::vector<T> samples;
+  samples.reserve(num_samples);
+  for (int64_t i = 0; i < num_samples; ++i) {
+    samples.push_back((*values)[i * (n / num_samples)]);
+  }
+  std::sort(samples.begin(), samples.end());
+  std::vector<T> splitters;
+  for (int64_t b = 1; b < num_buckets; ++b) {
+    splitters.push_back(samples[b * num_samples / num_buckets]);
+  }
+
+  // Values equal to a splitter go to the bucket after it.
+  auto bucket = [&splitters](const T& value) {
+    return std::upper_bound(splitters.begin(), splitters.end(), value) -
+           splitters.begin();
+  };
+
+  // offsets[chunk * num_buckets + b] is first the number of values of the
+  // chunk in bucket b, and then the position the chunk writes them to.
+  const int64_t chunk_size = (n + num_buckets - 1) / num_buckets;
+  std::vector<int64_t> offsets(num_buckets * num_buckets, 0);
+  pool.ParallelFor(num_buckets, [&](int64_t chunk) {
+    int64_t end = std::min(n, (chunk + 1) * chunk_size);
+    for (int64_t i = chunk * chunk_size; i < end; ++i) {
+      ++offsets[chunk * num_buckets + bucket((*values)[i])];
+    }
+  });
+  std::vector<int64_t> bucket_begin(num_buckets + 1, 0);
+  int64_t position = 0;
+  for (int64_t b = 0; b < num_buckets; ++b) {
+    bucket_begin[b] = position;
+    for (int64_t chunk = 0; chunk < num_buckets; ++chunk) {
+      int64_t count = offsets[chunk * num_buckets + b];
+      offsets[chunk * num_buckets + b] = position;
+      position += count;
+    }
+  }
+  bucket_begin[num_buckets] = n;
+
+  std::vector<T> buffer(n);
+  pool.ParallelFor(num_buckets, [&](int64_t chunk) {
+    int64_t end = std::min(n, (chunk + 1) * chunk_size);
+    for (int64_t i = chunk * chunk_size; i < end; ++i) {
+      const T& value = (*values)[i];
+      buffer[offsets[chunk * num_buckets + bucket(value)]++] = value;
+    }
+  });
+
+  pool.ParallelFor(num_buckets, [&](int64_t b) {
+    std::sort(buffer.begin() + bucket_begin[b],
+              buffer.begin() + bucket_begin[b + 1]);
+  });
+  values->swap(buffer);
+}
+
+}  // namespace base
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_BASE_SAMPLE_SORT_H_
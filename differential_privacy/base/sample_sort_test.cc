@@ -0,0 +1,72 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/base/sample_sort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace base {
+namespace {
+
+void ExpectSorts(std::vector<double> values, int num_threads) {
+  std::vector<double> expected = values;
+  std::sort(expected.begin(), expected.end());
+  ParallelSampleSort(&values, num_threads);
+  EXPECT_EQ(values, expected);
+}
+
+TEST(SampleSortTest, Small) {
+  ExpectSorts({3, 1, 2, 1}, 4);
+  ExpectSorts({}, 4);
+}
+
+TEST(SampleSortTest, Distinct) {
+  std::vector<double> values;
+  for (int64_t i = 0; i < 300000; ++i) {
+    values.push_back(std::sin(i) * 1e6);
+  }
+  for (int num_threads : {1, 2, 4, 7}) {
+    ExpectSorts(values, num_threads);
+  }
+}
+
+TEST(SampleSortTest, Duplicates) {
+  // Most values equal a splitter, so buckets are unbalanced.
+  std::vector<double> values;
+  for (int64_t i = 0; i < 300000; ++i) {
+    values.push_back((i * 7919) % 3);
+  }
+  values[17] = std::numeric_limits<double>::infinity();
+  values[42] = -std::numeric_limits<double>::infinity();
+  for (int num_threads : {1, 4}) {
+    ExpectSorts(values, num_threads);
+  }
+}
+
+TEST(SampleSortTest, Constant) {
+  ExpectSorts(std::vector<double>(kSampleSortMinSize, 1.5), 4);
+}
+
+}  // namespace
+}  // namespace base
+}  // namespace differential_privacy
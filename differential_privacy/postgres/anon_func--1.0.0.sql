@@ -16,43 +16,109 @@ limitations under the License.
 
 \echo Use "CREATE EXTENSION anon_func" to load this file. \quit
 
+/* Create the functions for parallel aggregation, shared by all aggregates.
+ *
+ * Workers aggregate partial states, which are serialized to the leader, where
+ * they are combined before the final function is applied.
+ *
+ * The SSPACE of each aggregate below is the approximate size in bytes of its
+ * state, which the planner uses to size hash aggregation. States with
+ * automatic bounds hold the bins of the bounds, and ANON_NTILE states grow
+ * with their input; its SSPACE assumes about a thousand rows per group.
+ */
+
+-- Serialize.
+CREATE FUNCTION anon_func_serialize(internal) RETURNS bytea AS
+  'anon_func','anon_func_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Deserialize.
+CREATE FUNCTION anon_func_deserialize(bytea, internal) RETURNS internal AS
+  'anon_func','anon_func_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Combine.
+CREATE FUNCTION anon_func_combine(internal, internal) RETURNS internal AS
+  'anon_func','anon_func_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+
 /* Create the aggregates:
  *
  * ANON_COUNT(column, epsilon)
  * ANON_COUNT(column)
  *
- * where column is of any type.
+ * where column is of any type. As window functions, they are moving
+ * aggregates: entries that leave the frame are removed from the state instead
+ * of aggregating each frame from scratch.
  */
 
 -- Accum for with epsilon.
 CREATE FUNCTION anon_count_accum(internal, anyelement, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_count_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for no epsilon.
 CREATE FUNCTION anon_count_accum(internal, anyelement)
 RETURNS internal AS
   'anon_func','anon_count_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract.
 CREATE FUNCTION anon_count_extract(internal) RETURNS bigint AS
   'anon_func','anon_count_extract'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for moving aggregates, with epsilon.
+CREATE FUNCTION anon_count_inv(internal, anyelement, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_count_inv'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for moving aggregates, no epsilon.
+CREATE FUNCTION anon_count_inv(internal, anyelement)
+RETURNS internal AS
+  'anon_func','anon_count_inv'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract for moving aggregates.
+CREATE FUNCTION anon_count_moving_extract(internal) RETURNS bigint AS
+  'anon_func','anon_count_moving_extract'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for with epsilon.
 CREATE AGGREGATE anon_count(anyelement, epsilon double precision) (
   SFUNC = anon_count_accum,
   STYPE = internal,
-  FINALFUNC = anon_count_extract
+  SSPACE = 128,
+  FINALFUNC = anon_count_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_count_accum,
+  MINVFUNC = anon_count_inv,
+  MSTYPE = internal,
+  MSSPACE = 128,
+  MFINALFUNC = anon_count_moving_extract,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for no epsilon.
 CREATE AGGREGATE anon_count(anyelement) (
   SFUNC = anon_count_accum,
   STYPE = internal,
-  FINALFUNC = anon_count_extract
+  SSPACE = 128,
+  FINALFUNC = anon_count_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_count_accum,
+  MINVFUNC = anon_count_inv,
+  MSTYPE = internal,
+  MSSPACE = 128,
+  MFINALFUNC = anon_count_moving_extract,
+  PARALLEL = SAFE
 );
 
 
@@ -63,177 +129,287 @@ CREATE AGGREGATE anon_count(anyelement) (
  * ANON_SUM(column, lower, upper, epsilon)
  * ANON_SUM(column, lower, upper)
  *
- * where column can be double, bigint, integer, or smallint type.
+ * where column can be double, bigint, integer, or smallint type, or a double
+ * precision array whose non-null elements are each an entry. As window
+ * functions, ANON_SUM with bounds on a column that is not an array is a moving
+ * aggregate: entries that leave the frame are removed from the state instead
+ * of aggregating each frame from scratch.
  */
 
 -- Accum for double type, auto bounding, with epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for double type, auto bounding, no epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry double precision)
 RETURNS internal AS
   'anon_func','anon_sum_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, auto bounding, with epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry bigint, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, auto bounding, no epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry bigint)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, auto bounding, with epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry integer, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, auto bounding, no epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry integer)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, auto bounding, with epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry smallint, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, auto bounding, no epsilon.
 CREATE FUNCTION anon_sum_accum(internal, entry smallint)
 RETURNS internal AS
   'anon_func','anon_sum_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for double type, manual bounding, with epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for double type, manual bounding, no epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, manual bounding, with epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry bigint, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, manual bounding, no epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry bigint, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, manual bounding, with epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry integer, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, manual bounding, no epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry integer, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, manual bounding, with epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry smallint, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, manual bounding, no epsilon.
 CREATE FUNCTION anon_sum_with_bounds_accum(internal, entry smallint, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_sum_with_bounds_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for double type, manual bounding, with epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry double precision, lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_double'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for double type, manual bounding, no epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry double precision, lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_double'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for bigint type, manual bounding, with epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry bigint, lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for bigint type, manual bounding, no epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry bigint, lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for integer type, manual bounding, with epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry integer, lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for integer type, manual bounding, no epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry integer, lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for smallint type, manual bounding, with epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry smallint, lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Inverse accum for smallint type, manual bounding, no epsilon.
+CREATE FUNCTION anon_sum_with_bounds_inv(internal, entry smallint, lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_inv_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract for double type.
 CREATE FUNCTION anon_sum_extract_double(internal) RETURNS double precision AS
   'anon_func','anon_sum_extract_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract for int type.
 CREATE FUNCTION anon_sum_extract_int(internal) RETURNS bigint AS
   'anon_func','anon_sum_extract_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract for double type, moving aggregates.
+CREATE FUNCTION anon_sum_moving_extract_double(internal) RETURNS double precision AS
+  'anon_func','anon_sum_moving_extract_double'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract for int type, moving aggregates.
+CREATE FUNCTION anon_sum_moving_extract_int(internal) RETURNS bigint AS
+  'anon_func','anon_sum_moving_extract_int'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for double type, auto bounding, with epsilon.
 CREATE AGGREGATE anon_sum(entry double precision, epsilon double precision) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_double
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for double type, auto bounding, no epsilon.
 CREATE AGGREGATE anon_sum(entry double precision) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_double
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, auto bounding, with epsilon.
 CREATE AGGREGATE anon_sum(entry bigint, epsilon double precision) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, auto bounding, no epsilon.
 CREATE AGGREGATE anon_sum(entry bigint) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, auto bounding, with epsilon.
 CREATE AGGREGATE anon_sum(entry integer, epsilon double precision) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, auto bounding, no epsilon.
 CREATE AGGREGATE anon_sum(entry integer) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for smallint type, auto bounding, with epsilon.
 CREATE AGGREGATE anon_sum(entry smallint, epsilon double precision) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for smallint type, auto bounding, no epsilon.
 CREATE AGGREGATE anon_sum(entry smallint) (
   SFUNC = anon_sum_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, manual bounding, with epsilon.
@@ -241,14 +417,34 @@ CREATE AGGREGATE anon_sum_with_bounds(entry bigint, lb double precision, ub doub
   epsilon double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, manual bounding, no epsilon.
 CREATE AGGREGATE anon_sum_with_bounds(entry bigint, lb double precision, ub double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for double type, manual bounding, with epsilon.
@@ -256,7 +452,17 @@ CREATE AGGREGATE anon_sum_with_bounds(entry double precision, lb double precisio
     ub double precision, epsilon double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_double
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_double,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for double type, manual bounding, no epsilon.
@@ -264,7 +470,17 @@ CREATE AGGREGATE anon_sum_with_bounds(entry double precision, lb double precisio
     ub double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_double
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_double,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, manual bounding, with epsilon.
@@ -272,14 +488,34 @@ CREATE AGGREGATE anon_sum_with_bounds(entry integer, lb double precision, ub dou
     epsilon double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, manual bounding, no epsilon.
 CREATE AGGREGATE anon_sum_with_bounds(entry integer, lb double precision, ub double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
 );
 
 
@@ -288,14 +524,110 @@ CREATE AGGREGATE anon_sum_with_bounds(entry smallint, lb double precision, ub do
     epsilon double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for smallint type, manual bounding, no epsilon.
 CREATE AGGREGATE anon_sum_with_bounds(entry smallint, lb double precision, ub double precision) (
   SFUNC = anon_sum_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_sum_extract_int
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  MSFUNC = anon_sum_with_bounds_accum,
+  MINVFUNC = anon_sum_with_bounds_inv,
+  MSTYPE = internal,
+  MSSPACE = 256,
+  MFINALFUNC = anon_sum_moving_extract_int,
+  PARALLEL = SAFE
+);
+
+-- Accum for double precision arrays, auto bounding, with epsilon.
+CREATE FUNCTION anon_sum_accum(internal, entries double precision[], epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, auto bounding, no epsilon.
+CREATE FUNCTION anon_sum_accum(internal, entries double precision[])
+RETURNS internal AS
+  'anon_func','anon_sum_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, with epsilon.
+CREATE FUNCTION anon_sum_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, no epsilon.
+CREATE FUNCTION anon_sum_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_sum_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate for double precision arrays, auto bounding, with epsilon.
+CREATE AGGREGATE anon_sum(entries double precision[], epsilon double precision) (
+  SFUNC = anon_sum_accum,
+  STYPE = internal,
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, auto bounding, no epsilon.
+CREATE AGGREGATE anon_sum(entries double precision[]) (
+  SFUNC = anon_sum_accum,
+  STYPE = internal,
+  SSPACE = 66560,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, with epsilon.
+CREATE AGGREGATE anon_sum_with_bounds(entries double precision[], lb double precision,
+    ub double precision, epsilon double precision) (
+  SFUNC = anon_sum_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, no epsilon.
+CREATE AGGREGATE anon_sum_with_bounds(entries double precision[], lb double precision,
+    ub double precision) (
+  SFUNC = anon_sum_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 256,
+  FINALFUNC = anon_sum_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 
@@ -306,52 +638,63 @@ CREATE AGGREGATE anon_sum_with_bounds(entry smallint, lb double precision, ub do
  * ANON_AVG(column, lower, upper, epsilon)
  * ANON_AVG(column, lower, upper)
  *
- * where column can be any numeric type smaller than double precision.
+ * where column can be any numeric type smaller than double precision, or a
+ * double precision array whose non-null elements are each an entry.
  */
 
 -- Accum for auto bounding, with epsilon.
 CREATE FUNCTION anon_avg_accum(internal, entry double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_avg_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for auto bounding, no epsilon.
 CREATE FUNCTION anon_avg_accum(internal, entry double precision)
 RETURNS internal AS
   'anon_func','anon_avg_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, with epsilon.
 CREATE FUNCTION anon_avg_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_avg_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, no epsilon.
 CREATE FUNCTION anon_avg_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_avg_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract.
 CREATE FUNCTION anon_avg_extract(internal) RETURNS double precision AS
   'anon_func','anon_avg_extract'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for auto bounding, with epsilon.
 CREATE AGGREGATE anon_avg(entry double precision, epsilon double precision) (
   SFUNC = anon_avg_accum,
   STYPE = internal,
-  FINALFUNC = anon_avg_extract
+  SSPACE = 66560,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for auto bounding, no epsilon.
 CREATE AGGREGATE anon_avg(entry double precision) (
   SFUNC = anon_avg_accum,
   STYPE = internal,
-  FINALFUNC = anon_avg_extract
+  SSPACE = 66560,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, with epsilon.
@@ -359,7 +702,12 @@ CREATE AGGREGATE anon_avg_with_bounds(entry double precision, lb double precisio
     ub double precision, epsilon double precision) (
   SFUNC = anon_avg_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_avg_extract
+  SSPACE = 256,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, no epsilon.
@@ -367,7 +715,88 @@ CREATE AGGREGATE anon_avg_with_bounds(entry double precision, lb double precisio
     ub double precision) (
   SFUNC = anon_avg_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_avg_extract
+  SSPACE = 256,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Accum for double precision arrays, auto bounding, with epsilon.
+CREATE FUNCTION anon_avg_accum(internal, entries double precision[], epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_avg_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, auto bounding, no epsilon.
+CREATE FUNCTION anon_avg_accum(internal, entries double precision[])
+RETURNS internal AS
+  'anon_func','anon_avg_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, with epsilon.
+CREATE FUNCTION anon_avg_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_avg_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, no epsilon.
+CREATE FUNCTION anon_avg_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_avg_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate for double precision arrays, auto bounding, with epsilon.
+CREATE AGGREGATE anon_avg(entries double precision[], epsilon double precision) (
+  SFUNC = anon_avg_accum,
+  STYPE = internal,
+  SSPACE = 66560,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, auto bounding, no epsilon.
+CREATE AGGREGATE anon_avg(entries double precision[]) (
+  SFUNC = anon_avg_accum,
+  STYPE = internal,
+  SSPACE = 66560,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, with epsilon.
+CREATE AGGREGATE anon_avg_with_bounds(entries double precision[], lb double precision,
+    ub double precision, epsilon double precision) (
+  SFUNC = anon_avg_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 256,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, no epsilon.
+CREATE AGGREGATE anon_avg_with_bounds(entries double precision[], lb double precision,
+    ub double precision) (
+  SFUNC = anon_avg_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 256,
+  FINALFUNC = anon_avg_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 
@@ -378,52 +807,63 @@ CREATE AGGREGATE anon_avg_with_bounds(entry double precision, lb double precisio
  * ANON_VAR(column, lower, upper, epsilon)
  * ANON_VAR(column, lower, upper)
  *
- * where column can be any numeric type smaller than double precision.
+ * where column can be any numeric type smaller than double precision, or a
+ * double precision array whose non-null elements are each an entry.
  */
 
 -- Accum for auto bounding, with epsilon.
 CREATE FUNCTION anon_var_accum(internal, entry double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_var_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for auto bounding, no epsilon.
 CREATE FUNCTION anon_var_accum(internal, entry double precision)
 RETURNS internal AS
   'anon_func','anon_var_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, with epsilon.
 CREATE FUNCTION anon_var_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_var_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, no epsilon.
 CREATE FUNCTION anon_var_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_var_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract.
 CREATE FUNCTION anon_var_extract(internal) RETURNS double precision AS
   'anon_func','anon_var_extract'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for auto bounding, with epsilon.
 CREATE AGGREGATE anon_var(entry double precision, epsilon double precision) (
   SFUNC = anon_var_accum,
   STYPE = internal,
-  FINALFUNC = anon_var_extract
+  SSPACE = 99328,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for auto bounding, no epsilon.
 CREATE AGGREGATE anon_var(entry double precision) (
   SFUNC = anon_var_accum,
   STYPE = internal,
-  FINALFUNC = anon_var_extract
+  SSPACE = 99328,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, with epsilon.
@@ -431,7 +871,12 @@ CREATE AGGREGATE anon_var_with_bounds(entry double precision, lb double precisio
     ub double precision, epsilon double precision) (
   SFUNC = anon_var_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_var_extract
+  SSPACE = 512,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, no epsilon.
@@ -439,7 +884,88 @@ CREATE AGGREGATE anon_var_with_bounds(entry double precision, lb double precisio
     ub double precision) (
   SFUNC = anon_var_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_var_extract
+  SSPACE = 512,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Accum for double precision arrays, auto bounding, with epsilon.
+CREATE FUNCTION anon_var_accum(internal, entries double precision[], epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_var_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, auto bounding, no epsilon.
+CREATE FUNCTION anon_var_accum(internal, entries double precision[])
+RETURNS internal AS
+  'anon_func','anon_var_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, with epsilon.
+CREATE FUNCTION anon_var_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_var_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, no epsilon.
+CREATE FUNCTION anon_var_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_var_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate for double precision arrays, auto bounding, with epsilon.
+CREATE AGGREGATE anon_var(entries double precision[], epsilon double precision) (
+  SFUNC = anon_var_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, auto bounding, no epsilon.
+CREATE AGGREGATE anon_var(entries double precision[]) (
+  SFUNC = anon_var_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, with epsilon.
+CREATE AGGREGATE anon_var_with_bounds(entries double precision[], lb double precision,
+    ub double precision, epsilon double precision) (
+  SFUNC = anon_var_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, no epsilon.
+CREATE AGGREGATE anon_var_with_bounds(entries double precision[], lb double precision,
+    ub double precision) (
+  SFUNC = anon_var_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_var_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 
@@ -450,52 +976,63 @@ CREATE AGGREGATE anon_var_with_bounds(entry double precision, lb double precisio
  * ANON_STDDEV(column, lower, upper, epsilon)
  * ANON_STDDEV(column, lower, upper)
  *
- * where column can be any numeric type smaller than double precision.
+ * where column can be any numeric type smaller than double precision, or a
+ * double precision array whose non-null elements are each an entry.
  */
 
 -- Accum for auto bounding, with epsilon.
 CREATE FUNCTION anon_stddev_accum(internal, entry double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_stddev_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for auto bounding, no epsilon.
 CREATE FUNCTION anon_stddev_accum(internal, entry double precision)
 RETURNS internal AS
   'anon_func','anon_stddev_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, with epsilon.
 CREATE FUNCTION anon_stddev_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_stddev_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for manual bounding, no epsilon.
 CREATE FUNCTION anon_stddev_with_bounds_accum(internal, entry double precision, lb double precision,
   ub double precision)
 RETURNS internal AS
   'anon_func','anon_stddev_with_bounds_accum'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract.
 CREATE FUNCTION anon_stddev_extract(internal) RETURNS double precision AS
   'anon_func','anon_stddev_extract'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for auto bounding, with epsilon.
 CREATE AGGREGATE anon_stddev(entry double precision, epsilon double precision) (
   SFUNC = anon_stddev_accum,
   STYPE = internal,
-  FINALFUNC = anon_stddev_extract
+  SSPACE = 99328,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for auto bounding, no epsilon.
 CREATE AGGREGATE anon_stddev(entry double precision) (
   SFUNC = anon_stddev_accum,
   STYPE = internal,
-  FINALFUNC = anon_stddev_extract
+  SSPACE = 99328,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, with epsilon.
@@ -503,7 +1040,12 @@ CREATE AGGREGATE anon_stddev_with_bounds(entry double precision, lb double preci
     ub double precision, epsilon double precision) (
   SFUNC = anon_stddev_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_stddev_extract
+  SSPACE = 512,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for manual bounding, no epsilon.
@@ -511,7 +1053,191 @@ CREATE AGGREGATE anon_stddev_with_bounds(entry double precision, lb double preci
     ub double precision) (
   SFUNC = anon_stddev_with_bounds_accum,
   STYPE = internal,
-  FINALFUNC = anon_stddev_extract
+  SSPACE = 512,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Accum for double precision arrays, auto bounding, with epsilon.
+CREATE FUNCTION anon_stddev_accum(internal, entries double precision[], epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_stddev_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, auto bounding, no epsilon.
+CREATE FUNCTION anon_stddev_accum(internal, entries double precision[])
+RETURNS internal AS
+  'anon_func','anon_stddev_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, with epsilon.
+CREATE FUNCTION anon_stddev_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_stddev_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for double precision arrays, manual bounding, no epsilon.
+CREATE FUNCTION anon_stddev_with_bounds_accum(internal, entries double precision[], lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_stddev_with_bounds_accum_array'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate for double precision arrays, auto bounding, with epsilon.
+CREATE AGGREGATE anon_stddev(entries double precision[], epsilon double precision) (
+  SFUNC = anon_stddev_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, auto bounding, no epsilon.
+CREATE AGGREGATE anon_stddev(entries double precision[]) (
+  SFUNC = anon_stddev_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, with epsilon.
+CREATE AGGREGATE anon_stddev_with_bounds(entries double precision[], lb double precision,
+    ub double precision, epsilon double precision) (
+  SFUNC = anon_stddev_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for double precision arrays, manual bounding, no epsilon.
+CREATE AGGREGATE anon_stddev_with_bounds(entries double precision[], lb double precision,
+    ub double precision) (
+  SFUNC = anon_stddev_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_stddev_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+
+/* Create the aggregates:
+ *
+ * ANON_STATS(column, epsilon)
+ * ANON_STATS(column)
+ * ANON_STATS(column, lower, upper, epsilon)
+ * ANON_STATS(column, lower, upper)
+ *
+ * where column can be any numeric type smaller than double precision. They
+ * return the count, sum, mean, variance and standard deviation of the column
+ * from a single aggregate state.
+ */
+
+-- Result type.
+CREATE TYPE anon_stats_result AS (
+  count bigint,
+  sum double precision,
+  mean double precision,
+  variance double precision,
+  stddev double precision
+);
+
+-- Accum for auto bounding, with epsilon.
+CREATE FUNCTION anon_stats_accum(internal, entry double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_stats_accum'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for auto bounding, no epsilon.
+CREATE FUNCTION anon_stats_accum(internal, entry double precision)
+RETURNS internal AS
+  'anon_func','anon_stats_accum'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for manual bounding, with epsilon.
+CREATE FUNCTION anon_stats_with_bounds_accum(internal, entry double precision, lb double precision,
+  ub double precision, epsilon double precision)
+RETURNS internal AS
+  'anon_func','anon_stats_with_bounds_accum'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Accum for manual bounding, no epsilon.
+CREATE FUNCTION anon_stats_with_bounds_accum(internal, entry double precision, lb double precision,
+  ub double precision)
+RETURNS internal AS
+  'anon_func','anon_stats_with_bounds_accum'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract.
+CREATE FUNCTION anon_stats_extract(internal) RETURNS anon_stats_result AS
+  'anon_func','anon_stats_extract'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate for auto bounding, with epsilon.
+CREATE AGGREGATE anon_stats(entry double precision, epsilon double precision) (
+  SFUNC = anon_stats_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_stats_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for auto bounding, no epsilon.
+CREATE AGGREGATE anon_stats(entry double precision) (
+  SFUNC = anon_stats_accum,
+  STYPE = internal,
+  SSPACE = 99328,
+  FINALFUNC = anon_stats_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for manual bounding, with epsilon.
+CREATE AGGREGATE anon_stats_with_bounds(entry double precision, lb double precision,
+    ub double precision, epsilon double precision) (
+  SFUNC = anon_stats_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_stats_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+-- Aggregate for manual bounding, no epsilon.
+CREATE AGGREGATE anon_stats_with_bounds(entry double precision, lb double precision,
+    ub double precision) (
+  SFUNC = anon_stats_with_bounds_accum,
+  STYPE = internal,
+  SSPACE = 512,
+  FINALFUNC = anon_stats_extract,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 
@@ -528,73 +1254,78 @@ CREATE FUNCTION anon_ntile_accum(internal, entry double precision, percentile do
   lb double precision, ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for double type, no epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry double precision, percentile double precision,
   lb double precision, ub double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, with epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry bigint, percentile double precision,
   lb double precision, ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for bigint type, no epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry bigint, percentile double precision,
   lb double precision, ub double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, with epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry integer, percentile double precision,
   lb double precision, ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for integer type, no epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry integer, percentile double precision,
   lb double precision, ub double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, with epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry smallint, percentile double precision,
   lb double precision, ub double precision, epsilon double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Accum for smallint type, no epsilon.
 CREATE FUNCTION anon_ntile_accum(internal, entry smallint, percentile double precision,
   lb double precision, ub double precision)
 RETURNS internal AS
   'anon_func','anon_ntile_accum_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract for double type.
 CREATE FUNCTION anon_ntile_extract_double(internal) RETURNS double precision AS
   'anon_func','anon_ntile_extract_double'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Extract for int type.
 CREATE FUNCTION anon_ntile_extract_int(internal) RETURNS bigint AS
   'anon_func','anon_ntile_extract_int'
-LANGUAGE C IMMUTABLE;
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
 -- Aggregate for double type, with epsilon.
 CREATE AGGREGATE anon_ntile(entry double precision, percentile double precision,
     lb double precision, ub double precision, epsilon double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_double
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for double type, no epsilon.
@@ -602,7 +1333,12 @@ CREATE AGGREGATE anon_ntile(entry double precision, percentile double precision,
   lb double precision, ub double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_double
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_double,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, with epsilon.
@@ -610,7 +1346,12 @@ CREATE AGGREGATE anon_ntile(entry bigint, percentile double precision, lb double
     ub double precision, epsilon double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for bigint type, no epsilon.
@@ -618,7 +1359,12 @@ CREATE AGGREGATE anon_ntile(entry bigint, percentile double precision, lb double
     ub double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, with epsilon.
@@ -626,7 +1372,12 @@ CREATE AGGREGATE anon_ntile(entry integer, percentile double precision,  lb doub
     ub double precision, epsilon double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for integer type, no epsilon.
@@ -634,7 +1385,12 @@ CREATE AGGREGATE anon_ntile(entry integer, percentile double precision,  lb doub
     ub double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for smallint type, with epsilon.
@@ -642,7 +1398,12 @@ CREATE AGGREGATE anon_ntile(entry smallint, percentile double precision,  lb dou
     ub double precision, epsilon double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
 );
 
 -- Aggregate for smallint type, no epsilon.
@@ -650,5 +1411,64 @@ CREATE AGGREGATE anon_ntile(entry smallint, percentile double precision,  lb dou
     ub double precision) (
   SFUNC = anon_ntile_accum,
   STYPE = internal,
-  FINALFUNC = anon_ntile_extract_int
+  SSPACE = 8192,
+  FINALFUNC = anon_ntile_extract_int,
+  COMBINEFUNC = anon_func_combine,
+  SERIALFUNC = anon_func_serialize,
+  DESERIALFUNC = anon_func_deserialize,
+  PARALLEL = SAFE
+);
+
+
+/* Create the ordered-set aggregates:
+ *
+ * ANON_PERCENTILE(percentile, lower, upper, epsilon) WITHIN GROUP (ORDER BY column)
+ * ANON_PERCENTILE(percentile, lower, upper) WITHIN GROUP (ORDER BY column)
+ *
+ * where column can be any numeric type smaller than double precision. The
+ * inputs are sorted by a tuplesort, which spills to disk beyond work_mem.
+ */
+
+-- Accum.
+CREATE FUNCTION anon_percentile_accum(internal, entry double precision)
+RETURNS internal AS
+  'anon_func','anon_percentile_accum'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract with epsilon. The last argument is a placeholder for the entry.
+CREATE FUNCTION anon_percentile_extract(internal, percentile double precision,
+  lb double precision, ub double precision, epsilon double precision,
+  entry double precision)
+RETURNS double precision AS
+  'anon_func','anon_percentile_extract'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Extract no epsilon. The last argument is a placeholder for the entry.
+CREATE FUNCTION anon_percentile_extract(internal, percentile double precision,
+  lb double precision, ub double precision, entry double precision)
+RETURNS double precision AS
+  'anon_func','anon_percentile_extract'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Aggregate with epsilon. The final function releases the result once, so
+-- its state must not be shared with other aggregates.
+CREATE AGGREGATE anon_percentile(percentile double precision, lb double precision,
+    ub double precision, epsilon double precision ORDER BY entry double precision) (
+  SFUNC = anon_percentile_accum,
+  STYPE = internal,
+  FINALFUNC = anon_percentile_extract,
+  FINALFUNC_EXTRA,
+  FINALFUNC_MODIFY = READ_WRITE,
+  PARALLEL = SAFE
+);
+
+-- Aggregate no epsilon.
+CREATE AGGREGATE anon_percentile(percentile double precision, lb double precision,
+    ub double precision ORDER BY entry double precision) (
+  SFUNC = anon_percentile_accum,
+  STYPE = internal,
+  FINALFUNC = anon_percentile_extract,
+  FINALFUNC_EXTRA,
+  FINALFUNC_MODIFY = READ_WRITE,
+  PARALLEL = SAFE
 );
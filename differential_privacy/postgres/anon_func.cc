@@ -18,7 +18,14 @@ extern "C" {
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "access/htup_details.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
 #include "utils/datum.h"
+#include "utils/tuplesort.h"
 
 PG_MODULE_MAGIC;
 
@@ -31,31 +38,50 @@ PG_MODULE_MAGIC;
  * Headers for functions available in PostgreSQL.
  */
 
+// Parallel aggregation support, shared by all aggregates.
+PG_FUNCTION_INFO_V1(anon_func_serialize);
+PG_FUNCTION_INFO_V1(anon_func_deserialize);
+PG_FUNCTION_INFO_V1(anon_func_combine);
+
 // ANON_COUNT
 PG_FUNCTION_INFO_V1(anon_count_accum);
 PG_FUNCTION_INFO_V1(anon_count_extract);
+PG_FUNCTION_INFO_V1(anon_count_inv);
+PG_FUNCTION_INFO_V1(anon_count_moving_extract);
 
 // ANON_SUM
 PG_FUNCTION_INFO_V1(anon_sum_accum_double);
 PG_FUNCTION_INFO_V1(anon_sum_accum_int);
 PG_FUNCTION_INFO_V1(anon_sum_with_bounds_accum_double);
 PG_FUNCTION_INFO_V1(anon_sum_with_bounds_accum_int);
+PG_FUNCTION_INFO_V1(anon_sum_accum_array);
+PG_FUNCTION_INFO_V1(anon_sum_with_bounds_accum_array);
 PG_FUNCTION_INFO_V1(anon_sum_extract_double);
 PG_FUNCTION_INFO_V1(anon_sum_extract_int);
+PG_FUNCTION_INFO_V1(anon_sum_with_bounds_inv_double);
+PG_FUNCTION_INFO_V1(anon_sum_with_bounds_inv_int);
+PG_FUNCTION_INFO_V1(anon_sum_moving_extract_double);
+PG_FUNCTION_INFO_V1(anon_sum_moving_extract_int);
 
 // ANON_AVG
 PG_FUNCTION_INFO_V1(anon_avg_accum);
 PG_FUNCTION_INFO_V1(anon_avg_with_bounds_accum);
+PG_FUNCTION_INFO_V1(anon_avg_accum_array);
+PG_FUNCTION_INFO_V1(anon_avg_with_bounds_accum_array);
 PG_FUNCTION_INFO_V1(anon_avg_extract);
 
 // ANON_VAR
 PG_FUNCTION_INFO_V1(anon_var_accum);
 PG_FUNCTION_INFO_V1(anon_var_with_bounds_accum);
+PG_FUNCTION_INFO_V1(anon_var_accum_array);
+PG_FUNCTION_INFO_V1(anon_var_with_bounds_accum_array);
 PG_FUNCTION_INFO_V1(anon_var_extract);
 
 // ANON_STDDEV
 PG_FUNCTION_INFO_V1(anon_stddev_accum);
 PG_FUNCTION_INFO_V1(anon_stddev_with_bounds_accum);
+PG_FUNCTION_INFO_V1(anon_stddev_accum_array);
+PG_FUNCTION_INFO_V1(anon_stddev_with_bounds_accum_array);
 PG_FUNCTION_INFO_V1(anon_stddev_extract);
 
 // ANON_NTILE
@@ -63,14 +89,82 @@ PG_FUNCTION_INFO_V1(anon_ntile_accum_double);
 PG_FUNCTION_INFO_V1(anon_ntile_accum_int);
 PG_FUNCTION_INFO_V1(anon_ntile_extract_double);
 PG_FUNCTION_INFO_V1(anon_ntile_extract_int);
+
+// ANON_STATS
+PG_FUNCTION_INFO_V1(anon_stats_accum);
+PG_FUNCTION_INFO_V1(anon_stats_with_bounds_accum);
+PG_FUNCTION_INFO_V1(anon_stats_extract);
+
+// ANON_PERCENTILE
+PG_FUNCTION_INFO_V1(anon_percentile_accum);
+PG_FUNCTION_INFO_V1(anon_percentile_extract);
 }
 
+#include <cmath>
+#include <new>
+
 #include "dp_func.h"
 
 /*
  * Helper functions.
  */
 
+// Offset of a DpFunc from the start of its memory, which begins with the
+// callback that destroys it.
+constexpr size_t kDpFuncOffset = MAXALIGN(sizeof(MemoryContextCallback));
+
+// Calls the destructor of a DpFunc, which releases the memory of its
+// underlying algorithm.
+void destroy_dp_func(void* arg) { static_cast<DpFunc*>(arg)->~DpFunc(); }
+
+// Allocates memory for a DpFunc of size bytes in the memory context, preceded
+// by room for the callback that destroys it.
+void* alloc_dp_func(size_t size, void* context) {
+  char* memory = static_cast<char*>(MemoryContextAlloc(
+      static_cast<MemoryContext>(context), kDpFuncOffset + size));
+  return memory + kDpFuncOffset;
+}
+
+// Registers the destruction of func, allocated by alloc_dp_func, when the
+// memory context is reset or deleted. This releases the function after the
+// aggregation, including when the query fails or is cancelled.
+void register_dp_func(DpFunc* func, MemoryContext context) {
+  MemoryContextCallback* callback = reinterpret_cast<MemoryContextCallback*>(
+      reinterpret_cast<char*>(func) - kDpFuncOffset);
+  callback->func = destroy_dp_func;
+  callback->arg = func;
+  MemoryContextRegisterResetCallback(context, callback);
+}
+
+// Constructs a DpFunction in the aggregate memory context, which owns it.
+template <typename DpFunction, typename... Args>
+DpFunction* new_dp_func(PG_FUNCTION_ARGS, Args... args) {
+  MemoryContext aggcontext;
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "Anon function called in non-aggregate context");
+  }
+  DpFunction* func = new (alloc_dp_func(sizeof(DpFunction), aggcontext))
+      DpFunction(args...);
+  register_dp_func(func, aggcontext);
+  return func;
+}
+
+// Constructs a DpFunc from its serialized state in the aggregate memory
+// context, which owns it. Returns nullptr and populates err if unsuccessful.
+DpFunc* deserialize_dp_func(PG_FUNCTION_ARGS, const std::string& serialized,
+                            std::string* err) {
+  MemoryContext aggcontext;
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "Anon function called in non-aggregate context");
+  }
+  DpFunc* func =
+      DpFunc::Deserialize(serialized, err, alloc_dp_func, aggcontext);
+  if (func) {
+    register_dp_func(func, aggcontext);
+  }
+  return func;
+}
+
 template <typename DpFunction>
 void add_arg_entry(PG_FUNCTION_ARGS, DpFunction* func, bool is_integral) {
   bool entry_added;
@@ -87,10 +181,37 @@ void add_arg_entry(PG_FUNCTION_ARGS, DpFunction* func, bool is_integral) {
   }
 }
 
-// Common code for bounded accum functions.
+// Adds each element of the double precision array argument as an entry. The
+// elements are passed to the function directly from the array's data buffer.
+// Null elements are skipped; they take up no space in the buffer.
 template <typename DpFunction>
-Datum bounded_accum(PG_FUNCTION_ARGS, bool with_bounds, bool is_integral) {
-  CHECK_AGG_CONTEXT(fcinfo);
+void add_arg_array(PG_FUNCTION_ARGS, DpFunction* func) {
+  if (PG_ARGISNULL(1)) {
+    return;
+  }
+  ArrayType* array = PG_GETARG_ARRAYTYPE_P(1);
+  int num_elements = ArrayGetNItems(ARR_NDIM(array), ARR_DIMS(array));
+  int num_entries = num_elements;
+  if (ARR_HASNULL(array)) {
+    const bits8* bitmap = ARR_NULLBITMAP(array);
+    for (int i = 0; i < num_elements; ++i) {
+      if (!(bitmap[i / 8] & (1 << (i % 8)))) {
+        --num_entries;
+      }
+    }
+  }
+  const double* entries = reinterpret_cast<const double*>(ARR_DATA_PTR(array));
+  if (!func->AddEntries(entries, num_entries)) {
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+            errmsg("Adding entries to dp function failed.")));
+  }
+}
+
+// Returns the state of a bounded accum function, which is constructed from the
+// arguments on the first call.
+template <typename DpFunction>
+DpFunction* bounded_state(PG_FUNCTION_ARGS, bool with_bounds) {
   DpFunction* arg0;
 
   // Create DpFunction if it doesn't exist.
@@ -119,8 +240,8 @@ Datum bounded_accum(PG_FUNCTION_ARGS, bool with_bounds, bool is_integral) {
 
     // Construct the DP function.
     std::string err;
-    arg0 = new DpFunction(&err, !with_epsilon, epsilon,
-                          !with_bounds, lower, upper);
+    arg0 = new_dp_func<DpFunction>(fcinfo, &err, !with_epsilon, epsilon,
+                                   !with_bounds, lower, upper);
     if (!err.empty()) {
       ereport(ERROR,
               (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg(err.c_str())));
@@ -129,10 +250,27 @@ Datum bounded_accum(PG_FUNCTION_ARGS, bool with_bounds, bool is_integral) {
     arg0 = reinterpret_cast<DpFunction*>(PG_GETARG_POINTER(0));
   }
 
+  return arg0;
+}
+
+// Common code for bounded accum functions.
+template <typename DpFunction>
+Datum bounded_accum(PG_FUNCTION_ARGS, bool with_bounds, bool is_integral) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  DpFunction* arg0 = bounded_state<DpFunction>(fcinfo, with_bounds);
   add_arg_entry(fcinfo, arg0, is_integral);
   PG_RETURN_POINTER(arg0);
 }
 
+// Common code for bounded accum functions of double precision arrays.
+template <typename DpFunction>
+Datum bounded_accum_array(PG_FUNCTION_ARGS, bool with_bounds) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  DpFunction* arg0 = bounded_state<DpFunction>(fcinfo, with_bounds);
+  add_arg_array(fcinfo, arg0);
+  PG_RETURN_POINTER(arg0);
+}
+
 // Common extract code for returning integer values. Return null if error.
 template <typename DpFunction>
 Datum int_extract(PG_FUNCTION_ARGS){
@@ -147,7 +285,6 @@ Datum int_extract(PG_FUNCTION_ARGS){
     elog(INFO, (err + " Returning NULL.").c_str());
     PG_RETURN_NULL();
   }
-  delete arg;
   PG_RETURN_INT64(result);
 }
 
@@ -165,10 +302,130 @@ Datum double_extract(PG_FUNCTION_ARGS){
     elog(INFO, (err + " Returning NULL.").c_str());
     PG_RETURN_NULL();
   }
-  delete arg;
   PG_RETURN_FLOAT8(result);
 }
 
+// Common code for inverse transition functions of moving aggregates, which
+// remove the entry that left the window frame. Returns null if the entry
+// cannot be removed, so that PostgreSQL recomputes the frame from scratch.
+template <typename DpFunction>
+Datum inverse_accum(PG_FUNCTION_ARGS, bool is_integral) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  DpFunction* arg0 = reinterpret_cast<DpFunction*>(PG_GETARG_POINTER(0));
+  bool entry_removed;
+  if (is_integral) {
+    entry_removed = arg0->RemoveEntry(PG_GETARG_INT64(1));
+  } else {
+    entry_removed = arg0->RemoveEntry(PG_GETARG_FLOAT8(1));
+  }
+  if (!entry_removed) {
+    PG_RETURN_NULL();
+  }
+  PG_RETURN_POINTER(arg0);
+}
+
+// Common extract code of moving aggregates for returning integer values. The
+// state is kept for the following frames. Return null if error.
+template <typename DpFunction>
+Datum int_moving_extract(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  if (PG_ARGISNULL(0)) {
+    PG_RETURN_NULL();
+  }
+  DpFunction* arg = reinterpret_cast<DpFunction*>(PG_GETARG_POINTER(0));
+  std::string err;
+  int64_t result = arg->FrameResultRounded(&err);
+  if (!err.empty()) {
+    elog(INFO, (err + " Returning NULL.").c_str());
+    PG_RETURN_NULL();
+  }
+  PG_RETURN_INT64(result);
+}
+
+// Common extract code of moving aggregates for returning double values. The
+// state is kept for the following frames. Return null if error.
+template <typename DpFunction>
+Datum double_moving_extract(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  if (PG_ARGISNULL(0)) {
+    PG_RETURN_NULL();
+  }
+  DpFunction* arg = reinterpret_cast<DpFunction*>(PG_GETARG_POINTER(0));
+  std::string err;
+  double result = arg->FrameResult(&err);
+  if (!err.empty()) {
+    elog(INFO, (err + " Returning NULL.").c_str());
+    PG_RETURN_NULL();
+  }
+  PG_RETURN_FLOAT8(result);
+}
+
+
+
+/*
+ * Parallel aggregation functions. The state of every aggregate is a DpFunc,
+ * whose serialization includes the parameters it was constructed with, so
+ * these are shared by all aggregates.
+ */
+
+// Serializes the state of a partial aggregate into a bytea.
+Datum anon_func_serialize(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  DpFunc* arg0 = reinterpret_cast<DpFunc*>(PG_GETARG_POINTER(0));
+  std::string err;
+  std::string serialized = arg0->Serialize(&err);
+  if (!err.empty()) {
+    ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg(err.c_str())));
+  }
+  const size_t size = VARHDRSZ + serialized.size();
+  bytea* result = reinterpret_cast<bytea*>(palloc(size));
+  SET_VARSIZE(result, size);
+  memcpy(VARDATA(result), serialized.data(), serialized.size());
+  PG_RETURN_BYTEA_P(result);
+}
+
+// Constructs the state of a partial aggregate from a bytea.
+Datum anon_func_deserialize(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  bytea* arg0 = PG_GETARG_BYTEA_PP(0);
+  std::string err;
+  DpFunc* result = deserialize_dp_func(
+      fcinfo, std::string(VARDATA_ANY(arg0), VARSIZE_ANY_EXHDR(arg0)), &err);
+  if (!err.empty()) {
+    ereport(ERROR, (errcode(ERRCODE_INTERNAL_ERROR), errmsg(err.c_str())));
+  }
+  PG_RETURN_POINTER(result);
+}
+
+// Merges the state of the second partial aggregate into the first. Postgres
+// requires that the second state is left unchanged.
+Datum anon_func_combine(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  if (PG_ARGISNULL(1)) {
+    if (PG_ARGISNULL(0)) {
+      PG_RETURN_NULL();
+    }
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+  }
+  DpFunc* arg1 = reinterpret_cast<DpFunc*>(PG_GETARG_POINTER(1));
+  std::string err;
+  std::string serialized = arg1->Serialize(&err);
+  DpFunc* arg0 = nullptr;
+  if (err.empty()) {
+    if (PG_ARGISNULL(0)) {
+      arg0 = deserialize_dp_func(fcinfo, serialized, &err);
+    } else {
+      arg0 = reinterpret_cast<DpFunc*>(PG_GETARG_POINTER(0));
+      arg0->Merge(serialized, &err);
+    }
+  }
+  if (!err.empty()) {
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE), errmsg(err.c_str())));
+  }
+  PG_RETURN_POINTER(arg0);
+}
+
 
 /*
  * ANON_COUNT functions.
@@ -181,9 +438,10 @@ Datum anon_count_accum(PG_FUNCTION_ARGS) {
     std::string err;
     if (PG_NARGS() > 2) {
       float8 epsilon = PG_GETARG_FLOAT8(2);
-      arg0 = new DpCount(&err, /*default_epsilon=*/false, epsilon);
+      arg0 = new_dp_func<DpCount>(fcinfo, &err, /*default_epsilon=*/false,
+                                  epsilon);
     } else {
-      arg0 = new DpCount(&err);
+      arg0 = new_dp_func<DpCount>(fcinfo, &err);
     }
     if (!err.empty()) {
       ereport(ERROR,
@@ -206,6 +464,21 @@ Datum anon_count_extract(PG_FUNCTION_ARGS) {
   return int_extract<DpCount>(fcinfo);
 }
 
+Datum anon_count_inv(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  DpCount* arg0 = reinterpret_cast<DpCount*>(PG_GETARG_POINTER(0));
+
+  // Remove one of the dummy entries added by anon_count_accum.
+  if (!arg0->RemoveEntry(1.0)) {
+    PG_RETURN_NULL();
+  }
+  PG_RETURN_POINTER(arg0);
+}
+
+Datum anon_count_moving_extract(PG_FUNCTION_ARGS) {
+  return int_moving_extract<DpCount>(fcinfo);
+}
+
 
 /*
  * ANON_SUM functions.
@@ -228,6 +501,14 @@ Datum anon_sum_with_bounds_accum_int(PG_FUNCTION_ARGS) {
   return bounded_accum<DpSum>(fcinfo, true, true);
 }
 
+Datum anon_sum_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpSum>(fcinfo, false);
+}
+
+Datum anon_sum_with_bounds_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpSum>(fcinfo, true);
+}
+
 Datum anon_sum_extract_double(PG_FUNCTION_ARGS) {
   return double_extract<DpSum>(fcinfo);
 }
@@ -236,6 +517,22 @@ Datum anon_sum_extract_int(PG_FUNCTION_ARGS) {
   return int_extract<DpSum>(fcinfo);
 }
 
+Datum anon_sum_with_bounds_inv_double(PG_FUNCTION_ARGS) {
+  return inverse_accum<DpSum>(fcinfo, false);
+}
+
+Datum anon_sum_with_bounds_inv_int(PG_FUNCTION_ARGS) {
+  return inverse_accum<DpSum>(fcinfo, true);
+}
+
+Datum anon_sum_moving_extract_double(PG_FUNCTION_ARGS) {
+  return double_moving_extract<DpSum>(fcinfo);
+}
+
+Datum anon_sum_moving_extract_int(PG_FUNCTION_ARGS) {
+  return int_moving_extract<DpSum>(fcinfo);
+}
+
 
 /*
  * ANON_AVG functions.
@@ -250,6 +547,14 @@ Datum anon_avg_with_bounds_accum(PG_FUNCTION_ARGS) {
   return bounded_accum<DpMean>(fcinfo, true, false);
 }
 
+Datum anon_avg_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpMean>(fcinfo, false);
+}
+
+Datum anon_avg_with_bounds_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpMean>(fcinfo, true);
+}
+
 Datum anon_avg_extract(PG_FUNCTION_ARGS) {
   return double_extract<DpMean>(fcinfo);
 }
@@ -268,6 +573,14 @@ Datum anon_var_with_bounds_accum(PG_FUNCTION_ARGS) {
   return bounded_accum<DpVariance>(fcinfo, true, false);
 }
 
+Datum anon_var_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpVariance>(fcinfo, false);
+}
+
+Datum anon_var_with_bounds_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpVariance>(fcinfo, true);
+}
+
 Datum anon_var_extract(PG_FUNCTION_ARGS) {
   return double_extract<DpVariance>(fcinfo);
 }
@@ -286,11 +599,61 @@ Datum anon_stddev_with_bounds_accum(PG_FUNCTION_ARGS) {
   return bounded_accum<DpStandardDeviation>(fcinfo, true, false);
 }
 
+Datum anon_stddev_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpStandardDeviation>(fcinfo, false);
+}
+
+Datum anon_stddev_with_bounds_accum_array(PG_FUNCTION_ARGS) {
+  return bounded_accum_array<DpStandardDeviation>(fcinfo, true);
+}
+
 Datum anon_stddev_extract(PG_FUNCTION_ARGS) {
   return double_extract<DpStandardDeviation>(fcinfo);
 }
 
 
+/*
+ * ANON_STATS functions.
+ */
+
+
+Datum anon_stats_accum(PG_FUNCTION_ARGS) {
+  return bounded_accum<DpStats>(fcinfo, false, false);
+}
+
+Datum anon_stats_with_bounds_accum(PG_FUNCTION_ARGS) {
+  return bounded_accum<DpStats>(fcinfo, true, false);
+}
+
+// Returns the statistics as an anon_stats_result. Return null if error.
+Datum anon_stats_extract(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  if (PG_ARGISNULL(0)) {
+    PG_RETURN_NULL();
+  }
+  TupleDesc tuple_desc;
+  if (get_call_result_type(fcinfo, nullptr, &tuple_desc) !=
+      TYPEFUNC_COMPOSITE) {
+    ereport(ERROR, (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                    errmsg("Anon stats must return a composite type.")));
+  }
+  DpStats* arg = reinterpret_cast<DpStats*>(PG_GETARG_POINTER(0));
+  std::string err;
+  DpStatistics statistics = arg->Statistics(&err);
+  if (!err.empty()) {
+    elog(INFO, (err + " Returning NULL.").c_str());
+    PG_RETURN_NULL();
+  }
+  Datum values[5] = {
+      Int64GetDatum(statistics.count), Float8GetDatum(statistics.sum),
+      Float8GetDatum(statistics.mean), Float8GetDatum(statistics.variance),
+      Float8GetDatum(statistics.standard_deviation)};
+  bool nulls[5] = {false, false, false, false, false};
+  HeapTuple tuple = heap_form_tuple(BlessTupleDesc(tuple_desc), values, nulls);
+  PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+
 
 /*
  * ANON_NTILE functions.
@@ -308,10 +671,10 @@ Datum ntile_accum(PG_FUNCTION_ARGS, bool is_integral) {
     std::string err;
     if (PG_NARGS() > 5) {
       float8 epsilon = PG_GETARG_FLOAT8(5);
-      arg0 = new DpNtile(&err, percentile, lower, upper,
-                         /*default_epsilon=*/false, epsilon);
+      arg0 = new_dp_func<DpNtile>(fcinfo, &err, percentile, lower, upper,
+                                  /*default_epsilon=*/false, epsilon);
     } else {
-      arg0 = new DpNtile(&err, percentile, lower, upper);
+      arg0 = new_dp_func<DpNtile>(fcinfo, &err, percentile, lower, upper);
     }
     if (!err.empty()) {
       ereport(ERROR,
@@ -341,3 +704,168 @@ Datum anon_ntile_extract_double(PG_FUNCTION_ARGS) {
 Datum anon_ntile_extract_int(PG_FUNCTION_ARGS) {
   return int_extract<DpNtile>(fcinfo);
 }
+
+
+/*
+ * ANON_PERCENTILE functions.
+ */
+
+// State of an ANON_PERCENTILE aggregate: its inputs, sorted by a tuplesort that
+// spills to disk beyond work_mem.
+struct PercentileState {
+  Tuplesortstate* sort;
+  int64_t size;
+};
+
+// Releases the tuplesort, including its temporary files, when the aggregate
+// is shut down.
+void percentile_shutdown(Datum arg) {
+  PercentileState* state = reinterpret_cast<PercentileState*>(
+      DatumGetPointer(arg));
+  if (state->sort) {
+    tuplesort_end(state->sort);
+    state->sort = nullptr;
+  }
+}
+
+// SortedInput over the sorted tuples of an ANON_PERCENTILE aggregate. Ranks
+// are counted by stepping from the read position left by the previous query,
+// forwards if the queried value is larger and backwards otherwise. The tuples
+// read by a query are those between the previous and the current queried
+// values, and these intervals shrink as the binary search converges, so the
+// sorted tuples are read a few times in total rather than once per query.
+class TuplesortInput : public SortedInput {
+ public:
+  TuplesortInput(Tuplesortstate* sort, int64_t size)
+      : sort_(sort), size_(size) {}
+
+  int64_t size() override { return size_; }
+
+  void Rank(double value, int64_t* num_less,
+            int64_t* num_less_or_equal) override {
+    Datum datum;
+    bool is_null;
+
+    // The read position is after tuple position_ - 1, whose value is last_.
+    // If that tuple is not less than value, step backwards over the tuples
+    // that are not. The sort is random access, and a backward read returns the
+    // tuple before the last one returned, so each read below returns tuple
+    // position_ - 1 and leaves the read position right after it. Once it fails
+    // at the start, the next forward read returns the first tuple.
+    if (position_ > 0 && last_ >= value) {
+      --position_;
+      while (tuplesort_getdatum(sort_, /*forward=*/false, &datum, &is_null,
+                                nullptr)) {
+        double entry = DatumGetFloat8(datum);
+        if (entry < value) {
+          last_ = entry;
+          break;
+        }
+        --position_;
+      }
+    }
+
+    // Skip the tuples less than value, and mark the position of the first
+    // tuple that is not.
+    tuplesort_markpos(sort_);
+    while (tuplesort_getdatum(sort_, /*forward=*/true, &datum, &is_null,
+                              nullptr)) {
+      double entry = DatumGetFloat8(datum);
+      if (entry >= value) {
+        break;
+      }
+      ++position_;
+      last_ = entry;
+      tuplesort_markpos(sort_);
+    }
+    *num_less = position_;
+
+    // Count the tuples equal to value, and return to the mark.
+    tuplesort_restorepos(sort_);
+    int64_t num_equal = 0;
+    while (tuplesort_getdatum(sort_, /*forward=*/true, &datum, &is_null,
+                              nullptr) &&
+           DatumGetFloat8(datum) == value) {
+      ++num_equal;
+    }
+    tuplesort_restorepos(sort_);
+    *num_less_or_equal = position_ + num_equal;
+  }
+
+ private:
+  Tuplesortstate* sort_;
+  int64_t size_;
+
+  // Number of tuples before the read position, and the value of the last of
+  // them.
+  int64_t position_ = 0;
+  double last_ = 0;
+};
+
+Datum anon_percentile_accum(PG_FUNCTION_ARGS) {
+  MemoryContext aggcontext;
+  if (!AggCheckCallContext(fcinfo, &aggcontext)) {
+    elog(ERROR, "Anon function called in non-aggregate context");
+  }
+  PercentileState* state;
+  if (PG_ARGISNULL(0)) {
+    // The tuplesort is read in both directions to count the ranks of several
+    // values.
+    MemoryContext old_context = MemoryContextSwitchTo(aggcontext);
+    state = reinterpret_cast<PercentileState*>(palloc(sizeof(PercentileState)));
+    state->sort =
+        tuplesort_begin_datum(FLOAT8OID, Float8LessOperator, InvalidOid,
+                              /*nullsFirstFlag=*/false, work_mem,
+                              /*coordinate=*/nullptr, /*randomAccess=*/true);
+    state->size = 0;
+    MemoryContextSwitchTo(old_context);
+    AggRegisterCallback(fcinfo, percentile_shutdown, PointerGetDatum(state));
+  } else {
+    state = reinterpret_cast<PercentileState*>(PG_GETARG_POINTER(0));
+  }
+
+  // Like the DP algorithms, skip null and NaN entries.
+  if (!PG_ARGISNULL(1)) {
+    float8 entry = PG_GETARG_FLOAT8(1);
+    if (!std::isnan(entry)) {
+      tuplesort_putdatum(state->sort, Float8GetDatum(entry), false);
+      ++state->size;
+    }
+  }
+  PG_RETURN_POINTER(state);
+}
+
+Datum anon_percentile_extract(PG_FUNCTION_ARGS) {
+  CHECK_AGG_CONTEXT(fcinfo);
+  if (PG_ARGISNULL(0)) {
+    PG_RETURN_NULL();
+  }
+  if (PG_ARGISNULL(1) || PG_ARGISNULL(2) || PG_ARGISNULL(3)) {
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+            errmsg("Percentile and bounds must not be null.")));
+  }
+  float8 percentile = PG_GETARG_FLOAT8(1);
+  float8 lower = PG_GETARG_FLOAT8(2);
+  float8 upper = PG_GETARG_FLOAT8(3);
+  bool with_epsilon = false;
+  float8 epsilon = 0;
+  // The last argument is a placeholder for the aggregated entry.
+  if (PG_NARGS() > 5) {
+    epsilon = PG_GETARG_FLOAT8(4);
+    with_epsilon = true;
+  }
+
+  PercentileState* state =
+      reinterpret_cast<PercentileState*>(PG_GETARG_POINTER(0));
+  tuplesort_performsort(state->sort);
+  TuplesortInput input(state->sort, state->size);
+  std::string err;
+  double result = DpSortedPercentile(&input, percentile, lower, upper,
+                                     !with_epsilon, epsilon, &err);
+  if (!err.empty()) {
+    elog(INFO, (err + " Returning NULL.").c_str());
+    PG_RETURN_NULL();
+  }
+  PG_RETURN_FLOAT8(result);
+}
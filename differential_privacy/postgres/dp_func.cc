@@ -16,6 +16,9 @@
 
 #include "dp_func.h"
 
+#include <cstring>
+#include <new>
+
 #include "differential_privacy/algorithms/bounded-mean.h"
 #include "differential_privacy/algorithms/bounded-standard-deviation.h"
 #include "differential_privacy/algorithms/bounded-sum.h"
@@ -27,13 +30,61 @@
 using differential_privacy::Algorithm;
 using differential_privacy::BoundedMean;
 using differential_privacy::BoundedStandardDeviation;
+using differential_privacy::BoundedStatistics;
 using differential_privacy::BoundedSum;
 using differential_privacy::BoundedVariance;
+using differential_privacy::ColumnBatch;
 using differential_privacy::Count;
 using differential_privacy::DefaultEpsilon;
 using differential_privacy::GetValue;
+using differential_privacy::kNoResultOptions;
+using differential_privacy::Summary;
 using differential_privacy::continuous::Percentile;
 
+// Rank source of a continuous::Percentile that answers rank queries from a
+// SortedInput, which holds the inputs instead of the rank source.
+class SortedInputPercentile
+    : public differential_privacy::base::Percentile<double> {
+ public:
+  explicit SortedInputPercentile(SortedInput* input) : input_(input) {}
+
+  std::unique_ptr<differential_privacy::base::Percentile<double>> Clone()
+      const override {
+    return absl::make_unique<SortedInputPercentile>(input_);
+  }
+
+  // Inputs are only read from the SortedInput.
+  void Add(const double& t) override {}
+  void Reset() override {}
+
+  void SerializeToProto(
+      differential_privacy::BinarySearchSummary* summary) override {}
+
+  differential_privacy::base::Status MergeFromProto(
+      const differential_privacy::BinarySearchSummary& summary) override {
+    return differential_privacy::base::UnimplementedError(
+        "Cannot merge into a sorted input.");
+  }
+
+  int64_t Memory() override { return sizeof(SortedInputPercentile); }
+
+  int64_t num_values() override { return input_->size(); }
+
+  std::pair<double, double> GetRelativeRank(const double& t) override {
+    const int64_t size = input_->size();
+    if (size == 0 || std::isnan(t)) {
+      return std::make_pair(0, 1);
+    }
+    int64_t num_less, num_less_or_equal;
+    input_->Rank(t, &num_less, &num_less_or_equal);
+    return std::make_pair(static_cast<double>(num_less) / size,
+                          static_cast<double>(num_less_or_equal) / size);
+  }
+
+ private:
+  SortedInput* input_;
+};
+
 // Construct and return a bounded algorithm. Populate error if unsuccessful.
 template <typename Alg>
 Alg* BoundedAlgorithm(std::string* err, bool default_epsilon, double epsilon,
@@ -45,7 +96,9 @@ Alg* BoundedAlgorithm(std::string* err, bool default_epsilon, double epsilon,
   if (!auto_bounds) {
     builder.SetLower(lower).SetUpper(upper);
   }
-  auto build_statusor = builder.SetEpsilon(epsilon).Build();
+  // Only the value of results is returned, so skip their diagnostics.
+  auto build_statusor =
+      builder.SetEpsilon(epsilon).SetResultOptions(kNoResultOptions).Build();
   if (build_statusor.ok()) {
     return build_statusor.ValueOrDie().release();
   }
@@ -89,12 +142,176 @@ double AlgorithmResult(Algorithm<double>* alg, std::string* err) {
   return default_return;
 }
 
+bool DpFunc::AddEntries(const double* entries, int64_t num_entries) {
+  Algorithm<double>* alg = algorithm();
+  if (!alg) {
+    return false;
+  }
+  ColumnBatch<double> batch;
+  batch.values = absl::MakeConstSpan(entries, num_entries);
+  alg->AddColumnBatch(batch);
+  return true;
+}
+
+void DpFunc::SetParams(Params::Type type, double epsilon, bool auto_bounds,
+                       double lower, double upper, double percentile) {
+  params_.type = type;
+  params_.auto_bounds = auto_bounds;
+  params_.epsilon = epsilon;
+  params_.lower = lower;
+  params_.upper = upper;
+  params_.percentile = percentile;
+}
+
+std::string DpFunc::Serialize(std::string* err) {
+  Algorithm<double>* alg = algorithm();
+  if (!alg) {
+    *err = "Underlying algorithm was never constructed.";
+    return "";
+  }
+  std::string serialized(reinterpret_cast<const char*>(&params_),
+                         sizeof(Params));
+  if (!alg->Serialize().AppendToString(&serialized)) {
+    *err = "Failed to serialize the underlying algorithm.";
+    return "";
+  }
+  return serialized;
+}
+
+bool DpFunc::Merge(const std::string& serialized, std::string* err) {
+  Algorithm<double>* alg = algorithm();
+  if (!alg) {
+    *err = "Underlying algorithm was never constructed.";
+    return false;
+  }
+  Params params;
+  if (serialized.size() < sizeof(Params)) {
+    *err = "Serialized state is truncated.";
+    return false;
+  }
+  std::memcpy(&params, serialized.data(), sizeof(Params));
+  if (std::memcmp(&params, &params_, sizeof(Params)) != 0) {
+    *err = "Cannot merge functions with different parameters.";
+    return false;
+  }
+  Summary summary;
+  if (!summary.ParseFromArray(serialized.data() + sizeof(Params),
+                              serialized.size() - sizeof(Params))) {
+    *err = "Failed to parse the serialized state.";
+    return false;
+  }
+  auto status = alg->Merge(summary);
+  if (!status.ok()) {
+    *err = std::string(status.message());
+    return false;
+  }
+  return true;
+}
+
+int64_t DpFunc::MemoryUsed() {
+  Algorithm<double>* alg = algorithm();
+  return alg ? alg->MemoryUsed() : 0;
+}
+
+double DpFunc::FrameResult(std::string* err) {
+  Algorithm<double>* alg = algorithm();
+  if (!alg) {
+    *err = "Underlying algorithm was never constructed.";
+    return 0;
+  }
+  // Releasing the result consumes the privacy budget of the algorithm, so the
+  // entries are restored into the reset algorithm for the next frame.
+  Summary summary = alg->Serialize();
+  double result = Result(err);
+  alg->Reset();
+  auto status = alg->Merge(summary);
+  if (!status.ok() && err->empty()) {
+    *err = std::string(status.message());
+  }
+  return result;
+}
+
+// Constructs a DpFunction in memory from allocate, or with new if allocate is
+// null.
+template <typename DpFunction, typename... Args>
+DpFunction* ConstructDpFunc(DpFunc::Allocator allocate, void* context,
+                            Args... args) {
+  if (!allocate) {
+    return new DpFunction(args...);
+  }
+  return new (allocate(sizeof(DpFunction), context)) DpFunction(args...);
+}
+
+DpFunc* DpFunc::Deserialize(const std::string& serialized, std::string* err,
+                            Allocator allocate, void* context) {
+  Params params;
+  if (serialized.size() < sizeof(Params)) {
+    *err = "Serialized state is truncated.";
+    return nullptr;
+  }
+  std::memcpy(&params, serialized.data(), sizeof(Params));
+  const bool auto_bounds = params.auto_bounds != 0;
+  DpFunc* func;
+  switch (params.type) {
+    case Params::kCount:
+      func = ConstructDpFunc<DpCount>(allocate, context, err, false,
+                                      params.epsilon);
+      break;
+    case Params::kSum:
+      func = ConstructDpFunc<DpSum>(allocate, context, err, false,
+                                    params.epsilon, auto_bounds, params.lower,
+                                    params.upper);
+      break;
+    case Params::kMean:
+      func = ConstructDpFunc<DpMean>(allocate, context, err, false,
+                                     params.epsilon, auto_bounds, params.lower,
+                                     params.upper);
+      break;
+    case Params::kVariance:
+      func = ConstructDpFunc<DpVariance>(allocate, context, err, false,
+                                         params.epsilon, auto_bounds,
+                                         params.lower, params.upper);
+      break;
+    case Params::kStandardDeviation:
+      func = ConstructDpFunc<DpStandardDeviation>(
+          allocate, context, err, false, params.epsilon, auto_bounds,
+          params.lower, params.upper);
+      break;
+    case Params::kStats:
+      func = ConstructDpFunc<DpStats>(allocate, context, err, false,
+                                      params.epsilon, auto_bounds,
+                                      params.lower, params.upper);
+      break;
+    case Params::kNtile:
+      func = ConstructDpFunc<DpNtile>(allocate, context, err,
+                                      params.percentile, params.lower,
+                                      params.upper, false, params.epsilon);
+      break;
+    default:
+      *err = "Serialized state has an unknown function type.";
+      return nullptr;
+  }
+  if (!err->empty() || !func->Merge(serialized, err)) {
+    if (allocate) {
+      func->~DpFunc();
+    } else {
+      delete func;
+    }
+    return nullptr;
+  }
+  return func;
+}
+
 // DP count.
 DpCount::DpCount(std::string* err, bool default_epsilon, double epsilon) {
   if (default_epsilon) {
     epsilon = DefaultEpsilon();
   }
-  auto count_statusor = Count<double>::Builder().SetEpsilon(epsilon).Build();
+  SetParams(Params::kCount, epsilon);
+  auto count_statusor = Count<double>::Builder()
+                            .SetEpsilon(epsilon)
+                            .SetResultOptions(kNoResultOptions)
+                            .Build();
   if (count_statusor.ok()) {
     count_ = count_statusor.ValueOrDie().release();
   } else {
@@ -102,9 +319,13 @@ DpCount::DpCount(std::string* err, bool default_epsilon, double epsilon) {
   }
 }
 DpCount::~DpCount() { DeleteAlgorithm<Count<double>>(count_); }
+Algorithm<double>* DpCount::algorithm() { return count_; }
 bool DpCount::AddEntry(double entry) {
   return AlgorithmAddEntry(count_, entry);
 }
+bool DpCount::RemoveEntry(double entry) {
+  return count_ && count_->RemoveEntry(entry).ok();
+}
 double DpCount::Result(std::string* err) {
   return AlgorithmResult<int64_t>(count_, err);
 }
@@ -114,9 +335,15 @@ DpSum::DpSum(std::string* err, bool default_epsilon, double epsilon,
              bool auto_bounds, double lower, double upper) {
   sum_ = BoundedAlgorithm<BoundedSum<double, nullptr>>(
       err, default_epsilon, epsilon, auto_bounds, lower, upper);
+  SetParams(Params::kSum, default_epsilon ? DefaultEpsilon() : epsilon,
+            auto_bounds, lower, upper);
 }
 DpSum::~DpSum() { DeleteAlgorithm<BoundedSum<double, nullptr>>(sum_); }
+Algorithm<double>* DpSum::algorithm() { return sum_; }
 bool DpSum::AddEntry(double entry) { return AlgorithmAddEntry(sum_, entry); }
+bool DpSum::RemoveEntry(double entry) {
+  return sum_ && sum_->RemoveEntry(entry).ok();
+}
 double DpSum::Result(std::string* err) { return AlgorithmResult<double>(sum_, err); }
 
 // DP mean.
@@ -124,8 +351,11 @@ DpMean::DpMean(std::string* err, bool default_epsilon, double epsilon,
                bool auto_bounds, double lower, double upper) {
   mean_ = BoundedAlgorithm<BoundedMean<double, nullptr>>(
       err, default_epsilon, epsilon, auto_bounds, lower, upper);
+  SetParams(Params::kMean, default_epsilon ? DefaultEpsilon() : epsilon,
+            auto_bounds, lower, upper);
 }
 DpMean::~DpMean() { DeleteAlgorithm<BoundedMean<double, nullptr>>(mean_); }
+Algorithm<double>* DpMean::algorithm() { return mean_; }
 bool DpMean::AddEntry(double entry) { return AlgorithmAddEntry(mean_, entry); }
 double DpMean::Result(std::string* err) {
   return AlgorithmResult<double>(mean_, err);
@@ -136,10 +366,13 @@ DpVariance::DpVariance(std::string* err, bool default_epsilon, double epsilon,
                        bool auto_bounds, double lower, double upper) {
   var_ = BoundedAlgorithm<BoundedVariance<double, nullptr>>(
       err, default_epsilon, epsilon, auto_bounds, lower, upper);
+  SetParams(Params::kVariance, default_epsilon ? DefaultEpsilon() : epsilon,
+            auto_bounds, lower, upper);
 }
 DpVariance::~DpVariance() {
   DeleteAlgorithm<BoundedVariance<double, nullptr>>(var_);
 }
+Algorithm<double>* DpVariance::algorithm() { return var_; }
 bool DpVariance::AddEntry(double entry) {
   return AlgorithmAddEntry(var_, entry);
 }
@@ -153,10 +386,14 @@ DpStandardDeviation::DpStandardDeviation(std::string* err, bool default_epsilon,
                                          double lower, double upper) {
   sd_ = BoundedAlgorithm<BoundedStandardDeviation<double, nullptr>>(
       err, default_epsilon, epsilon, auto_bounds, lower, upper);
+  SetParams(Params::kStandardDeviation,
+            default_epsilon ? DefaultEpsilon() : epsilon, auto_bounds, lower,
+            upper);
 }
 DpStandardDeviation::~DpStandardDeviation() {
   DeleteAlgorithm<BoundedStandardDeviation<double, nullptr>>(sd_);
 }
+Algorithm<double>* DpStandardDeviation::algorithm() { return sd_; }
 bool DpStandardDeviation::AddEntry(double entry) {
   return AlgorithmAddEntry(sd_, entry);
 }
@@ -164,6 +401,38 @@ double DpStandardDeviation::Result(std::string* err) {
   return AlgorithmResult<double>(sd_, err);
 }
 
+// DP statistics.
+DpStats::DpStats(std::string* err, bool default_epsilon, double epsilon,
+                 bool auto_bounds, double lower, double upper) {
+  var_ = BoundedAlgorithm<BoundedVariance<double, nullptr>>(
+      err, default_epsilon, epsilon, auto_bounds, lower, upper);
+  SetParams(Params::kStats, default_epsilon ? DefaultEpsilon() : epsilon,
+            auto_bounds, lower, upper);
+}
+DpStats::~DpStats() { DeleteAlgorithm<BoundedVariance<double, nullptr>>(var_); }
+Algorithm<double>* DpStats::algorithm() { return var_; }
+bool DpStats::AddEntry(double entry) { return AlgorithmAddEntry(var_, entry); }
+double DpStats::Result(std::string* err) { return Statistics(err).variance; }
+DpStatistics DpStats::Statistics(std::string* err) {
+  DpStatistics statistics;
+  if (!var_) {
+    *err = "Underlying algorithm was never constructed.";
+    return statistics;
+  }
+  auto statistics_statusor = var_->PartialStatistics();
+  if (!statistics_statusor.ok()) {
+    *err = std::string(statistics_statusor.status().message());
+    return statistics;
+  }
+  const BoundedStatistics& noisy = statistics_statusor.ValueOrDie();
+  statistics.count = std::round(noisy.count);
+  statistics.sum = noisy.sum;
+  statistics.mean = noisy.mean;
+  statistics.variance = noisy.variance;
+  statistics.standard_deviation = std::sqrt(noisy.variance);
+  return statistics;
+}
+
 // DP Ntile.
 DpNtile::DpNtile(std::string* err, double percentile, double lower, double upper,
                  bool default_epsilon, double epsilon) {
@@ -175,7 +444,10 @@ DpNtile::DpNtile(std::string* err, double percentile, double lower, double upper
                             .SetEpsilon(epsilon)
                             .SetLower(lower)
                             .SetUpper(upper)
+                            .SetResultOptions(kNoResultOptions)
                             .Build();
+  SetParams(Params::kNtile, epsilon, /*auto_bounds=*/false, lower, upper,
+            percentile);
   if (build_statusor.ok()) {
     perc_ = build_statusor.ValueOrDie().release();
   } else {
@@ -183,7 +455,31 @@ DpNtile::DpNtile(std::string* err, double percentile, double lower, double upper
   }
 }
 DpNtile::~DpNtile() { DeleteAlgorithm<Percentile<double>>(perc_); }
+Algorithm<double>* DpNtile::algorithm() { return perc_; }
 bool DpNtile::AddEntry(double entry) { return AlgorithmAddEntry(perc_, entry); }
 double DpNtile::Result(std::string* err) {
   return AlgorithmResult<double>(perc_, err);
 }
+
+// DP percentile of sorted input.
+double DpSortedPercentile(SortedInput* input, double percentile, double lower,
+                          double upper, bool default_epsilon, double epsilon,
+                          std::string* err) {
+  if (default_epsilon) {
+    epsilon = DefaultEpsilon();
+  }
+  auto build_statusor =
+      Percentile<double>::Builder()
+          .SetPercentile(percentile)
+          .SetEpsilon(epsilon)
+          .SetLower(lower)
+          .SetUpper(upper)
+          .SetRankSource(absl::make_unique<SortedInputPercentile>(input))
+          .SetResultOptions(kNoResultOptions)
+          .Build();
+  if (!build_statusor.ok()) {
+    *err = std::string(build_statusor.status().message());
+    return 0;
+  }
+  return AlgorithmResult<double>(build_statusor.ValueOrDie().get(), err);
+}
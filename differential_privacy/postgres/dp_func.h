@@ -27,6 +27,9 @@
 // include these directly into anon_func.cc.
 namespace differential_privacy {
 
+template <typename T>
+class Algorithm;
+
 template <typename T>
 class Count;
 
@@ -68,6 +71,18 @@ class DpFunc {
   virtual bool AddEntry(double entry) = 0;
   bool AddEntry(int64_t entry) { return AddEntry(static_cast<double>(entry)); }
 
+  // Adds num_entries entries from a buffer, without the per-entry overhead of
+  // AddEntry. Returns true if adding the entries is successful.
+  bool AddEntries(const double* entries, int64_t num_entries);
+
+  // Removes an entry that was previously added, e.g. when it leaves the frame
+  // of a moving aggregate. Returns true if removing the entry is successful.
+  // Only functions whose state is invertible support removal.
+  virtual bool RemoveEntry(double entry) { return false; }
+  bool RemoveEntry(int64_t entry) {
+    return RemoveEntry(static_cast<double>(entry));
+  }
+
   // Result can only be called once per function. Iff grabbing the result fails,
   // the error std::string is populated and we return 0.
   virtual double Result(std::string* err) = 0;
@@ -75,6 +90,74 @@ class DpFunc {
   // Same as result, but the result is rounded to be an integer. Only Result or
   // ResultRounded may be called per function.
   int64_t ResultRounded(std::string* err) { return std::round(Result(err)); }
+
+  // Returns the result for the current frame of a moving aggregate. Unlike
+  // Result, the entries are kept so that the function can move on to the next
+  // frame, and every frame is a separate release with the function's epsilon.
+  // Iff grabbing the result fails, the error std::string is populated.
+  double FrameResult(std::string* err);
+
+  // Same as FrameResult, but the result is rounded to be an integer.
+  int64_t FrameResultRounded(std::string* err) {
+    return std::round(FrameResult(err));
+  }
+
+  // Returns the memory used by the underlying algorithm, in bytes, excluding
+  // the function object itself.
+  int64_t MemoryUsed();
+
+  // Serializes the state of the function together with the parameters it was
+  // constructed with, so that the states of parallel workers can be combined.
+  // Iff serialization fails, the error std::string is populated.
+  std::string Serialize(std::string* err);
+
+  // Merges the serialized state of a function of the same type and parameters
+  // into this function. Returns false and populates the error std::string if
+  // unsuccessful.
+  bool Merge(const std::string& serialized, std::string* err);
+
+  // Allocates size bytes of memory for a function, given the context passed
+  // to Deserialize.
+  using Allocator = void* (*)(size_t size, void* context);
+
+  // Constructs a function from its serialized state. Returns nullptr and
+  // populates the error std::string if unsuccessful. The function is
+  // allocated with new, unless an allocator is given. The caller must then
+  // call the destructor of the function and release its memory.
+  static DpFunc* Deserialize(const std::string& serialized, std::string* err,
+                             Allocator allocate = nullptr,
+                             void* context = nullptr);
+
+ protected:
+  // The type of a function and the parameters it was constructed with, which
+  // are serialized ahead of its state. All fields are 8 bytes wide so that the
+  // struct has no padding.
+  struct Params {
+    enum Type : int64_t {
+      kCount,
+      kSum,
+      kMean,
+      kVariance,
+      kStandardDeviation,
+      kNtile,
+      kStats,
+    };
+    Type type;
+    int64_t auto_bounds;
+    double epsilon;
+    double lower;
+    double upper;
+    double percentile;
+  };
+
+  // Records the parameters that the function was constructed with.
+  void SetParams(Params::Type type, double epsilon, bool auto_bounds = false,
+                 double lower = 0, double upper = 0, double percentile = 0);
+
+  // Returns the underlying algorithm, or nullptr if it was never constructed.
+  virtual differential_privacy::Algorithm<double>* algorithm() = 0;
+
+  Params params_ = {};
 };
 
 class DpCount : public DpFunc {
@@ -82,8 +165,12 @@ class DpCount : public DpFunc {
   DpCount(std::string* err, bool default_epsilon = true, double epsilon = 0);
   ~DpCount() override;
   bool AddEntry(double entry) override;
+  bool RemoveEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::Count<double>* count_ = nullptr;
 };
@@ -94,8 +181,14 @@ class DpSum : public DpFunc {
         bool auto_bounds = true, double lower = 0, double upper = 0);
   ~DpSum() override;
   bool AddEntry(double entry) override;
+
+  // Removing entries is only supported with manual bounds.
+  bool RemoveEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::BoundedSum<double, nullptr>* sum_ = nullptr;
 };
@@ -108,6 +201,9 @@ class DpMean : public DpFunc {
   bool AddEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::BoundedMean<double, nullptr>* mean_ = nullptr;
 };
@@ -120,6 +216,9 @@ class DpVariance : public DpFunc {
   bool AddEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::BoundedVariance<double, nullptr>* var_ = nullptr;
 };
@@ -133,11 +232,49 @@ class DpStandardDeviation : public DpFunc {
   bool AddEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::BoundedStandardDeviation<double, nullptr>* sd_ =
       nullptr;
 };
 
+// Statistics released together by DpStats.
+struct DpStatistics {
+  int64_t count = 0;
+  double sum = 0;
+  double mean = 0;
+  double variance = 0;
+  double standard_deviation = 0;
+};
+
+// DP count, sum, mean, variance and standard deviation of the same entries,
+// computed from a single BoundedVariance. All statistics are derived from the
+// noisy values computed for the variance, so they share one state, one bounds
+// computation and the privacy budget of a single result.
+class DpStats : public DpFunc {
+ public:
+  DpStats(std::string* err, bool default_epsilon = true, double epsilon = 0,
+          bool auto_bounds = true, double lower = 0, double upper = 0);
+  ~DpStats() override;
+  bool AddEntry(double entry) override;
+
+  // Returns the variance, like DpVariance.
+  double Result(std::string* err) override;
+
+  // Returns all statistics. Only Result or Statistics may be called per
+  // function. Iff grabbing the statistics fails, the error std::string is
+  // populated.
+  DpStatistics Statistics(std::string* err);
+
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
+ private:
+  differential_privacy::BoundedVariance<double, nullptr>* var_ = nullptr;
+};
+
 class DpNtile : public DpFunc {
  public:
   // For the ntile function, require bounds because algorithm performs very
@@ -148,8 +285,34 @@ class DpNtile : public DpFunc {
   bool AddEntry(double entry) override;
   double Result(std::string* err) override;
 
+ protected:
+  differential_privacy::Algorithm<double>* algorithm() override;
+
  private:
   differential_privacy::continuous::Percentile<double>* perc_ = nullptr;
 };
 
+// Input set of an ordered-set aggregate, which the caller stores in sorted
+// order, e.g. in a tuplesort that spills to disk beyond work_mem.
+class SortedInput {
+ public:
+  virtual ~SortedInput() = default;
+
+  // Returns the number of inputs.
+  virtual int64_t size() = 0;
+
+  // Sets num_less and num_less_or_equal to the number of inputs less than, and
+  // less than or equal to, value.
+  virtual void Rank(double value, int64_t* num_less,
+                    int64_t* num_less_or_equal) = 0;
+};
+
+// Returns the DP percentile of a sorted input set, searched for between lower
+// and upper. The binary search queries the ranks of the input directly, so
+// the inputs are never copied. Iff computing the percentile fails, the error
+// std::string is populated and we return 0.
+double DpSortedPercentile(SortedInput* input, double percentile, double lower,
+                          double upper, bool default_epsilon, double epsilon,
+                          std::string* err);
+
 #endif  // THIRD_PARTY_DIFFERENTIAL_PRIVACY_POSTGRES_DP_FUNC_H
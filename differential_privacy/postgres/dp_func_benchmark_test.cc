@@ -0,0 +1,201 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Drives the DP functions of the postgres extension through the lifecycle of a
+// grouped aggregation, without a database: the first row of a group
+// constructs its function, every row adds an entry, and each group's result is
+// extracted once. For each function and number of groups, reports
+//
+//   ns_per_row:      ingest cost of a row, including constructing functions
+//   ns_per_extract:  latency of extracting the result of a group
+//   bytes_per_group: memory of a function and its algorithm after ingest
+//
+// The auto_bounds argument of the bounded functions selects automatic bounds.
+// The number of rows and the numbers of groups are set with --rows and
+// --groups, next to the usual --benchmark_* flags, e.g.
+//
+//   dp_func_benchmark_test --rows=1000000 --groups=1,10,100000
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "benchmark/benchmark.h"
+#include "differential_privacy/postgres/dp_func.h"
+
+ABSL_FLAG(int64_t, rows, 1 << 18, "Number of rows of each aggregation.");
+ABSL_FLAG(std::string, groups, "1,64,1024",
+          "Comma-separated numbers of groups the rows are spread across.");
+
+namespace {
+
+constexpr double kLower = 0;
+constexpr double kUpper = 100;
+
+// Synthetic rows: a group and an entry per row, drawn uniformly.
+struct Workload {
+  std::vector<int64_t> groups;
+  std::vector<double> entries;
+};
+
+Workload MakeWorkload(int64_t num_rows, int64_t num_groups) {
+  std::mt19937_64 gen(num_groups);
+  std::uniform_int_distribution<int64_t> group(0, num_groups - 1);
+  std::uniform_real_distribution<double> entry(kLower, kUpper);
+  Workload workload;
+  workload.groups.resize(num_rows);
+  workload.entries.resize(num_rows);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    workload.groups[i] = group(gen);
+    workload.entries[i] = entry(gen);
+  }
+  return workload;
+}
+
+// Constructs a function as its accum function does on the first row of a
+// group.
+template <typename DpFunction>
+std::unique_ptr<DpFunc> NewFunc(std::string* err, bool auto_bounds) {
+  return absl::make_unique<DpFunction>(err, true, 0, auto_bounds, kLower,
+                                       kUpper);
+}
+
+template <>
+std::unique_ptr<DpFunc> NewFunc<DpCount>(std::string* err, bool auto_bounds) {
+  return absl::make_unique<DpCount>(err);
+}
+
+template <>
+std::unique_ptr<DpFunc> NewFunc<DpNtile>(std::string* err, bool auto_bounds) {
+  return absl::make_unique<DpNtile>(err, .5, kLower, kUpper);
+}
+
+double ElapsedNanoseconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <typename DpFunction>
+void BM_Aggregate(benchmark::State& state) {
+  const int64_t num_rows = state.range(0);
+  const int64_t num_groups = state.range(1);
+  const bool auto_bounds = state.range(2) != 0;
+  const Workload workload = MakeWorkload(num_rows, num_groups);
+  double ingest_ns = 0, extract_ns = 0, bytes = 0;
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<DpFunc>> funcs(num_groups);
+    std::string err;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < num_rows; ++i) {
+      std::unique_ptr<DpFunc>& func = funcs[workload.groups[i]];
+      if (!func) {
+        func = NewFunc<DpFunction>(&err, auto_bounds);
+      }
+      func->AddEntry(workload.entries[i]);
+    }
+    ingest_ns += ElapsedNanoseconds(start);
+
+    int64_t used = 0;
+    for (const std::unique_ptr<DpFunc>& func : funcs) {
+      if (func) {
+        used += sizeof(DpFunction) + func->MemoryUsed();
+      }
+    }
+    bytes += static_cast<double>(used) / num_groups;
+
+    start = std::chrono::steady_clock::now();
+    for (const std::unique_ptr<DpFunc>& func : funcs) {
+      if (func) {
+        benchmark::DoNotOptimize(func->Result(&err));
+      }
+    }
+    extract_ns += ElapsedNanoseconds(start);
+    if (!err.empty()) {
+      state.SkipWithError(err.c_str());
+      break;
+    }
+
+    // Destroying the functions is not part of either phase.
+    state.PauseTiming();
+    funcs.clear();
+    state.ResumeTiming();
+  }
+  const double iterations = state.iterations();
+  state.SetItemsProcessed(state.iterations() * num_rows);
+  state.counters["ns_per_row"] = ingest_ns / (iterations * num_rows);
+  state.counters["ns_per_extract"] = extract_ns / (iterations * num_groups);
+  state.counters["bytes_per_group"] = bytes / iterations;
+}
+
+// Registers BM_Aggregate of DpFunction for each number of groups, and with
+// automatic bounds too if bounded.
+template <typename DpFunction>
+void RegisterAggregate(const std::string& name, bool bounded, int64_t num_rows,
+                       const std::vector<int64_t>& num_groups) {
+  benchmark::internal::Benchmark* benchmark =
+      benchmark::RegisterBenchmark(("BM_Aggregate<" + name + ">").c_str(),
+                                   BM_Aggregate<DpFunction>);
+  benchmark->ArgNames({"rows", "groups", "auto_bounds"});
+  for (int auto_bounds = 0; auto_bounds <= bounded; ++auto_bounds) {
+    for (int64_t groups : num_groups) {
+      benchmark->Args({num_rows, groups, auto_bounds});
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Consumes the --benchmark_* flags, so that only ours are left to parse.
+  benchmark::Initialize(&argc, argv);
+  absl::ParseCommandLine(argc, argv);
+  const int64_t num_rows = absl::GetFlag(FLAGS_rows);
+  if (num_rows <= 0) {
+    std::fprintf(stderr, "--rows must be positive.\n");
+    return 1;
+  }
+  std::vector<int64_t> num_groups;
+  for (absl::string_view field :
+       absl::StrSplit(absl::GetFlag(FLAGS_groups), ',')) {
+    int64_t value;
+    if (!absl::SimpleAtoi(field, &value) || value <= 0) {
+      std::fprintf(stderr, "--groups must be positive integers.\n");
+      return 1;
+    }
+    num_groups.push_back(value);
+  }
+
+  RegisterAggregate<DpCount>("DpCount", false, num_rows, num_groups);
+  RegisterAggregate<DpSum>("DpSum", true, num_rows, num_groups);
+  RegisterAggregate<DpMean>("DpMean", true, num_rows, num_groups);
+  RegisterAggregate<DpVariance>("DpVariance", true, num_rows, num_groups);
+  RegisterAggregate<DpStandardDeviation>("DpStandardDeviation", true, num_rows,
+                                         num_groups);
+  RegisterAggregate<DpNtile>("DpNtile", false, num_rows, num_groups);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
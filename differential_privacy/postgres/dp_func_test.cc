@@ -1,14 +1,45 @@
 #include "differential_privacy/postgres/dp_func.h"
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 namespace {
 
+// SortedInput over a sorted vector, which counts rank queries.
+class VectorSortedInput : public SortedInput {
+ public:
+  explicit VectorSortedInput(std::vector<double> values)
+      : values_(std::move(values)) {}
+
+  int64_t size() override { return values_.size(); }
+
+  void Rank(double value, int64_t* num_less,
+            int64_t* num_less_or_equal) override {
+    ++num_queries_;
+    *num_less = std::lower_bound(values_.begin(), values_.end(), value) -
+                values_.begin();
+    *num_less_or_equal =
+        std::upper_bound(values_.begin(), values_.end(), value) -
+        values_.begin();
+  }
+
+  int num_queries() const { return num_queries_; }
+
+ private:
+  std::vector<double> values_;
+  int num_queries_ = 0;
+};
+
 template <typename T>
 class BoundedDpFuncTest : public ::testing::Test {};
 
-typedef ::testing::Types<DpSum, DpMean, DpVariance, DpStandardDeviation>
+typedef ::testing::Types<DpSum, DpMean, DpVariance, DpStandardDeviation,
+                         DpStats>
     BoundedDpFuncs;
 TYPED_TEST_SUITE(BoundedDpFuncTest, BoundedDpFuncs);
 
@@ -49,6 +80,28 @@ TYPED_TEST(BoundedDpFuncTest, BasicTest) {
   EXPECT_TRUE(err.empty());
 }
 
+TEST(DpStats, StatisticsTest) {
+  std::string err;
+  auto func = DpStats(&err, false, 1e6, false, 0, 10);
+  for (double entry : {1, 2, 3, 6}) {
+    EXPECT_TRUE(func.AddEntry(entry));
+  }
+  DpStatistics statistics = func.Statistics(&err);
+  EXPECT_TRUE(err.empty());
+  EXPECT_EQ(statistics.count, 4);
+  EXPECT_NEAR(statistics.sum, 12, .01);
+  EXPECT_NEAR(statistics.mean, 3, .01);
+  EXPECT_NEAR(statistics.variance, 3.5, .01);
+  EXPECT_NEAR(statistics.standard_deviation, std::sqrt(3.5), .01);
+}
+
+TEST(DpStats, StatisticsMissingAlgorithm) {
+  std::string err;
+  auto func = DpStats(&err, false, 0);
+  static_cast<void>(func.Statistics(&err));
+  EXPECT_EQ(err, "Underlying algorithm was never constructed.");
+}
+
 TEST(DpNtile, BadPercentile) {
   std::string err;
   auto func = DpNtile(&err, -1, 0, 10);
@@ -70,4 +123,167 @@ TEST(DpNtile, BasicTest) {
   EXPECT_TRUE(err.empty());
 }
 
+TYPED_TEST(BoundedDpFuncTest, AddEntries) {
+  std::string err;
+  auto func = TypeParam(&err, false, 1, false, 0, 5);
+  auto expected = TypeParam(&err, false, 1, false, 0, 5);
+  std::vector<double> entries = {1, 2, 7, -1};
+  EXPECT_TRUE(func.AddEntries(entries.data(), entries.size()));
+  for (double entry : entries) {
+    EXPECT_TRUE(expected.AddEntry(entry));
+  }
+  EXPECT_EQ(func.Serialize(&err), expected.Serialize(&err));
+}
+
+TYPED_TEST(BoundedDpFuncTest, MemoryUsed) {
+  std::string err;
+  auto func = TypeParam(&err, true, 0, false, 0, 5);
+  EXPECT_GT(func.MemoryUsed(), 0);
+  auto missing = TypeParam(&err, false, 0);
+  EXPECT_EQ(missing.MemoryUsed(), 0);
+}
+
+TEST(DpCount, AddEntriesMissingAlgorithm) {
+  std::string err;
+  auto dp_count = DpCount(&err, false, 0);
+  double entry = 1;
+  EXPECT_FALSE(dp_count.AddEntries(&entry, 1));
+}
+
+TYPED_TEST(BoundedDpFuncTest, SerializeAndDeserialize) {
+  std::string err;
+  auto func = TypeParam(&err, false, 1, false, 0, 5);
+  EXPECT_TRUE(func.AddEntry(1));
+  EXPECT_TRUE(func.AddEntry(2));
+  std::string serialized = func.Serialize(&err);
+  EXPECT_TRUE(err.empty());
+
+  std::unique_ptr<DpFunc> copy(DpFunc::Deserialize(serialized, &err));
+  ASSERT_NE(copy, nullptr);
+  EXPECT_TRUE(err.empty());
+  EXPECT_NE(dynamic_cast<TypeParam*>(copy.get()), nullptr);
+  EXPECT_EQ(copy->Serialize(&err), serialized);
+}
+
+TYPED_TEST(BoundedDpFuncTest, MergeTest) {
+  std::string err;
+  auto func1 = TypeParam(&err, false, 1, false, 0, 5);
+  auto func2 = TypeParam(&err, false, 1, false, 0, 5);
+  auto all = TypeParam(&err, false, 1, false, 0, 5);
+  EXPECT_TRUE(func1.AddEntry(1));
+  EXPECT_TRUE(func2.AddEntry(2));
+  EXPECT_TRUE(func2.AddEntry(3));
+  for (double entry : {1, 2, 3}) {
+    EXPECT_TRUE(all.AddEntry(entry));
+  }
+  EXPECT_TRUE(func1.Merge(func2.Serialize(&err), &err));
+  EXPECT_TRUE(err.empty());
+  EXPECT_EQ(func1.Serialize(&err), all.Serialize(&err));
+}
+
+TYPED_TEST(BoundedDpFuncTest, MergeDifferentParameters) {
+  std::string err;
+  auto func1 = TypeParam(&err, false, 1, false, 0, 5);
+  auto func2 = TypeParam(&err, false, 1, false, 0, 6);
+  EXPECT_FALSE(func1.Merge(func2.Serialize(&err), &err));
+  EXPECT_EQ(err, "Cannot merge functions with different parameters.");
+}
+
+TEST(DpFunc, DeserializeInvalid) {
+  std::string err;
+  EXPECT_EQ(DpFunc::Deserialize("invalid", &err), nullptr);
+  EXPECT_EQ(err, "Serialized state is truncated.");
+}
+
+TEST(DpFunc, DeserializeWithAllocator) {
+  std::string err;
+  auto func = DpSum(&err, false, 1, false, 0, 5);
+  EXPECT_TRUE(func.AddEntry(1));
+  std::string serialized = func.Serialize(&err);
+
+  std::vector<size_t> sizes;
+  DpFunc::Allocator allocate = [](size_t size, void* context) -> void* {
+    static_cast<std::vector<size_t>*>(context)->push_back(size);
+    return ::operator new(size);
+  };
+  DpFunc* copy = DpFunc::Deserialize(serialized, &err, allocate, &sizes);
+  ASSERT_NE(copy, nullptr);
+  EXPECT_THAT(sizes, ::testing::ElementsAre(sizeof(DpSum)));
+  EXPECT_EQ(copy->Serialize(&err), serialized);
+  copy->~DpFunc();
+  ::operator delete(copy);
+}
+
+TEST(DpCount, MovingFrames) {
+  std::string err;
+  auto func = DpCount(&err, false, 1e6);
+  EXPECT_FALSE(func.RemoveEntry(1));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(func.AddEntry(1));
+  }
+  EXPECT_EQ(func.FrameResultRounded(&err), 3);
+  EXPECT_EQ(func.FrameResultRounded(&err), 3);
+  EXPECT_TRUE(func.RemoveEntry(1));
+  EXPECT_EQ(func.FrameResultRounded(&err), 2);
+  EXPECT_TRUE(err.empty());
+}
+
+TEST(DpSum, MovingFrames) {
+  std::string err;
+  auto func = DpSum(&err, false, 1e6, false, 0, 5);
+  for (double entry : {1, 2, 10}) {
+    EXPECT_TRUE(func.AddEntry(entry));
+  }
+  EXPECT_NEAR(func.FrameResult(&err), 8, .01);
+  EXPECT_TRUE(func.RemoveEntry(10));
+  EXPECT_NEAR(func.FrameResult(&err), 3, .01);
+  EXPECT_TRUE(func.RemoveEntry(1));
+  EXPECT_NEAR(func.FrameResult(&err), 2, .01);
+  EXPECT_TRUE(err.empty());
+}
+
+TEST(DpSum, RemoveEntryRequiresManualBounds) {
+  std::string err;
+  auto func = DpSum(&err);
+  EXPECT_TRUE(func.AddEntry(1));
+  EXPECT_FALSE(func.RemoveEntry(1));
+  auto mean = DpMean(&err, true, 0, false, 0, 5);
+  EXPECT_TRUE(mean.AddEntry(1));
+  EXPECT_FALSE(mean.RemoveEntry(1.0));
+}
+
+TEST(DpNtile, MergeTest) {
+  std::string err;
+  auto func1 = DpNtile(&err, .5, 0, 10);
+  auto func2 = DpNtile(&err, .5, 0, 10);
+  auto all = DpNtile(&err, .5, 0, 10);
+  EXPECT_TRUE(func1.AddEntry(1));
+  EXPECT_TRUE(func2.AddEntry(2));
+  EXPECT_TRUE(all.AddEntry(1));
+  EXPECT_TRUE(all.AddEntry(2));
+  EXPECT_TRUE(func1.Merge(func2.Serialize(&err), &err));
+  EXPECT_TRUE(err.empty());
+  EXPECT_EQ(func1.Serialize(&err), all.Serialize(&err));
+}
+
+TEST(DpSortedPercentile, BasicTest) {
+  std::vector<double> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(i);
+  }
+  VectorSortedInput input(values);
+  std::string err;
+  double median = DpSortedPercentile(&input, .5, 0, 1000, false, 1e6, &err);
+  EXPECT_TRUE(err.empty());
+  EXPECT_NEAR(median, 500, 5);
+  EXPECT_GT(input.num_queries(), 0);
+}
+
+TEST(DpSortedPercentile, BadPercentile) {
+  VectorSortedInput input({1, 2, 3});
+  std::string err;
+  EXPECT_EQ(DpSortedPercentile(&input, -1, 0, 10, true, 0, &err), 0);
+  EXPECT_EQ(err, "Percentile must be between 0 and 1.");
+}
+
 }  // namespace
@@ -18,7 +18,12 @@
 #define DIFFERENTIAL_PRIVACY_PROTO_UTIL_H_
 
 #include <limits>
+#include <type_traits>
+#include <vector>
 
+#include "google/protobuf/repeated_field.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/statusor.h"
 #include "differential_privacy/proto/data.pb.h"
 
 namespace differential_privacy {
@@ -137,5 +142,107 @@ void AddToOutput(Output* output, T value) {
   element->mutable_value()->set_float_value(value);
 }
 
+// Summaries store numeric partial values in a pair of packed fields, one for
+// integers and one for floating point values, and only the field matching the
+// type of the values is used. Older summaries store them as a repeated
+// ValueType instead.
+namespace internal {
+
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+google::protobuf::RepeatedField<int64_t>* PackedField(
+    google::protobuf::RepeatedField<int64_t>* int_values,
+    google::protobuf::RepeatedField<double>* double_values) {
+  return int_values;
+}
+
+template <typename T, typename std::enable_if<
+                          std::is_floating_point<T>::value>::type* = nullptr>
+google::protobuf::RepeatedField<double>* PackedField(
+    google::protobuf::RepeatedField<int64_t>* int_values,
+    google::protobuf::RepeatedField<double>* double_values) {
+  return double_values;
+}
+
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+const google::protobuf::RepeatedField<int64_t>& PackedField(
+    const google::protobuf::RepeatedField<int64_t>& int_values,
+    const google::protobuf::RepeatedField<double>& double_values) {
+  return int_values;
+}
+
+template <typename T, typename std::enable_if<
+                          std::is_floating_point<T>::value>::type* = nullptr>
+const google::protobuf::RepeatedField<double>& PackedField(
+    const google::protobuf::RepeatedField<int64_t>& int_values,
+    const google::protobuf::RepeatedField<double>& double_values) {
+  return double_values;
+}
+
+}  // namespace internal
+
+// Appends the values to whichever of int_values and double_values matches T.
+template <typename T>
+void AddPackedValues(const std::vector<T>& values,
+                     google::protobuf::RepeatedField<int64_t>* int_values,
+                     google::protobuf::RepeatedField<double>* double_values) {
+  auto* field = internal::PackedField<T>(int_values, double_values);
+  field->Reserve(field->size() + values.size());
+  for (const T& value : values) {
+    field->AddAlreadyReserved(value);
+  }
+}
+
+// Read-only view of values written by AddPackedValues. If the packed field
+// matching T is empty, the view reads the legacy ValueType field instead, so
+// that summaries written by older versions can still be merged.
+template <typename T>
+class PackedValues {
+ public:
+  // Returns a view of the values, or an error if they were packed into the
+  // field of the other type, e.g. integers for a view of doubles. Such values
+  // come from an algorithm with a different input type and cannot be merged.
+  static base::StatusOr<PackedValues<T>> Read(
+      const google::protobuf::RepeatedField<int64_t>& int_values,
+      const google::protobuf::RepeatedField<double>& double_values,
+      const google::protobuf::RepeatedPtrField<ValueType>& legacy_values) {
+    if (std::is_integral<T>::value ? !double_values.empty()
+                                   : !int_values.empty()) {
+      return base::InvalidArgumentError(
+          "Summary values were packed for a different input type.");
+    }
+    return PackedValues<T>(int_values, double_values, legacy_values);
+  }
+
+  int size() const {
+    return legacy_ ? legacy_values_.size()
+                   : internal::PackedField<T>(int_values_, double_values_)
+                         .size();
+  }
+
+  T operator[](int i) const {
+    return legacy_ ? GetValue<T>(legacy_values_.Get(i))
+                   : static_cast<T>(internal::PackedField<T>(
+                         int_values_, double_values_).Get(i));
+  }
+
+ private:
+  PackedValues(
+      const google::protobuf::RepeatedField<int64_t>& int_values,
+      const google::protobuf::RepeatedField<double>& double_values,
+      const google::protobuf::RepeatedPtrField<ValueType>& legacy_values)
+      : int_values_(int_values),
+        double_values_(double_values),
+        legacy_values_(legacy_values),
+        legacy_(internal::PackedField<T>(int_values, double_values).empty() &&
+                !legacy_values.empty()) {}
+
+  const google::protobuf::RepeatedField<int64_t>& int_values_;
+  const google::protobuf::RepeatedField<double>& double_values_;
+  const google::protobuf::RepeatedPtrField<ValueType>& legacy_values_;
+  const bool legacy_;
+};
+
 }  // namespace differential_privacy
 #endif  // DIFFERENTIAL_PRIVACY_PROTO_UTIL_H_
@@ -89,6 +89,80 @@ TEST(UtilTest, MakeValueType) {
   EXPECT_EQ(v.float_value(), 1.0);
 }
 
+TEST(UtilTest, PackedValuesInt) {
+  google::protobuf::RepeatedField<int64_t> int_values;
+  google::protobuf::RepeatedField<double> double_values;
+  google::protobuf::RepeatedPtrField<ValueType> legacy_values;
+  AddPackedValues<int>({1, -2, 3}, &int_values, &double_values);
+  EXPECT_EQ(int_values.size(), 3);
+  EXPECT_TRUE(double_values.empty());
+
+  PackedValues<int> values =
+      PackedValues<int>::Read(int_values, double_values, legacy_values)
+          .ValueOrDie();
+  ASSERT_EQ(values.size(), 3);
+  EXPECT_EQ(values[0], 1);
+  EXPECT_EQ(values[1], -2);
+  EXPECT_EQ(values[2], 3);
+}
+
+TEST(UtilTest, PackedValuesDouble) {
+  google::protobuf::RepeatedField<int64_t> int_values;
+  google::protobuf::RepeatedField<double> double_values;
+  google::protobuf::RepeatedPtrField<ValueType> legacy_values;
+  AddPackedValues<double>({.5, -1.5}, &int_values, &double_values);
+  EXPECT_TRUE(int_values.empty());
+
+  PackedValues<double> values =
+      PackedValues<double>::Read(int_values, double_values, legacy_values)
+          .ValueOrDie();
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(values[0], .5);
+  EXPECT_EQ(values[1], -1.5);
+}
+
+TEST(UtilTest, PackedValuesLegacy) {
+  google::protobuf::RepeatedField<int64_t> int_values;
+  google::protobuf::RepeatedField<double> double_values;
+  google::protobuf::RepeatedPtrField<ValueType> legacy_values;
+  *legacy_values.Add() = MakeValueType(4.0);
+  *legacy_values.Add() = MakeValueType(-2.0);
+
+  PackedValues<double> values =
+      PackedValues<double>::Read(int_values, double_values, legacy_values)
+          .ValueOrDie();
+  ASSERT_EQ(values.size(), 2);
+  EXPECT_EQ(values[0], 4.0);
+  EXPECT_EQ(values[1], -2.0);
+
+  // Packed values take precedence over legacy values.
+  double_values.Add(1.0);
+  PackedValues<double> packed =
+      PackedValues<double>::Read(int_values, double_values, legacy_values)
+          .ValueOrDie();
+  ASSERT_EQ(packed.size(), 1);
+  EXPECT_EQ(packed[0], 1.0);
+}
+
+TEST(UtilTest, PackedValuesWrongType) {
+  google::protobuf::RepeatedField<int64_t> int_values;
+  google::protobuf::RepeatedField<double> double_values;
+  google::protobuf::RepeatedPtrField<ValueType> legacy_values;
+  AddPackedValues<int>({1, 2}, &int_values, &double_values);
+  EXPECT_EQ(
+      PackedValues<double>::Read(int_values, double_values, legacy_values)
+          .status()
+          .code(),
+      base::StatusCode::kInvalidArgument);
+
+  int_values.Clear();
+  AddPackedValues<double>({.5}, &int_values, &double_values);
+  EXPECT_EQ(PackedValues<int>::Read(int_values, double_values, legacy_values)
+                .status()
+                .code(),
+            base::StatusCode::kInvalidArgument);
+}
+
 }  // namespace
 
 }  // namespace differential_privacy
@@ -0,0 +1,208 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/report/csv_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "differential_privacy/base/canonical_errors.h"
+
+namespace differential_privacy {
+namespace report {
+namespace {
+
+using base::InternalError;
+using base::Status;
+using base::StatusOr;
+
+constexpr int64_t kBlockSize = 64;
+
+Status ErrnoError(absl::string_view action, const std::string& path) {
+  return InternalError(absl::StrCat("Failed to ", action, " ", path, ": ",
+                                    std::strerror(errno)));
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<CsvReader>> CsvReader::Open(const std::string& path,
+                                                     char delimiter) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ErrnoError("open", path);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    Status status = ErrnoError("stat", path);
+    close(fd);
+    return status;
+  }
+  const int64_t size = file_stat.st_size;
+  if (size == 0) {
+    // Empty files cannot be mapped.
+    close(fd);
+    return absl::make_unique<CsvReader>(absl::string_view(), delimiter);
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ErrnoError("map", path);
+  }
+  // Rows are read once, front to back, so let the kernel read ahead.
+  madvise(mapping, size, MADV_SEQUENTIAL);
+  return std::unique_ptr<CsvReader>(new CsvReader(
+      static_cast<const char*>(mapping), size, delimiter, /*mapped=*/true));
+}
+
+CsvReader::CsvReader(absl::string_view data, char delimiter)
+    : CsvReader(data.data(), data.size(), delimiter, /*mapped=*/false) {}
+
+CsvReader::CsvReader(const char* data, int64_t size, char delimiter,
+                     bool mapped)
+    : data_(data),
+      end_(data + size),
+      pos_(data),
+      size_(size),
+      delimiter_(delimiter),
+      mapped_(mapped) {}
+
+CsvReader::~CsvReader() {
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+bool CsvReader::NextRow(std::vector<absl::string_view>* fields) {
+  fields->clear();
+  while (pos_ < end_ && (*pos_ == '\n' || (*pos_ == '\r' && pos_ + 1 < end_ &&
+                                           pos_[1] == '\n'))) {
+    ++pos_;
+  }
+  if (pos_ >= end_) {
+    return false;
+  }
+  while (true) {
+    const char* begin = pos_;
+    const char* field_end;
+    if (begin < end_ && *begin == '"') {
+      // Find the closing quote, stepping over escaped quotes. Anything between
+      // the closing quote and the end of the field is ignored.
+      const char* quote = begin + 1;
+      while (true) {
+        quote = static_cast<const char*>(
+            std::memchr(quote, '"', end_ - quote));
+        if (!quote || quote + 1 == end_ || quote[1] != '"') {
+          break;
+        }
+        quote += 2;
+      }
+      if (!quote) {
+        // Unterminated quote; the field runs to the end of the data.
+        fields->emplace_back(begin + 1, end_ - begin - 1);
+        pos_ = end_;
+        return true;
+      }
+      fields->emplace_back(begin + 1, quote - begin - 1);
+      field_end = FindFieldEnd(quote + 1);
+    } else {
+      field_end = FindFieldEnd(begin);
+      const char* value_end = field_end;
+      if (value_end > begin && value_end[-1] == '\r' &&
+          (value_end == end_ || *value_end == '\n')) {
+        --value_end;
+      }
+      fields->emplace_back(begin, value_end - begin);
+    }
+    if (field_end == end_) {
+      pos_ = end_;
+      return true;
+    }
+    pos_ = field_end + 1;
+    if (*field_end == '\n') {
+      return true;
+    }
+    if (pos_ == end_) {
+      // The data ends in a delimiter, so the last field is empty.
+      fields->emplace_back();
+      return true;
+    }
+  }
+}
+
+const char* CsvReader::FindFieldEnd(const char* p) {
+  const char* block = data_ + ((p - data_) & ~(kBlockSize - 1));
+  uint64_t mask;
+  if (block == block_) {
+    mask = block_mask_;
+  } else {
+    block_ = block;
+    mask = block_mask_ = BlockMask();
+  }
+  mask &= ~uint64_t{0} << (p - block);
+  while (mask == 0) {
+    block += kBlockSize;
+    if (block >= end_) {
+      return end_;
+    }
+    block_ = block;
+    mask = block_mask_ = BlockMask();
+  }
+  return block + __builtin_ctzll(mask);
+}
+
+uint64_t CsvReader::BlockMask() const {
+  const int64_t remaining = end_ - block_;
+#ifdef __SSE2__
+  if (remaining >= kBlockSize) {
+    const __m128i delimiter = _mm_set1_epi8(delimiter_);
+    const __m128i newline = _mm_set1_epi8('\n');
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      const __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(block_ + 16 * i));
+      const __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(bytes, delimiter),
+                                           _mm_cmpeq_epi8(bytes, newline));
+      mask |= static_cast<uint64_t>(static_cast<uint16_t>(
+                  _mm_movemask_epi8(matches)))
+              << (16 * i);
+    }
+    return mask;
+  }
+#endif
+  uint64_t mask = 0;
+  const int64_t n = std::min(remaining, kBlockSize);
+  for (int64_t i = 0; i < n; ++i) {
+    if (block_[i] == delimiter_ || block_[i] == '\n') {
+      mask |= uint64_t{1} << i;
+    }
+  }
+  return mask;
+}
+
+}  // namespace report
+}  // namespace differential_privacy
@@ -0,0 +1,83 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_REPORT_CSV_READER_H_
+#define DIFFERENTIAL_PRIVACY_REPORT_CSV_READER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "differential_privacy/base/statusor.h"
+
+namespace differential_privacy {
+namespace report {
+
+// Streaming reader of delimiter-separated rows, e.g. a CSV file. Files are
+// read through a read-only memory mapping and fields are returned as views
+// into it, so rows are parsed without copying.
+//
+// The end of each field is found by scanning 64 bytes at a time for the
+// delimiter and newline characters, with SSE2 where available. Fields may be
+// enclosed in double quotes to contain delimiters and newlines; the quotes are
+// removed, but escaped quotes ("") inside a field are returned as is. Lines may
+// end in "\n" or "\r\n", and empty lines are skipped.
+class CsvReader {
+ public:
+  // Maps the file at path.
+  static base::StatusOr<std::unique_ptr<CsvReader>> Open(
+      const std::string& path, char delimiter = ',');
+
+  // Reads rows from data, which must outlive the reader.
+  explicit CsvReader(absl::string_view data, char delimiter = ',');
+
+  ~CsvReader();
+
+  CsvReader(const CsvReader&) = delete;
+  CsvReader& operator=(const CsvReader&) = delete;
+
+  // Parses the next row into fields. The fields are valid for the lifetime of
+  // the reader. Returns false if there are no more rows.
+  bool NextRow(std::vector<absl::string_view>* fields);
+
+ private:
+  CsvReader(const char* data, int64_t size, char delimiter, bool mapped);
+
+  // Returns the first delimiter or newline at or after p, or end_.
+  const char* FindFieldEnd(const char* p);
+
+  // Returns the bitmask of delimiters and newlines of the 64 bytes from
+  // block_, or of the remaining bytes if there are fewer.
+  uint64_t BlockMask() const;
+
+  const char* data_;
+  const char* end_;
+  const char* pos_;
+  const int64_t size_;
+  const char delimiter_;
+  const bool mapped_;
+
+  // Block of 64 bytes whose delimiters and newlines are set in block_mask_.
+  const char* block_ = nullptr;
+  uint64_t block_mask_ = 0;
+};
+
+}  // namespace report
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_REPORT_CSV_READER_H_
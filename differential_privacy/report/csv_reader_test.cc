@@ -0,0 +1,128 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/report/csv_reader.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace report {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::IsEmpty;
+
+std::vector<std::vector<std::string>> ReadAll(CsvReader* reader) {
+  std::vector<std::vector<std::string>> rows;
+  std::vector<absl::string_view> fields;
+  while (reader->NextRow(&fields)) {
+    rows.emplace_back(fields.begin(), fields.end());
+  }
+  return rows;
+}
+
+std::vector<std::vector<std::string>> ReadAll(absl::string_view data,
+                                              char delimiter = ',') {
+  CsvReader reader(data, delimiter);
+  return ReadAll(&reader);
+}
+
+using Row = std::vector<std::string>;
+
+TEST(CsvReaderTest, Rows) {
+  EXPECT_THAT(ReadAll("a,b,c\n1,2,3\n"),
+              ElementsAre(Row{"a", "b", "c"}, Row{"1", "2", "3"}));
+  // No newline at the end of the data.
+  EXPECT_THAT(ReadAll("a,b\n1,2"), ElementsAre(Row{"a", "b"}, Row{"1", "2"}));
+}
+
+TEST(CsvReaderTest, EmptyFields) {
+  EXPECT_THAT(ReadAll(",a,,b,\n,"),
+              ElementsAre(Row{"", "a", "", "b", ""}, Row{"", ""}));
+}
+
+TEST(CsvReaderTest, LineEndings) {
+  EXPECT_THAT(ReadAll("a,b\r\n1,2\r\n\r\n\n3,4\r"),
+              ElementsAre(Row{"a", "b"}, Row{"1", "2"}, Row{"3", "4"}));
+  // Carriage returns within a line are kept.
+  EXPECT_THAT(ReadAll("a\rb,c\n"), ElementsAre(Row{"a\rb", "c"}));
+}
+
+TEST(CsvReaderTest, QuotedFields) {
+  EXPECT_THAT(ReadAll("\"a,b\",\"c\nd\",e\n\"\",f"),
+              ElementsAre(Row{"a,b", "c\nd", "e"}, Row{"", "f"}));
+  // Escaped quotes are not unescaped.
+  EXPECT_THAT(ReadAll("\"a \"\"b\"\"\",c\n"),
+              ElementsAre(Row{"a \"\"b\"\"", "c"}));
+  // An unterminated quote runs to the end of the data.
+  EXPECT_THAT(ReadAll("a,\"b,c\nd"), ElementsAre(Row{"a", "b,c\nd"}));
+}
+
+TEST(CsvReaderTest, Delimiter) {
+  EXPECT_THAT(ReadAll("a\tb,c\n", '\t'), ElementsAre(Row{"a", "b,c"}));
+}
+
+TEST(CsvReaderTest, Empty) {
+  EXPECT_THAT(ReadAll(""), IsEmpty());
+  EXPECT_THAT(ReadAll("\n\r\n"), IsEmpty());
+}
+
+TEST(CsvReaderTest, FieldsAcrossBlocks) {
+  // Fields of many lengths, so that fields start, end and span the boundaries
+  // of the 64-byte blocks that are scanned at once.
+  std::string data;
+  std::vector<Row> expected;
+  for (int i = 0; i < 200; ++i) {
+    Row row = {std::string(i % 70, 'x'), absl::StrCat(i),
+               std::string(i % 3, 'y')};
+    absl::StrAppend(&data, row[0], ",", row[1], ",", row[2], "\n");
+    expected.push_back(row);
+  }
+  EXPECT_THAT(ReadAll(data), ElementsAreArray(expected));
+}
+
+TEST(CsvReaderTest, Open) {
+  const std::string path = ::testing::TempDir() + "/csv_reader_test.csv";
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "a;b\n1;2\n";
+  }
+  base::StatusOr<std::unique_ptr<CsvReader>> reader =
+      CsvReader::Open(path, ';');
+  ASSERT_TRUE(reader.ok());
+  EXPECT_THAT(ReadAll(reader.ValueOrDie().get()),
+              ElementsAre(Row{"a", "b"}, Row{"1", "2"}));
+
+  { std::ofstream file(path, std::ios::binary | std::ios::trunc); }
+  reader = CsvReader::Open(path);
+  ASSERT_TRUE(reader.ok());
+  EXPECT_THAT(ReadAll(reader.ValueOrDie().get()), IsEmpty());
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(CsvReader::Open(path).ok());
+}
+
+}  // namespace
+}  // namespace report
+}  // namespace differential_privacy
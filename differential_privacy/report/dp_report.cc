@@ -0,0 +1,214 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Writes a differentially private report of a CSV file to stdout, as CSV rows
+// of group, aggregation and value. For example,
+//
+//   dp_report --input=animals.csv --group_by=species --value=carrots
+//       --aggregations=count,mean --bounds=0,100 --epsilon=1 --delta=1e-6
+//
+// See README.md for the privacy guarantee of the report.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "differential_privacy/algorithms/util.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/report/csv_reader.h"
+#include "differential_privacy/report/grouped_report.h"
+
+using absl::PrintF;
+using differential_privacy::DefaultEpsilon;
+using differential_privacy::base::InvalidArgumentError;
+using differential_privacy::base::Status;
+using differential_privacy::base::StatusOr;
+using differential_privacy::report::Aggregation;
+using differential_privacy::report::AggregationName;
+using differential_privacy::report::CsvReader;
+using differential_privacy::report::GroupedReport;
+using differential_privacy::report::ParseAggregation;
+using differential_privacy::report::ReportOptions;
+using differential_privacy::report::ReportRow;
+
+ABSL_FLAG(std::string, input, "", "Path to the CSV file.");
+ABSL_FLAG(std::string, delimiter, ",", "Field delimiter of the CSV file.");
+ABSL_FLAG(bool, header, true,
+          "Whether the first row of the file names the columns.");
+ABSL_FLAG(std::string, group_by, "",
+          "Name or zero-based index of the column to group rows by.");
+ABSL_FLAG(std::string, value, "",
+          "Name or zero-based index of the column to aggregate. Empty or "
+          "non-numeric values are null. Only count may be used without it.");
+ABSL_FLAG(std::string, aggregations, "count",
+          "Comma-separated aggregations: count, sum, mean, variance, stddev.");
+ABSL_FLAG(double, epsilon, DefaultEpsilon(),
+          "Privacy budget of each aggregation of each group.");
+ABSL_FLAG(std::string, bounds, "",
+          "Bounds on the values as lower,upper. If empty, bounds are found "
+          "per group, spending part of the budget.");
+ABSL_FLAG(std::string, groups, "",
+          "Comma-separated groups to report. If empty, groups found in the "
+          "file are reported only if their noisy row count passes a threshold "
+          "set by --delta.");
+ABSL_FLAG(double, delta, 0,
+          "Delta of the selection of the groups found in the file, in (0, 1). "
+          "Required unless --groups is set.");
+
+namespace {
+
+// Returns the index of the column named by flag, either by its name in the
+// header or by its zero-based index.
+StatusOr<int> ColumnIndex(absl::string_view flag,
+                          const std::vector<absl::string_view>& header) {
+  for (int i = 0; i < header.size(); ++i) {
+    if (header[i] == flag) {
+      return i;
+    }
+  }
+  int index;
+  if (absl::SimpleAtoi(flag, &index) && index >= 0) {
+    return index;
+  }
+  return InvalidArgumentError(
+      absl::StrFormat("No column named %s in the header.", flag));
+}
+
+StatusOr<ReportOptions> OptionsFromFlags() {
+  ReportOptions options;
+  for (absl::string_view name :
+       absl::StrSplit(absl::GetFlag(FLAGS_aggregations), ',')) {
+    ASSIGN_OR_RETURN(Aggregation aggregation, ParseAggregation(name));
+    options.aggregations.push_back(aggregation);
+  }
+  options.epsilon = absl::GetFlag(FLAGS_epsilon);
+  const std::string bounds = absl::GetFlag(FLAGS_bounds);
+  if (!bounds.empty()) {
+    std::vector<absl::string_view> parts = absl::StrSplit(bounds, ',');
+    if (parts.size() != 2 || !absl::SimpleAtod(parts[0], &options.lower) ||
+        !absl::SimpleAtod(parts[1], &options.upper)) {
+      return InvalidArgumentError("--bounds must be lower,upper.");
+    }
+    options.has_bounds = true;
+  }
+  const std::string groups = absl::GetFlag(FLAGS_groups);
+  if (!groups.empty()) {
+    options.public_groups = absl::StrSplit(groups, ',');
+  }
+  options.delta = absl::GetFlag(FLAGS_delta);
+  return options;
+}
+
+// Quotes field if it would otherwise not be read back as a single field.
+std::string CsvField(const std::string& field) {
+  if (field.find_first_of(",\"\r\n") == std::string::npos) {
+    return field;
+  }
+  std::string quoted = "\"";
+  for (char c : field) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+Status Run() {
+  ASSIGN_OR_RETURN(ReportOptions options, OptionsFromFlags());
+  const std::string value_flag = absl::GetFlag(FLAGS_value);
+  for (Aggregation aggregation : options.aggregations) {
+    if (aggregation != Aggregation::kCount && value_flag.empty()) {
+      return InvalidArgumentError(
+          absl::StrFormat("--value is required for %s.",
+                          AggregationName(aggregation)));
+    }
+  }
+  if (absl::GetFlag(FLAGS_group_by).empty()) {
+    return InvalidArgumentError("--group_by is required.");
+  }
+  const std::string delimiter = absl::GetFlag(FLAGS_delimiter);
+  if (delimiter.size() != 1) {
+    return InvalidArgumentError("--delimiter must be a single character.");
+  }
+  ASSIGN_OR_RETURN(std::unique_ptr<GroupedReport> report,
+                   GroupedReport::Create(options));
+  ASSIGN_OR_RETURN(std::unique_ptr<CsvReader> reader,
+                   CsvReader::Open(absl::GetFlag(FLAGS_input), delimiter[0]));
+
+  std::vector<absl::string_view> fields;
+  std::vector<absl::string_view> header;
+  if (absl::GetFlag(FLAGS_header) && reader->NextRow(&fields)) {
+    header = fields;
+  }
+  ASSIGN_OR_RETURN(int group_column,
+                   ColumnIndex(absl::GetFlag(FLAGS_group_by), header));
+  int value_column = -1;
+  if (!value_flag.empty()) {
+    ASSIGN_OR_RETURN(value_column, ColumnIndex(value_flag, header));
+  }
+
+  int64_t line = header.empty() ? 0 : 1;
+  while (reader->NextRow(&fields)) {
+    ++line;
+    const int num_fields = fields.size();
+    if (group_column >= num_fields || value_column >= num_fields) {
+      return InvalidArgumentError(
+          absl::StrFormat("Row %d has only %d fields.", line, num_fields));
+    }
+    double value = 0;
+    // Without a value column, every row is counted.
+    const bool valid =
+        value_column < 0 || absl::SimpleAtod(fields[value_column], &value);
+    Status status = report->AddRow(fields[group_column], value, valid);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  PrintF("group,aggregation,value\n");
+  for (const ReportRow& row : report->Results()) {
+    if (!row.value.ok()) {
+      std::fprintf(stderr, "%s of %s: %s\n",
+                   AggregationName(row.aggregation).c_str(), row.group.c_str(),
+                   row.value.status().ToString().c_str());
+      PrintF("%s,%s,\n", CsvField(row.group), AggregationName(row.aggregation));
+      continue;
+    }
+    PrintF("%s,%s,%.10g\n", CsvField(row.group),
+           AggregationName(row.aggregation), row.value.ValueOrDie());
+  }
+  return differential_privacy::base::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  Status status = Run();
+  if (!status.ok()) {
+    std::fprintf(stderr, "%s\n", status.ToString().c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,236 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/report/grouped_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "differential_privacy/algorithms/bounded-mean.h"
+#include "differential_privacy/algorithms/bounded-standard-deviation.h"
+#include "differential_privacy/algorithms/bounded-sum.h"
+#include "differential_privacy/algorithms/bounded-variance.h"
+#include "differential_privacy/algorithms/column-batch.h"
+#include "differential_privacy/algorithms/count.h"
+#include "differential_privacy/base/canonical_errors.h"
+#include "differential_privacy/base/status_macros.h"
+#include "differential_privacy/proto/util.h"
+
+namespace differential_privacy {
+namespace report {
+namespace {
+
+using base::InvalidArgumentError;
+using base::Status;
+using base::StatusOr;
+
+template <typename Builder>
+StatusOr<std::unique_ptr<Algorithm<double>>> BuildBounded(
+    const ReportOptions& options) {
+  Builder builder;
+  builder.SetEpsilon(options.epsilon);
+  if (options.has_bounds) {
+    builder.SetLower(options.lower).SetUpper(options.upper);
+  }
+  ASSIGN_OR_RETURN(auto algorithm, builder.Build());
+  return std::unique_ptr<Algorithm<double>>(std::move(algorithm));
+}
+
+StatusOr<std::unique_ptr<Algorithm<double>>> BuildAlgorithm(
+    Aggregation aggregation, const ReportOptions& options) {
+  switch (aggregation) {
+    case Aggregation::kCount: {
+      ASSIGN_OR_RETURN(auto count, Count<double>::Builder()
+                                       .SetEpsilon(options.epsilon)
+                                       .Build());
+      return std::unique_ptr<Algorithm<double>>(std::move(count));
+    }
+    case Aggregation::kSum:
+      return BuildBounded<BoundedSum<double>::Builder>(options);
+    case Aggregation::kMean:
+      return BuildBounded<BoundedMean<double>::Builder>(options);
+    case Aggregation::kVariance:
+      return BuildBounded<BoundedVariance<double>::Builder>(options);
+    case Aggregation::kStandardDeviation:
+      return BuildBounded<BoundedStandardDeviation<double>::Builder>(options);
+  }
+  return InvalidArgumentError("Unknown aggregation.");
+}
+
+}  // namespace
+
+StatusOr<Aggregation> ParseAggregation(absl::string_view name) {
+  if (name == "count") return Aggregation::kCount;
+  if (name == "sum") return Aggregation::kSum;
+  if (name == "mean") return Aggregation::kMean;
+  if (name == "variance") return Aggregation::kVariance;
+  if (name == "stddev") return Aggregation::kStandardDeviation;
+  return InvalidArgumentError(
+      absl::StrCat("Unknown aggregation: ", name,
+                   ". Expected count, sum, mean, variance or stddev."));
+}
+
+std::string AggregationName(Aggregation aggregation) {
+  switch (aggregation) {
+    case Aggregation::kCount:
+      return "count";
+    case Aggregation::kSum:
+      return "sum";
+    case Aggregation::kMean:
+      return "mean";
+    case Aggregation::kVariance:
+      return "variance";
+    case Aggregation::kStandardDeviation:
+      return "stddev";
+  }
+  return "";
+}
+
+StatusOr<std::unique_ptr<GroupedReport>> GroupedReport::Create(
+    const ReportOptions& options) {
+  if (options.aggregations.empty()) {
+    return InvalidArgumentError("At least one aggregation is required.");
+  }
+  if (options.has_bounds && !(options.lower <= options.upper)) {
+    return InvalidArgumentError(
+        "Lower bound must not be greater than upper bound.");
+  }
+  std::unique_ptr<GroupedReport> report(new GroupedReport(options));
+  // Building the algorithms of a group validates the options, so that groups
+  // can be created while adding rows without failing.
+  Status status = report->NewGroup().status();
+  if (!status.ok()) {
+    return status;
+  }
+  if (options.public_groups.empty()) {
+    if (!(options.delta > 0 && options.delta < 1)) {
+      return InvalidArgumentError(
+          "Delta must be in (0, 1) to select the groups found in the data. "
+          "Otherwise, list the public groups.");
+    }
+    ASSIGN_OR_RETURN(
+        report->selection_mechanism_,
+        LaplaceMechanism::Builder().SetEpsilon(options.epsilon).Build());
+    report->selection_threshold_ =
+        1 + std::log(1 / (2 * options.delta)) / options.epsilon;
+  }
+  for (const std::string& key : options.public_groups) {
+    if (report->groups_.contains(key)) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(report->groups_[key], report->NewGroup());
+  }
+  return report;
+}
+
+GroupedReport::GroupedReport(const ReportOptions& options)
+    : options_(options) {}
+
+StatusOr<std::unique_ptr<GroupedReport::Group>> GroupedReport::NewGroup()
+    const {
+  auto group = absl::make_unique<Group>();
+  for (Aggregation aggregation : options_.aggregations) {
+    ASSIGN_OR_RETURN(std::unique_ptr<Algorithm<double>> algorithm,
+                     BuildAlgorithm(aggregation, options_));
+    group->algorithms.push_back(std::move(algorithm));
+  }
+  group->values.reserve(kBatchSize);
+  group->validity.reserve(kBatchSize / 8);
+  return group;
+}
+
+Status GroupedReport::AddRow(absl::string_view group_key, double value,
+                             bool valid) {
+  auto it = groups_.find(group_key);
+  if (it == groups_.end()) {
+    if (!options_.public_groups.empty()) {
+      return base::OkStatus();
+    }
+    ASSIGN_OR_RETURN(std::unique_ptr<Group> group, NewGroup());
+    it = groups_.emplace(std::string(group_key), std::move(group)).first;
+  }
+  Group* group = it->second.get();
+  ++group->num_rows;
+  const int64_t row = group->values.size();
+  if (row % 8 == 0) {
+    group->validity.push_back(0);
+  }
+  group->values.push_back(value);
+  group->validity.back() |= valid << (row % 8);
+  if (row + 1 == kBatchSize) {
+    Flush(group);
+  }
+  return base::OkStatus();
+}
+
+void GroupedReport::Flush(Group* group) {
+  if (group->values.empty()) {
+    return;
+  }
+  ColumnBatch<double> batch;
+  batch.values = group->values;
+  batch.validity = group->validity.data();
+  for (const std::unique_ptr<Algorithm<double>>& algorithm :
+       group->algorithms) {
+    algorithm->AddColumnBatch(batch);
+  }
+  group->values.clear();
+  group->validity.clear();
+}
+
+std::vector<ReportRow> GroupedReport::Results() {
+  std::vector<const std::string*> keys;
+  keys.reserve(groups_.size());
+  for (const auto& entry : groups_) {
+    keys.push_back(&entry.first);
+  }
+  std::sort(keys.begin(), keys.end(),
+            [](const std::string* a, const std::string* b) { return *a < *b; });
+
+  std::vector<ReportRow> rows;
+  rows.reserve(keys.size() * options_.aggregations.size());
+  for (const std::string* key : keys) {
+    Group* group = groups_[*key].get();
+    // Each user adds one row to one group, so the row count of a group has
+    // sensitivity one.
+    if (selection_mechanism_ &&
+        selection_mechanism_->AddNoise(group->num_rows) <
+            selection_threshold_) {
+      continue;
+    }
+    Flush(group);
+    for (int i = 0; i < options_.aggregations.size(); ++i) {
+      const Aggregation aggregation = options_.aggregations[i];
+      StatusOr<Output> output = group->algorithms[i]->PartialResult();
+      if (!output.ok()) {
+        rows.push_back({*key, aggregation, output.status()});
+        continue;
+      }
+      // Counts are integers; all other aggregations are floating point.
+      const double value = aggregation == Aggregation::kCount
+                               ? GetValue<int64_t>(output.ValueOrDie())
+                               : GetValue<double>(output.ValueOrDie());
+      rows.push_back({*key, aggregation, value});
+    }
+  }
+  return rows;
+}
+
+}  // namespace report
+}  // namespace differential_privacy
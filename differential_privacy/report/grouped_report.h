@@ -0,0 +1,124 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef DIFFERENTIAL_PRIVACY_REPORT_GROUPED_REPORT_H_
+#define DIFFERENTIAL_PRIVACY_REPORT_GROUPED_REPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "differential_privacy/algorithms/algorithm.h"
+#include "differential_privacy/algorithms/numerical-mechanisms.h"
+#include "differential_privacy/algorithms/util.h"
+#include "differential_privacy/base/statusor.h"
+
+namespace differential_privacy {
+namespace report {
+
+enum class Aggregation { kCount, kSum, kMean, kVariance, kStandardDeviation };
+
+// Parses the name of an aggregation: count, sum, mean, variance or stddev.
+base::StatusOr<Aggregation> ParseAggregation(absl::string_view name);
+
+// Returns the name of the aggregation as accepted by ParseAggregation.
+std::string AggregationName(Aggregation aggregation);
+
+struct ReportOptions {
+  std::vector<Aggregation> aggregations;
+
+  // Privacy budget of each aggregation of each group.
+  double epsilon = DefaultEpsilon();
+
+  // Bounds on the values. If unset, each group's algorithms find bounds from
+  // its values, spending part of their budget to do so.
+  bool has_bounds = false;
+  double lower = 0;
+  double upper = 0;
+
+  // If not empty, the groups to report. Rows of other groups are dropped and
+  // every listed group is reported, even if it has no rows. Otherwise, the
+  // groups found in the data are selected with delta below.
+  std::vector<std::string> public_groups;
+
+  // Without public groups, a group found in the data is reported only if its
+  // number of rows plus Laplace noise of scale 1 / epsilon is at least
+  // 1 + ln(1 / (2 * delta)) / epsilon. Which groups are reported is then
+  // (epsilon, delta)-differentially private, spending epsilon once more. Must
+  // be in (0, 1) unless public_groups is set.
+  double delta = 0;
+};
+
+struct ReportRow {
+  std::string group;
+  Aggregation aggregation;
+  base::StatusOr<double> value;
+};
+
+// Computes differentially private aggregations of values per group, as in
+//
+//   SELECT group, COUNT(value), SUM(value), ... GROUP BY group
+//
+// Each row is assumed to be the contribution of a distinct user. Values are
+// buffered per group and added to the group's algorithms in column batches.
+class GroupedReport {
+ public:
+  static base::StatusOr<std::unique_ptr<GroupedReport>> Create(
+      const ReportOptions& options);
+
+  // Adds a row to its group. Null values, which have valid set to false, are
+  // skipped by all aggregations.
+  base::Status AddRow(absl::string_view group, double value, bool valid);
+
+  // Returns the results of each reported group, ordered by group and then in
+  // the order of the aggregations. Consumes the privacy budget; no rows may be
+  // added afterwards.
+  std::vector<ReportRow> Results();
+
+ private:
+  // Number of values buffered per group before they are added to its
+  // algorithms.
+  static constexpr int64_t kBatchSize = 256;
+
+  struct Group {
+    std::vector<std::unique_ptr<Algorithm<double>>> algorithms;
+    int64_t num_rows = 0;
+    std::vector<double> values;
+    std::vector<uint8_t> validity;
+  };
+
+  explicit GroupedReport(const ReportOptions& options);
+
+  base::StatusOr<std::unique_ptr<Group>> NewGroup() const;
+
+  // Adds the buffered values of the group to its algorithms.
+  static void Flush(Group* group);
+
+  const ReportOptions options_;
+  absl::flat_hash_map<std::string, std::unique_ptr<Group>> groups_;
+
+  // Selects the groups found in the data. Null with public groups.
+  std::unique_ptr<LaplaceMechanism> selection_mechanism_;
+  double selection_threshold_ = 0;
+};
+
+}  // namespace report
+}  // namespace differential_privacy
+
+#endif  // DIFFERENTIAL_PRIVACY_REPORT_GROUPED_REPORT_H_
@@ -0,0 +1,153 @@
+//
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "differential_privacy/report/grouped_report.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace differential_privacy {
+namespace report {
+namespace {
+
+// Large enough that the noise is negligible.
+constexpr double kEpsilon = 1e8;
+
+ReportOptions BoundedOptions(std::vector<Aggregation> aggregations) {
+  ReportOptions options;
+  options.aggregations = aggregations;
+  options.epsilon = kEpsilon;
+  options.has_bounds = true;
+  options.lower = 0;
+  options.upper = 10;
+  options.delta = 1e-5;
+  return options;
+}
+
+std::unique_ptr<GroupedReport> MakeReport(const ReportOptions& options) {
+  base::StatusOr<std::unique_ptr<GroupedReport>> report =
+      GroupedReport::Create(options);
+  EXPECT_TRUE(report.ok());
+  return std::move(report.ValueOrDie());
+}
+
+TEST(GroupedReportTest, ParseAggregation) {
+  for (Aggregation aggregation :
+       {Aggregation::kCount, Aggregation::kSum, Aggregation::kMean,
+        Aggregation::kVariance, Aggregation::kStandardDeviation}) {
+    base::StatusOr<Aggregation> parsed =
+        ParseAggregation(AggregationName(aggregation));
+    ASSERT_TRUE(parsed.ok());
+    EXPECT_EQ(parsed.ValueOrDie(), aggregation);
+  }
+  EXPECT_FALSE(ParseAggregation("median").ok());
+}
+
+TEST(GroupedReportTest, Create) {
+  EXPECT_FALSE(GroupedReport::Create(ReportOptions()).ok());
+  ReportOptions options = BoundedOptions({Aggregation::kSum});
+  options.epsilon = -1;
+  EXPECT_FALSE(GroupedReport::Create(options).ok());
+  options = BoundedOptions({Aggregation::kSum});
+  options.lower = 20;
+  EXPECT_FALSE(GroupedReport::Create(options).ok());
+
+  // Groups found in the data need a delta to be selected.
+  options = BoundedOptions({Aggregation::kSum});
+  options.delta = 0;
+  EXPECT_FALSE(GroupedReport::Create(options).ok());
+  options.delta = 1;
+  EXPECT_FALSE(GroupedReport::Create(options).ok());
+  options.public_groups = {"a"};
+  EXPECT_TRUE(GroupedReport::Create(options).ok());
+}
+
+TEST(GroupedReportTest, Groups) {
+  std::unique_ptr<GroupedReport> report = MakeReport(BoundedOptions(
+      {Aggregation::kCount, Aggregation::kSum, Aggregation::kMean}));
+  // Enough rows to fill several batches of group "a".
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(report->AddRow("a", i % 2 ? 2 : 4, true).ok());
+  }
+  EXPECT_TRUE(report->AddRow("b", 5, true).ok());
+  EXPECT_TRUE(report->AddRow("b", 0, false).ok());
+  // Values are clamped to the bounds.
+  EXPECT_TRUE(report->AddRow("b", 100, true).ok());
+
+  std::vector<ReportRow> rows = report->Results();
+  ASSERT_EQ(rows.size(), 6);
+  const std::vector<std::string> groups = {"a", "a", "a", "b", "b", "b"};
+  const std::vector<Aggregation> aggregations = {
+      Aggregation::kCount, Aggregation::kSum, Aggregation::kMean,
+      Aggregation::kCount, Aggregation::kSum, Aggregation::kMean};
+  const std::vector<double> expected = {1000, 3000, 3, 2, 15, 7.5};
+  for (int i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows[i].group, groups[i]);
+    EXPECT_EQ(rows[i].aggregation, aggregations[i]);
+    ASSERT_TRUE(rows[i].value.ok());
+    EXPECT_NEAR(rows[i].value.ValueOrDie(), expected[i], 1e-3);
+  }
+}
+
+TEST(GroupedReportTest, SelectsGroups) {
+  ReportOptions options = BoundedOptions({Aggregation::kCount});
+  options.epsilon = 1;
+  std::unique_ptr<GroupedReport> report = MakeReport(options);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(report->AddRow("large", 1, true).ok());
+  }
+  // A group with a single user is reported with probability at most delta.
+  EXPECT_TRUE(report->AddRow("single", 1, true).ok());
+
+  std::vector<ReportRow> rows = report->Results();
+  ASSERT_EQ(rows.size(), 1);
+  EXPECT_EQ(rows[0].group, "large");
+}
+
+TEST(GroupedReportTest, PublicGroups) {
+  ReportOptions options = BoundedOptions({Aggregation::kCount});
+  options.public_groups = {"b", "c"};
+  std::unique_ptr<GroupedReport> report = MakeReport(options);
+  EXPECT_TRUE(report->AddRow("a", 1, true).ok());
+  EXPECT_TRUE(report->AddRow("b", 1, true).ok());
+
+  std::vector<ReportRow> rows = report->Results();
+  ASSERT_EQ(rows.size(), 2);
+  EXPECT_EQ(rows[0].group, "b");
+  EXPECT_NEAR(rows[0].value.ValueOrDie(), 1, 1e-3);
+  EXPECT_EQ(rows[1].group, "c");
+  EXPECT_NEAR(rows[1].value.ValueOrDie(), 0, 1e-3);
+}
+
+TEST(GroupedReportTest, AutomaticBounds) {
+  ReportOptions options = BoundedOptions({Aggregation::kMean});
+  options.has_bounds = false;
+  std::unique_ptr<GroupedReport> report = MakeReport(options);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(report->AddRow("a", 3, true).ok());
+  }
+  std::vector<ReportRow> rows = report->Results();
+  ASSERT_EQ(rows.size(), 1);
+  ASSERT_TRUE(rows[0].value.ok());
+  EXPECT_NEAR(rows[0].value.ValueOrDie(), 3, 1e-3);
+}
+
+}  // namespace
+}  // namespace report
+}  // namespace differential_privacy
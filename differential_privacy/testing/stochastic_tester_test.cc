@@ -45,12 +45,14 @@ class NonDpSum : public Algorithm<T> {
   NonDpSum() : Algorithm<T>(0), result_(0) {}
   void AddEntry(const T& t) override { result_ += t; }
 
-  base::StatusOr<Output> GenerateResult(double /*privacy_budget*/) override {
-    return MakeOutput<T>(result_);
+  base::Status GenerateResultTo(double /*privacy_budget*/,
+                                Output* output) override {
+    AddToOutput<T>(output, result_);
+    return base::OkStatus();
   }
   void ResetState() override { result_ = 0; }
 
-  Summary Serialize() override { return Summary(); }
+  void SerializeTo(Summary* /*summary*/) override {}
   base::Status Merge(const Summary& summary) override {
     return base::OkStatus();
   }
@@ -67,12 +69,14 @@ class NonDpCount : public Algorithm<T> {
   NonDpCount() : Algorithm<T>(0), result_(0) {}
   void AddEntry(const T& t) override { ++result_; }
 
-  base::StatusOr<Output> GenerateResult(double /*privacy_budget*/) override {
-    return MakeOutput<int64_t>(result_);
+  base::Status GenerateResultTo(double /*privacy_budget*/,
+                                Output* output) override {
+    AddToOutput<int64_t>(output, result_);
+    return base::OkStatus();
   }
   void ResetState() override { result_ = 0; }
 
-  Summary Serialize() override { return Summary(); }
+  void SerializeTo(Summary* /*summary*/) override {}
   base::Status Merge(const Summary& summary) override {
     return base::OkStatus();
   }
@@ -112,11 +116,12 @@ class BoundedSumWithError : public BoundedSum<T> {
                       nullptr),
         mechanism_(builder->Build().ValueOrDie()) {}
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
     if (mechanism_->GetUniformDouble() < 0.25) {
       return base::InvalidArgumentError("BoundedSumWithError returns error.");
     }
-    return BoundedSum<T>::GenerateResult(privacy_budget);
+    return BoundedSum<T>::GenerateResultTo(privacy_budget, output);
   }
 
  private:
@@ -133,11 +138,12 @@ class CountNoDpError : public Count<T> {
                               .Build()
                               .ValueOrDie()) {}
 
-  base::StatusOr<Output> GenerateResult(double privacy_budget) override {
+  base::Status GenerateResultTo(double privacy_budget,
+                                Output* output) override {
     if (Count<T>::count_ == 0) {
       return base::InvalidArgumentError("CountNoDpError returns error.");
     }
-    return Count<T>::GenerateResult(privacy_budget);
+    return Count<T>::GenerateResultTo(privacy_budget, output);
   }
 };
 
@@ -151,12 +157,13 @@ class AlwaysError : public Algorithm<T> {
   AlwaysError() : Algorithm<T>(0), result_(0) {}
   void AddEntry(const T& t) override {}
 
-  base::StatusOr<Output> GenerateResult(double /*privacy_budget*/) override {
+  base::Status GenerateResultTo(double /*privacy_budget*/,
+                                Output* /*output*/) override {
     return base::InvalidArgumentError("AlwaysError returns error.");
   }
   void ResetState() override {}
 
-  Summary Serialize() override { return Summary(); }
+  void SerializeTo(Summary* /*summary*/) override {}
   base::Status Merge(const Summary& summary) override {
     return base::OkStatus();
   }